@@ -106,6 +106,8 @@ double COCOA_GetTime(void);
 
 void COCOA_GetFrameBufferSize(COCOAwindow *window, int *width, int *height);
 void COCOA_SwapBuffers(COCOAwindow *window);
+/* Shows a top-down RGBA8 image of the framebuffer size, for renderers that draw on the CPU */
+void COCOA_PresentPixels(COCOAwindow *window, const void *pixels, int width, int height);
 
 COCOAwindow *COCOA_NewWindow(int width, int height, const char *title);
 void COCOA_DeleteWindow(COCOAwindow *window);
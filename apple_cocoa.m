@@ -244,6 +244,32 @@ void COCOA_SwapBuffers(COCOAwindow *handle)
   }
 }
 
+void COCOA_PresentPixels(COCOAwindow *handle, const void *pixels, int width, int height)
+{
+  COCOA_Window *window = (COCOA_Window *)handle;
+  assert(window);
+  assert(pixels);
+  @autoreleasepool
+  {
+    /* the layer keeps the image, so it gets its own copy of the pixels */
+    CFDataRef data = CFDataCreate(NULL, (const UInt8 *)pixels, (CFIndex)width * height * 4);
+    CGDataProviderRef provider = CGDataProviderCreateWithCFData(data);
+    CGColorSpaceRef space = CGColorSpaceCreateDeviceRGB();
+    CGImageRef image = CGImageCreate(width, height, 8, 32, (size_t)width * 4, space,
+                                     kCGImageAlphaNoneSkipLast | kCGBitmapByteOrderDefault,
+                                     provider, NULL, false, kCGRenderingIntentDefault);
+    CALayer *layer = [window->view layer];
+    [CATransaction begin];
+    [CATransaction setDisableActions:YES];
+    layer.contents = (id)image;
+    [CATransaction commit];
+    CGImageRelease(image);
+    CGColorSpaceRelease(space);
+    CGDataProviderRelease(provider);
+    CFRelease(data);
+  }
+}
+
 @interface COCOA_WindowDelegate : NSObject
 {
   COCOA_Window *window;
@@ -0,0 +1,1073 @@
+/* nuklear - 1.32.0 - public domain */
+#include <assert.h>
+#include <limits.h>
+#include <math.h>
+#include <stdarg.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#define NK_INCLUDE_FIXED_TYPES
+#define NK_INCLUDE_STANDARD_IO
+#define NK_INCLUDE_STANDARD_VARARGS
+#define NK_INCLUDE_DEFAULT_ALLOCATOR
+#define NK_INCLUDE_VERTEX_BUFFER_OUTPUT
+#define NK_INCLUDE_FONT_BAKING
+#define NK_INCLUDE_DEFAULT_FONT
+#define NK_IMPLEMENTATION
+#include "nuklear.h"
+#define NK_JOBS_IMPLEMENTATION
+#include "nuklear_jobs.h"
+#define NK_RASTER_IMPLEMENTATION
+#include "nuklear_raster.h"
+
+#include "calculator.c"
+#include "overview.c"
+
+/* ===============================================================
+ *
+ *                          BENCHMARK
+ *
+ * ===============================================================*/
+/* Measures the CPU side of rendering a demo frame without any window or GPU: the UI is built
+ * once and each section replays the resulting command queue. Build with
+ * -DNK_GENERIC_VERTEX_WRITER (bench_generic) to compare against the layout interpreter.
+ * Sections that compare two ways of producing the same output make the bench exit with 1 when
+ * they differ.
+ *
+ *   bench [iterations] [threads]
+ */
+
+#define BENCH_VERTEX_BUFFER 4 * 1024 * 1024
+#define BENCH_ELEMENT_BUFFER 1024 * 1024
+
+struct bench_vertex
+{
+  float position[2];
+  float uv[2];
+  nk_byte col[4];
+};
+
+#define BENCH_WINDOWS 8
+
+/* framebuffer the pixel checks rasterize into, large enough for every scene */
+#define BENCH_RASTER_WIDTH 1280
+#define BENCH_RASTER_HEIGHT 960
+
+enum bench_mode
+{
+  BENCH_SERIAL,          /* nk_convert */
+  BENCH_WINDOWS_CONVERT, /* nk_convert_windows, every unit converted again */
+  BENCH_WINDOWS_CACHED   /* nk_convert_windows, unchanged units reused */
+};
+
+struct bench
+{
+  struct nk_context ctx;
+  struct nk_font_atlas atlas;
+  struct nk_draw_null_texture null;
+  struct nk_raster_texture font_texture; /* the atlas, so scenes can be rasterized */
+  struct nk_convert_config config;
+  struct nk_buffer cmds;
+  struct nk_buffer vbuf, ebuf; /* the draw list keeps pointing at them after converting */
+  void *vertices;
+  void *elements;
+
+  struct nk_convert_state convert;
+  struct nk_job_pool *pool;
+};
+
+/* copy of a conversion result for comparing two conversion modes */
+struct bench_output
+{
+  void *vertices, *elements;
+  size_t vertices_size, elements_size;
+  struct nk_draw_command *commands;
+  int command_count;
+};
+
+static double bench_now(void)
+{
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (double)ts.tv_sec + (double)ts.tv_nsec * 1e-9;
+}
+
+/* equivalence checks that failed, the exit status of the bench */
+static int bench_failures;
+
+/* counts a failed check and returns the word describing the result */
+static const char *bench_check(int same, const char *yes, const char *no)
+{
+  bench_failures += !same;
+  return same ? yes : no;
+}
+
+static const char *bench_writer_name(enum nk_draw_vertex_writer writer)
+{
+  switch(writer)
+  {
+  case NK_VERTEX_WRITER_XY_UV_RGBA8_PACKED:
+    return "xy_uv_rgba8_packed";
+  case NK_VERTEX_WRITER_XY_UV_RGBA8:
+    return "xy_uv_rgba8";
+  case NK_VERTEX_WRITER_XY_UV_BGRA8:
+    return "xy_uv_bgra8";
+  case NK_VERTEX_WRITER_XY_UV_RGBA32F:
+    return "xy_uv_rgba32f";
+  default:
+    return "generic";
+  }
+}
+
+static void bench_dispatch(nk_handle scheduler, int count, nk_convert_job job, void *data)
+{
+  nk_job_pool_run((struct nk_job_pool *)scheduler.ptr, count, job, data);
+}
+
+static void bench_init(struct bench *b, int threads)
+{
+  static const struct nk_draw_vertex_layout_element vertex_layout[] = {
+      {NK_VERTEX_POSITION, NK_FORMAT_FLOAT, NK_OFFSETOF(struct bench_vertex, position)},
+      {NK_VERTEX_TEXCOORD, NK_FORMAT_FLOAT, NK_OFFSETOF(struct bench_vertex, uv)},
+      {NK_VERTEX_COLOR, NK_FORMAT_R8G8B8A8, NK_OFFSETOF(struct bench_vertex, col)},
+      {NK_VERTEX_LAYOUT_END}};
+  const void *image;
+  int w, h;
+
+  nk_font_atlas_init_default(&b->atlas);
+  nk_font_atlas_begin(&b->atlas);
+  image = nk_font_atlas_bake(&b->atlas, &w, &h, NK_FONT_ATLAS_RGBA32);
+  b->font_texture.pixels = (const nk_byte *)memcpy(malloc((size_t)w * (size_t)h * 4), image,
+                                                   (size_t)w * (size_t)h * 4);
+  b->font_texture.width = w;
+  b->font_texture.height = h;
+  nk_font_atlas_end(&b->atlas, nk_handle_ptr(&b->font_texture), &b->null);
+  nk_init_default(&b->ctx, &b->atlas.default_font->handle);
+
+  NK_MEMSET(&b->config, 0, sizeof(b->config));
+  b->config.vertex_layout = vertex_layout;
+  b->config.vertex_size = sizeof(struct bench_vertex);
+  b->config.vertex_alignment = NK_ALIGNOF(struct bench_vertex);
+  b->config.null = b->null;
+  b->config.circle_segment_count = 22;
+  b->config.curve_segment_count = 22;
+  b->config.arc_segment_count = 22;
+  b->config.global_alpha = 1.0f;
+  b->config.shape_AA = NK_ANTI_ALIASING_ON;
+  b->config.line_AA = NK_ANTI_ALIASING_ON;
+
+  nk_buffer_init_default(&b->cmds);
+  b->vertices = malloc(BENCH_VERTEX_BUFFER);
+  b->elements = malloc(BENCH_ELEMENT_BUFFER);
+
+  b->pool = nk_job_pool_create(threads);
+  nk_convert_state_init_default(&b->convert);
+  b->convert.dispatch = bench_dispatch;
+  b->convert.scheduler = nk_handle_ptr(b->pool);
+}
+
+static void bench_free(struct bench *b)
+{
+  nk_convert_state_free(&b->convert);
+  nk_job_pool_destroy(b->pool);
+  free(b->vertices);
+  free(b->elements);
+  nk_buffer_free(&b->cmds);
+  nk_free(&b->ctx);
+  nk_font_atlas_clear(&b->atlas);
+  free((void *)b->font_texture.pixels);
+}
+
+/* Equally heavy windows side by side, each one a long list of widgets */
+static void bench_windows(struct nk_context *ctx)
+{
+  static float values[BENCH_WINDOWS][32];
+  int i, j;
+  for(i = 0; i < BENCH_WINDOWS; ++i)
+  {
+    char name[32];
+    snprintf(name, sizeof(name), "Window %d", i);
+    if(nk_begin(ctx, name, nk_rect((float)(i % 4) * 300, (float)(i / 4) * 400, 300, 400),
+                NK_WINDOW_BORDER | NK_WINDOW_TITLE))
+    {
+      for(j = 0; j < 32; ++j)
+      {
+        values[i][j] = (float)((i * 7 + j * 3) % 10) / 10.0f;
+        nk_layout_row_dynamic(ctx, 20, 3);
+        nk_label(ctx, "label", NK_TEXT_LEFT);
+        nk_button_label(ctx, "button");
+        nk_slider_float(ctx, 0.0f, &values[i][j], 1.0f, 0.01f);
+      }
+    }
+    nk_end(ctx);
+  }
+}
+
+/* The same windows cascaded, each one covering most of the one below */
+static void bench_stacked(struct nk_context *ctx)
+{
+  static float values[BENCH_WINDOWS][32];
+  int i, j;
+  for(i = 0; i < BENCH_WINDOWS; ++i)
+  {
+    char name[32];
+    snprintf(name, sizeof(name), "Stacked %d", i);
+    if(nk_begin(ctx, name, nk_rect((float)i * 30, (float)i * 40, 500, 600),
+                NK_WINDOW_BORDER | NK_WINDOW_TITLE))
+    {
+      for(j = 0; j < 32; ++j)
+      {
+        values[i][j] = (float)((i * 7 + j * 3) % 10) / 10.0f;
+        nk_layout_row_dynamic(ctx, 20, 3);
+        nk_label(ctx, "label", NK_TEXT_LEFT);
+        nk_button_label(ctx, "button");
+        nk_slider_float(ctx, 0.0f, &values[i][j], 1.0f, 0.01f);
+      }
+    }
+    nk_end(ctx);
+  }
+}
+
+/* One window of long text lines, as in logs or text views */
+static void bench_text(struct nk_context *ctx)
+{
+  int i;
+  if(nk_begin(ctx, "Text", nk_rect(0, 0, 1200, 800), NK_WINDOW_BORDER | NK_WINDOW_TITLE))
+  {
+    for(i = 0; i < 48; ++i)
+    {
+      nk_layout_row_dynamic(ctx, 15, 1);
+      nk_labelf(ctx, NK_TEXT_LEFT,
+                "%04d The quick brown fox jumps over the lazy dog, then runs back again", i);
+    }
+  }
+  nk_end(ctx);
+}
+
+/* Drawing on a window canvas: tile rows, each one scissored, and a plot wider than the window */
+static void bench_canvas(struct nk_context *ctx)
+{
+  if(nk_begin(ctx, "Canvas", nk_rect(0, 0, 800, 600), NK_WINDOW_BORDER | NK_WINDOW_TITLE))
+  {
+    struct nk_command_buffer *canvas = nk_window_get_canvas(ctx);
+    struct nk_rect area = nk_window_get_content_region(ctx);
+    float x0 = area.x, y0 = area.y;
+    int x, y;
+    for(y = 0; y < 32; ++y)
+    {
+      nk_push_scissor(canvas, area);
+      for(x = 0; x < 48; ++x)
+      {
+        int shade = 40 + ((x / 6 + y / 2) % 4) * 30;
+        nk_fill_rect(canvas, nk_rect(x0 + (float)x * 16, y0 + (float)y * 16, 16, 16), 0,
+                     nk_rgb(shade, shade, shade + 20));
+      }
+    }
+    nk_push_scissor(canvas, area);
+    for(x = 0; x < 2000; ++x)
+    {
+      float ax = x0 + (float)x * 2, bx = ax + 2;
+      float ay = y0 + 300 + 120 * sinf((float)x * 0.05f);
+      float by = y0 + 300 + 120 * sinf((float)(x + 1) * 0.05f);
+      nk_stroke_line(canvas, ax, ay, bx, by, 1.5f, nk_rgb(255, 200, 40));
+    }
+  }
+  nk_end(ctx);
+}
+
+/* A node graph on a window canvas: nodes with pins, curves wiring them and a pie chart,
+ * where circles, arcs and curves make up most of the geometry */
+static void bench_curves(struct nk_context *ctx)
+{
+  if(nk_begin(ctx, "Curves", nk_rect(0, 0, 1200, 900), NK_WINDOW_BORDER | NK_WINDOW_TITLE))
+  {
+    struct nk_command_buffer *canvas = nk_window_get_canvas(ctx);
+    struct nk_rect area = nk_window_get_content_region(ctx);
+    float x0 = area.x, y0 = area.y;
+    int i, j;
+    for(i = 0; i < 48; ++i)
+    {
+      float x = x0 + (float)(i % 8) * 110 + 20, y = y0 + (float)(i / 8) * 130 + 20;
+      nk_fill_rect(canvas, nk_rect(x, y, 70, 90), 8, nk_rgb(60, 60, 70));
+      for(j = 0; j < 4; ++j)
+      {
+        nk_fill_circle(canvas, nk_rect(x - 5, y + 15 + (float)j * 20, 10, 10), nk_rgb(90, 200, 90));
+        nk_stroke_circle(canvas, nk_rect(x + 65, y + 15 + (float)j * 20, 10, 10), 1.5f,
+                         nk_rgb(200, 200, 90));
+      }
+      if(i % 8 != 7)
+        for(j = 0; j < 4; ++j)
+        {
+          float ax = x + 75, ay = y + 20 + (float)j * 20;
+          float bx = x + 105, by = y + 20 + (float)((j + i) % 4) * 20;
+          nk_stroke_curve(canvas, ax, ay, ax + 30, ay, bx - 30, by, bx, by, 2.0f,
+                          nk_rgb(220, 140, 60));
+        }
+    }
+    for(i = 0; i < 12; ++i)
+    {
+      float a = (float)i * NK_PI / 6.0f;
+      nk_fill_arc(canvas, x0 + 1000, y0 + 200, 140, a, a + NK_PI / 6.0f,
+                  nk_rgb(40 + i * 16, 100, 220 - i * 12));
+      nk_stroke_arc(canvas, x0 + 1000, y0 + 560, 60 + (float)i * 8, a, a + NK_PI, 2.0f,
+                    nk_rgb(200, 80 + i * 12, 80));
+    }
+  }
+  nk_end(ctx);
+}
+
+/* Thumbnails with captions: every widget switches between an image and the font atlas */
+static void bench_images(struct nk_context *ctx)
+{
+  static const nk_byte pixel[4] = {200, 120, 40, 255};
+  static const struct nk_raster_texture thumbnail = {pixel, 1, 1};
+  int i;
+  if(nk_begin(ctx, "Images", nk_rect(0, 0, 820, 480), NK_WINDOW_BORDER | NK_WINDOW_TITLE))
+  {
+    for(i = 0; i < 6; ++i)
+    {
+      int j;
+      nk_layout_row_static(ctx, 48, 58, 12);
+      for(j = 0; j < 6; ++j)
+      {
+        nk_image(ctx, nk_image_ptr((void *)&thumbnail));
+        nk_labelf(ctx, NK_TEXT_LEFT, "img %d", i * 6 + j);
+      }
+    }
+  }
+  nk_end(ctx);
+}
+
+/* Builds a scene, a few frames so layouts and animations have settled */
+static void bench_build(struct bench *b, void (*scene)(struct nk_context *))
+{
+  int frame;
+  for(frame = 0; frame < 3; ++frame)
+  {
+    nk_clear(&b->ctx);
+    nk_input_begin(&b->ctx);
+    nk_input_motion(&b->ctx, 600, 400);
+    nk_input_end(&b->ctx);
+    scene(&b->ctx);
+  }
+}
+
+static void bench_demo(struct nk_context *ctx)
+{
+  calculator(ctx);
+  overview(ctx);
+}
+
+static nk_flags bench_convert_once(struct bench *b, enum bench_mode mode)
+{
+  nk_buffer_clear(&b->cmds);
+  nk_buffer_init_fixed(&b->vbuf, b->vertices, BENCH_VERTEX_BUFFER);
+  nk_buffer_init_fixed(&b->ebuf, b->elements, BENCH_ELEMENT_BUFFER);
+  if(mode == BENCH_SERIAL)
+    return nk_convert(&b->ctx, &b->cmds, &b->vbuf, &b->ebuf, &b->config);
+  if(mode == BENCH_WINDOWS_CONVERT)
+    nk_convert_state_invalidate(&b->convert);
+  return nk_convert_windows(&b->ctx, &b->convert, &b->cmds, &b->vbuf, &b->ebuf, &b->config);
+}
+
+/* microseconds per conversion */
+static double bench_convert(struct bench *b, enum bench_mode mode, int iterations)
+{
+  double start;
+  int i;
+  if(bench_convert_once(b, mode) != NK_CONVERT_SUCCESS)
+  {
+    fprintf(stderr, "nk_convert: buffers too small\n");
+    exit(1);
+  }
+  start = bench_now();
+  for(i = 0; i < iterations; ++i)
+    bench_convert_once(b, mode);
+  return (bench_now() - start) * 1e6 / iterations;
+}
+
+static void bench_capture(struct bench *b, struct bench_output *out)
+{
+  const struct nk_draw_command *cmd;
+  out->vertices_size = b->ctx.draw_list.vertex_count * sizeof(struct bench_vertex);
+  out->elements_size = b->ctx.draw_list.element_count * sizeof(nk_draw_index);
+  out->vertices = malloc(out->vertices_size);
+  out->elements = malloc(out->elements_size);
+  memcpy(out->vertices, b->vertices, out->vertices_size);
+  memcpy(out->elements, b->elements, out->elements_size);
+
+  /* only what gets drawn: non empty commands, neighbours with equal state merged */
+  out->commands = (struct nk_draw_command *)malloc(b->ctx.draw_list.cmd_count * sizeof(*cmd));
+  out->command_count = 0;
+  nk_draw_foreach(cmd, &b->ctx, &b->cmds)
+  {
+    struct nk_draw_command *prev = out->command_count ? &out->commands[out->command_count - 1] : 0;
+    if(!cmd->elem_count)
+      continue;
+    if(prev && prev->texture.id == cmd->texture.id &&
+       !memcmp(&prev->clip_rect, &cmd->clip_rect, sizeof(struct nk_rect)))
+      prev->elem_count += cmd->elem_count;
+    else
+      out->commands[out->command_count++] = *cmd;
+  }
+}
+
+static int bench_same_output(const struct bench_output *a, const struct bench_output *b)
+{
+  int i;
+  if(a->vertices_size != b->vertices_size || a->elements_size != b->elements_size ||
+     a->command_count != b->command_count)
+    return 0;
+  if(memcmp(a->vertices, b->vertices, a->vertices_size) ||
+     memcmp(a->elements, b->elements, a->elements_size))
+    return 0;
+  for(i = 0; i < a->command_count; ++i)
+  {
+    if(a->commands[i].elem_count != b->commands[i].elem_count ||
+       a->commands[i].texture.id != b->commands[i].texture.id ||
+       memcmp(&a->commands[i].clip_rect, &b->commands[i].clip_rect, sizeof(struct nk_rect)))
+      return 0;
+  }
+  return 1;
+}
+
+static void bench_output_free(struct bench_output *out)
+{
+  free(out->vertices);
+  free(out->elements);
+  free(out->commands);
+}
+
+/* vertices of every triangle drawn, with runs of quads and quad instances expanded */
+static struct bench_vertex *bench_triangles(struct bench *b, const void *element_buffer,
+                                           unsigned int *count, int *commands)
+{
+  static const unsigned int quad[6] = {0, 1, 2, 0, 2, 3};
+  const struct nk_draw_command *cmd;
+  const struct bench_vertex *vertices = (const struct bench_vertex *)b->vertices;
+  const nk_draw_index *elements = (const nk_draw_index *)element_buffer;
+  const size_t slots = NK_DRAW_QUAD_INSTANCE_SLOTS(sizeof(struct bench_vertex));
+  struct bench_vertex *out;
+  unsigned int n = 0, i;
+
+  *count = 0;
+  *commands = 0;
+  nk_draw_foreach(cmd, &b->ctx, &b->cmds)
+  {
+    *count += cmd->elem_count;
+    *commands += cmd->elem_count != 0;
+  }
+  out = (struct bench_vertex *)malloc((*count + 1) * sizeof(struct bench_vertex));
+  nk_draw_foreach(cmd, &b->ctx, &b->cmds)
+  {
+    for(i = 0; i < cmd->elem_count; ++i)
+    {
+      struct bench_vertex *v = &out[n++];
+      if(cmd->instances)
+      {
+        struct nk_draw_quad_instance q;
+        unsigned int corner = quad[i % 6];
+        memcpy(&q, &vertices[cmd->vertex_offset + i / 6 * slots], sizeof(q));
+        v->position[0] = corner == 1 || corner == 2 ? q.c.x : q.a.x;
+        v->position[1] = corner >= 2 ? q.c.y : q.a.y;
+        v->uv[0] = corner == 1 || corner == 2 ? q.uvc.x : q.uva.x;
+        v->uv[1] = corner >= 2 ? q.uvc.y : q.uva.y;
+        memcpy(v->col, &q.col, sizeof(v->col));
+      }
+      else
+        *v = vertices[cmd->vertex_offset + (cmd->quads ? i / 6 * 4 + quad[i % 6] : elements[i])];
+    }
+    if(!cmd->quads && !cmd->instances)
+      elements += cmd->elem_count;
+  }
+  return out;
+}
+
+/* runs of quads drawn with shared quad elements or as instances against writing all of them */
+static void bench_quads(struct bench *b, int iterations)
+{
+  struct bench_vertex *triangles, *quad_triangles;
+  unsigned int count, quad_count;
+  size_t bytes;
+  int commands, quad_commands, same;
+  double quad_us;
+
+  bench_convert_once(b, BENCH_SERIAL);
+  triangles = bench_triangles(b, b->elements, &count, &commands);
+  bytes = b->ctx.draw_list.vertex_count * sizeof(struct bench_vertex) +
+          b->ctx.draw_list.element_count * sizeof(nk_draw_index);
+
+  b->config.quad_batch = 16384;
+  quad_us = bench_convert(b, BENCH_SERIAL, iterations);
+  quad_triangles = bench_triangles(b, b->elements, &quad_count, &quad_commands);
+  same = count == quad_count && !memcmp(triangles, quad_triangles, count * sizeof(*triangles));
+  printf("  shared quads:       %8.1f us/frame (%u of %u indices written, %d draw commands "
+         "instead of %d, %s)\n",
+         quad_us, b->ctx.draw_list.element_count, count, quad_commands, commands,
+         bench_check(same, "same triangles", "TRIANGLES DIFFER"));
+  b->config.quad_batch = 0;
+  free(quad_triangles);
+
+  b->config.quad_instances = nk_true;
+  quad_us = bench_convert(b, BENCH_SERIAL, iterations);
+  quad_triangles = bench_triangles(b, b->elements, &quad_count, &quad_commands);
+  same = count == quad_count && !memcmp(triangles, quad_triangles, count * sizeof(*triangles));
+  printf("  quad instances:     %8.1f us/frame (%lu of %lu bytes written, %d draw commands "
+         "instead of %d, %s)\n",
+         quad_us,
+         (unsigned long)(b->ctx.draw_list.vertex_count * sizeof(struct bench_vertex) +
+                         b->ctx.draw_list.element_count * sizeof(nk_draw_index)),
+         (unsigned long)bytes, quad_commands, commands,
+         bench_check(same, "same triangles", "TRIANGLES DIFFER"));
+  b->config.quad_instances = nk_false;
+  free(triangles);
+  free(quad_triangles);
+}
+
+static int bench_triangle_compare(const void *a, const void *b)
+{
+  return memcmp(a, b, 3 * sizeof(struct bench_vertex));
+}
+
+/* draw commands joined by nk_draw_merge with the configuration of the OpenGL backend */
+static void bench_merge(struct bench *b, int iterations)
+{
+  struct bench_vertex *triangles, *merged_triangles;
+  struct nk_draw_merge merge;
+  struct nk_buffer ebuf;
+  void *elements = malloc(BENCH_ELEMENT_BUFFER);
+  unsigned int count, merged_count;
+  int commands, merged_commands, same, i;
+  double start, merge_us = 0;
+
+  b->config.quad_batch = 16384;
+  b->config.quad_instances = nk_true;
+  nk_draw_merge_init_default(&merge);
+  bench_convert_once(b, BENCH_SERIAL);
+  triangles = bench_triangles(b, b->elements, &count, &commands);
+
+  /* merging rewrites the commands, every iteration needs a fresh conversion */
+  for(i = 0; i < iterations; ++i)
+  {
+    bench_convert_once(b, BENCH_SERIAL);
+    nk_buffer_init_fixed(&ebuf, elements, BENCH_ELEMENT_BUFFER);
+    start = bench_now();
+    nk_draw_merge(&merge, &b->ctx, &ebuf);
+    merge_us += bench_now() - start;
+  }
+  merge_us = merge_us * 1e6 / iterations;
+  merged_triangles = bench_triangles(b, elements, &merged_count, &merged_commands);
+
+  /* commands move past others they do not overlap, so only the set of triangles is kept */
+  qsort(triangles, count / 3, 3 * sizeof(*triangles), bench_triangle_compare);
+  qsort(merged_triangles, merged_count / 3, 3 * sizeof(*triangles), bench_triangle_compare);
+  same = count == merged_count && !memcmp(triangles, merged_triangles, count * sizeof(*triangles));
+  printf("  merged commands:    %8.1f us/frame (%d of %d draw commands left, %s)\n", merge_us,
+         merge.draws_after, merge.draws_before, bench_check(same, "same triangles", "TRIANGLES DIFFER"));
+  b->config.quad_batch = 0;
+  b->config.quad_instances = nk_false;
+  nk_draw_merge_free(&merge);
+  free(elements);
+  free(triangles);
+  free(merged_triangles);
+}
+
+/* converts the command queue and rasterizes it, the way the software backend draws a frame,
+ * or rasterizes the commands themselves like NK_COCOA_RASTER_DIRECT */
+static void bench_rasterize(struct bench *b, nk_byte *pixels, int direct)
+{
+  const struct nk_draw_command *cmd;
+  const nk_draw_index *elements = (const nk_draw_index *)b->elements;
+  struct nk_raster_target target;
+  target.pixels = pixels;
+  target.width = BENCH_RASTER_WIDTH;
+  target.height = BENCH_RASTER_HEIGHT;
+  target.pitch = BENCH_RASTER_WIDTH * 4;
+  nk_raster_clear(&target, nk_rgb(30, 30, 30));
+  if(direct)
+  {
+    nk_raster_commands(&target, &b->ctx, nk_vec2(1, 1), NK_ANTI_ALIASING_ON);
+    return;
+  }
+  bench_convert_once(b, BENCH_SERIAL);
+  nk_draw_foreach(cmd, &b->ctx, &b->cmds)
+  {
+    nk_raster_draw(&target, cmd, (const struct nk_raster_vertex *)b->vertices, elements,
+                   nk_vec2(1, 1));
+    elements += cmd->elem_count;
+  }
+}
+
+static void bench_optimize(struct bench *b, int iterations)
+{
+  struct nk_optimize_stats stats;
+  nk_size size;
+  void *queue;
+  unsigned int vertices, elements;
+  int commands = 0, removed = 0, occluded = 0, same, same_direct, i;
+  double start, optimize_us = 0, convert_us;
+  const size_t pixel_size = (size_t)BENCH_RASTER_WIDTH * BENCH_RASTER_HEIGHT * 4;
+  nk_byte *pixels = (nk_byte *)malloc(pixel_size);
+  nk_byte *optimized_pixels = (nk_byte *)malloc(pixel_size);
+
+  /* optimizing unlinks commands, every iteration starts from a copy of the queue */
+  nk__begin(&b->ctx);
+  size = b->ctx.memory.allocated;
+  queue = malloc(size);
+  memcpy(queue, b->ctx.memory.memory.ptr, size);
+  for(i = 0; i < iterations; ++i)
+  {
+    memcpy(b->ctx.memory.memory.ptr, queue, size);
+    start = bench_now();
+    nk_optimize_commands(&b->ctx, &stats);
+    optimize_us += bench_now() - start;
+  }
+  optimize_us = optimize_us * 1e6 / iterations;
+  convert_us = bench_convert(b, BENCH_SERIAL, iterations);
+  vertices = b->ctx.draw_list.vertex_count;
+  elements = b->ctx.draw_list.element_count;
+
+  /* the optimized queue has to draw exactly the pixels of the original one, hidden commands
+   * included, through both software renderers */
+  bench_rasterize(b, optimized_pixels, nk_false);
+  memcpy(b->ctx.memory.memory.ptr, queue, size);
+  bench_rasterize(b, pixels, nk_false);
+  same = !memcmp(pixels, optimized_pixels, pixel_size);
+  bench_rasterize(b, pixels, nk_true);
+  nk_optimize_commands(&b->ctx, &stats);
+  bench_rasterize(b, optimized_pixels, nk_true);
+  memcpy(b->ctx.memory.memory.ptr, queue, size);
+  same_direct = !memcmp(pixels, optimized_pixels, pixel_size);
+  free(queue);
+  free(pixels);
+  free(optimized_pixels);
+
+  for(i = 0; i < NK_COMMAND_TYPE_COUNT; ++i)
+  {
+    commands += stats.commands[i];
+    removed += stats.removed[i];
+    occluded += stats.occluded[i];
+  }
+  printf("  optimized commands: %8.1f us/frame (%d of %d commands removed, %d of them hidden, "
+         "then nk_convert %.1f us/frame, %u vertices, %u indices, %s, %s)\n",
+         optimize_us, removed, commands, occluded, convert_us, vertices, elements,
+         bench_check(same, "same pixels", "PIXELS DIFFER"),
+         bench_check(same_direct, "same pixels rasterized directly", "DIRECT PIXELS DIFFER"));
+  for(i = 0; i < NK_COMMAND_TYPE_COUNT; ++i)
+    if(stats.removed[i])
+      printf("    %-16s %6d of %6d removed, %6d hidden\n",
+             nk_command_type_name((enum nk_command_type)i), stats.removed[i], stats.commands[i],
+             stats.occluded[i]);
+}
+
+/* nk_convert with segment counts picked against a pixel error, at 1x and 2x. At 1x the
+ * rasterized frame is compared against the one drawn with all segments */
+static void bench_segments(struct bench *b, int iterations)
+{
+  static const float scales[] = {1.0f, 2.0f};
+  const size_t pixel_size = (size_t)BENCH_RASTER_WIDTH * BENCH_RASTER_HEIGHT * 4;
+  nk_byte *pixels = (nk_byte *)malloc(pixel_size);
+  nk_byte *adaptive_pixels = (nk_byte *)malloc(pixel_size);
+  unsigned int i;
+
+  bench_rasterize(b, pixels, nk_false);
+  for(i = 0; i < sizeof(scales) / sizeof(scales[0]); ++i)
+  {
+    double convert_us;
+    b->config.segment_error = 0.25f;
+    b->config.pixel_scale = scales[i];
+    convert_us = bench_convert(b, BENCH_SERIAL, iterations);
+    printf("  adaptive segments:  %8.1f us/frame (%.0fx scale, %u vertices, %u indices", convert_us,
+           scales[i], b->ctx.draw_list.vertex_count, b->ctx.draw_list.element_count);
+    if(scales[i] == 1.0f)
+    {
+      size_t j, changed = 0;
+      int largest = 0;
+      bench_rasterize(b, adaptive_pixels, nk_false);
+      for(j = 0; j < pixel_size; ++j)
+      {
+        int d = abs((int)pixels[j] - (int)adaptive_pixels[j]);
+        changed += d > 0;
+        largest = NK_MAX(largest, d);
+      }
+      printf(", %zu channels off by at most %d", changed, largest);
+    }
+    printf(")\n");
+  }
+  b->config.segment_error = 0;
+  b->config.pixel_scale = 0;
+  free(pixels);
+  free(adaptive_pixels);
+}
+
+#define BENCH_SHAPES 1000
+
+/* nanoseconds per shape for one way of building its path or geometry */
+enum bench_shape
+{
+  BENCH_CIRCLE_ROTATED, /* nk_draw_list_path_arc_to, rotating point by point */
+  BENCH_CIRCLE_TABLE,   /* unit circle table of the draw list */
+  BENCH_CORNERS,        /* nk_draw_list_path_arc_to_fast for each corner */
+  BENCH_CORNER_FAN,     /* nk_draw_list_path_rect_to, one scaled fan for all corners */
+  BENCH_FILL_CIRCLE,
+  BENCH_FILL_ROUNDED_RECT
+};
+
+static double bench_shape(struct bench *b, struct nk_draw_list *list, enum bench_shape shape,
+                          int iterations)
+{
+  const unsigned int segments = 22;
+  const float a_max = NK_PI * 2.0f * ((float)segments - 1.0f) / (float)segments;
+  double start, total = 0;
+  int i, j;
+  for(i = 0; i < iterations; ++i)
+  {
+    nk_buffer_clear(&b->cmds);
+    nk_buffer_init_fixed(&b->vbuf, b->vertices, BENCH_VERTEX_BUFFER);
+    nk_buffer_init_fixed(&b->ebuf, b->elements, BENCH_ELEMENT_BUFFER);
+    nk_draw_list_setup(list, &b->config, &b->cmds, &b->vbuf, &b->ebuf, NK_ANTI_ALIASING_ON,
+                       NK_ANTI_ALIASING_ON);
+    start = bench_now();
+    for(j = 0; j < BENCH_SHAPES; ++j)
+    {
+      struct nk_vec2 c = nk_vec2((float)(j % 40) * 20 + 10, (float)(j / 40) * 20 + 10);
+      struct nk_vec2 a = nk_vec2(c.x - 8, c.y - 6), e = nk_vec2(c.x + 8, c.y + 6);
+      switch(shape)
+      {
+      case BENCH_CIRCLE_ROTATED:
+        nk_draw_list_path_arc_to(list, c, 8, 0.0f, a_max, segments);
+        nk_draw_list_path_clear(list);
+        break;
+      case BENCH_CIRCLE_TABLE:
+        nk_draw_list_path_circle(list, c, 8, segments);
+        nk_draw_list_path_clear(list);
+        break;
+      case BENCH_CORNERS:
+        nk_draw_list_path_arc_to_fast(list, nk_vec2(a.x + 4, a.y + 4), 4, 6, 9);
+        nk_draw_list_path_arc_to_fast(list, nk_vec2(e.x - 4, a.y + 4), 4, 9, 12);
+        nk_draw_list_path_arc_to_fast(list, nk_vec2(e.x - 4, e.y - 4), 4, 0, 3);
+        nk_draw_list_path_arc_to_fast(list, nk_vec2(a.x + 4, e.y - 4), 4, 3, 6);
+        nk_draw_list_path_clear(list);
+        break;
+      case BENCH_CORNER_FAN:
+        nk_draw_list_path_rect_to(list, a, e, 4);
+        nk_draw_list_path_clear(list);
+        break;
+      case BENCH_FILL_CIRCLE:
+        nk_draw_list_fill_circle(list, c, 8, nk_rgb(200, 80, 40), segments);
+        break;
+      case BENCH_FILL_ROUNDED_RECT:
+        nk_draw_list_fill_rect(list, nk_rect(a.x, a.y, 16, 12), nk_rgb(40, 80, 200), 4);
+        break;
+      }
+    }
+    total += bench_now() - start;
+  }
+  return total * 1e9 / ((double)iterations * BENCH_SHAPES);
+}
+
+/* Circles and rounded rects built straight on a draw list */
+static void bench_shapes(struct bench *b, int iterations)
+{
+  static struct nk_draw_list list;
+  nk_draw_list_init(&list);
+  printf("shapes: %d per pass, 22 segments per circle\n", BENCH_SHAPES);
+  printf("  circle path:        %8.1f ns rotated, %.1f ns from the table\n",
+         bench_shape(b, &list, BENCH_CIRCLE_ROTATED, iterations),
+         bench_shape(b, &list, BENCH_CIRCLE_TABLE, iterations));
+  printf("  rounded rect path:  %8.1f ns corner by corner, %.1f ns with one fan\n",
+         bench_shape(b, &list, BENCH_CORNERS, iterations),
+         bench_shape(b, &list, BENCH_CORNER_FAN, iterations));
+  printf("  filled circle:      %8.1f ns, rounded rect %.1f ns (anti-aliased)\n",
+         bench_shape(b, &list, BENCH_FILL_CIRCLE, iterations),
+         bench_shape(b, &list, BENCH_FILL_ROUNDED_RECT, iterations));
+}
+
+/* nk_convert against nk_convert_windows on the current scene */
+static void bench_convert_modes(struct bench *b, const char *scene, int iterations)
+{
+  struct bench_output serial, windows, cached;
+  double serial_us, windows_us, cached_us;
+
+  serial_us = bench_convert(b, BENCH_SERIAL, iterations);
+  bench_capture(b, &serial);
+  printf("%s: %u vertices, %u indices, %d windows\n", scene, b->ctx.draw_list.vertex_count,
+         b->ctx.draw_list.element_count, b->ctx.count);
+  printf("  nk_convert:         %8.1f us/frame (%s vertex writer)\n", serial_us,
+         bench_writer_name(b->ctx.draw_list.vertex_writer));
+
+  windows_us = bench_convert(b, BENCH_WINDOWS_CONVERT, iterations);
+  bench_capture(b, &windows);
+  printf("  nk_convert_windows: %8.1f us/frame (%d units, %d threads, %s)\n", windows_us,
+         b->convert.unit_count, nk_job_pool_size(b->pool),
+         bench_check(bench_same_output(&serial, &windows), "same output", "OUTPUT DIFFERS"));
+
+  cached_us = bench_convert(b, BENCH_WINDOWS_CACHED, iterations);
+  bench_capture(b, &cached);
+  printf("  cached:             %8.1f us/frame (%d of %d units reused, %s)\n", cached_us,
+         b->convert.units_reused, b->convert.unit_count,
+         bench_check(bench_same_output(&serial, &cached), "same output", "OUTPUT DIFFERS"));
+
+  bench_quads(b, iterations);
+  bench_merge(b, iterations);
+  bench_optimize(b, iterations);
+  bench_segments(b, iterations);
+
+  bench_output_free(&serial);
+  bench_output_free(&windows);
+  bench_output_free(&cached);
+}
+
+/* microseconds per frame of building a scene, the nk_convert side is left out */
+static double bench_layout_frames(struct bench *b, void (*scene)(struct nk_context *), int iterations)
+{
+  double start;
+  int i;
+  bench_build(b, scene);
+  start = bench_now();
+  for(i = 0; i < iterations; ++i)
+  {
+    nk_clear(&b->ctx);
+    nk_input_begin(&b->ctx);
+    nk_input_motion(&b->ctx, 600, 400);
+    nk_input_end(&b->ctx);
+    scene(&b->ctx);
+  }
+  return (bench_now() - start) * 1e6 / iterations;
+}
+
+/* scene layout measuring text through the font against through a nk_text_width_cache */
+static void bench_layout(struct bench *b, const char *name, void (*scene)(struct nk_context *),
+                         int iterations)
+{
+  struct nk_text_width_cache cache;
+  struct nk_cached_font cached;
+  double plain_us, cached_us;
+
+  plain_us = bench_layout_frames(b, scene, iterations);
+  nk_text_width_cache_init_default(&cache, 1024);
+  nk_cached_font_init(&cached, &b->atlas.default_font->handle, &cache);
+  nk_style_set_font(&b->ctx, &cached.handle);
+  cached_us = bench_layout_frames(b, scene, iterations);
+  nk_style_set_font(&b->ctx, &b->atlas.default_font->handle);
+
+  printf("layout %s: %8.1f us/frame, %.1f us/frame with the text width cache "
+         "(%u hits, %u misses, %u evictions)\n",
+         name, plain_us, cached_us, cache.hits, cache.misses, cache.evictions);
+  nk_text_width_cache_free(&cache);
+}
+
+/* the default font with the Cyrillic, Korean and Chinese ranges merged in */
+static struct nk_font *bench_glyph_font(struct nk_font_atlas *atlas)
+{
+  struct nk_font_config config = nk_font_config(13.0f);
+  struct nk_font *font;
+  nk_font_atlas_init_default(atlas);
+  nk_font_atlas_begin(atlas);
+  font = nk_font_atlas_add_default(atlas, 13.0f, 0);
+  config.merge_mode = nk_true;
+  config.range = nk_font_cyrillic_glyph_ranges();
+  nk_font_atlas_add_default(atlas, 13.0f, &config);
+  config.range = nk_font_korean_glyph_ranges();
+  nk_font_atlas_add_default(atlas, 13.0f, &config);
+  config.range = nk_font_chinese_glyph_ranges();
+  nk_font_atlas_add_default(atlas, 13.0f, &config);
+  return font;
+}
+
+/* nk_font_text_width over mixed scripts with the glyph lookup table and with the linear range walk
+ * it replaces, then the same font baked up front against rasterized on demand */
+static void bench_glyphs(int iterations)
+{
+  static const nk_rune scripts[][2] = {{0x20, 0x7e}, {0x410, 0x44f}, {0xac00, 0xd7a3}, {0x4e00, 0x9faf}};
+  struct nk_font_atlas atlas;
+  struct nk_font *font;
+  char text[4096];
+  nk_uint *lookup;
+  double start, table_ns, linear_ns, bake_ms, dynamic_ms, load_us;
+  int len = 0, runes = 0, i, w, h;
+  float width = 0;
+  struct nk_recti dirty;
+
+  font = bench_glyph_font(&atlas);
+  start = bench_now();
+  nk_font_atlas_bake(&atlas, &w, &h, NK_FONT_ATLAS_RGBA32);
+  bake_ms = (bench_now() - start) * 1e3;
+  nk_font_atlas_end(&atlas, nk_handle_id(1), 0);
+
+  for(i = 0; len < (int)sizeof(text) - NK_UTF_SIZE; ++i, ++runes)
+  {
+    const nk_rune *s = scripts[i % 4];
+    len += nk_utf_encode(s[0] + (nk_rune)(i * 7919) % (s[1] - s[0] + 1), text + len, NK_UTF_SIZE);
+  }
+
+  lookup = font->lookup;
+  start = bench_now();
+  for(i = 0; i < iterations; ++i)
+    width += nk_font_text_width(nk_handle_ptr(font), 13.0f, text, len);
+  table_ns = (bench_now() - start) * 1e9 / ((double)iterations * runes);
+  font->lookup = 0;
+  start = bench_now();
+  for(i = 0; i < iterations; ++i)
+    width -= nk_font_text_width(nk_handle_ptr(font), 13.0f, text, len);
+  linear_ns = (bench_now() - start) * 1e9 / ((double)iterations * runes);
+  font->lookup = lookup;
+
+  printf("glyphs: %d baked, %d codepoints per string\n", atlas.glyph_count, runes);
+  printf("  nk_font_text_width: %8.1f ns/codepoint with the lookup table, %.1f ns walking ranges "
+         "(%s)\n", table_ns, linear_ns, bench_check(width == 0, "same width", "WIDTH DIFFERS"));
+  printf("  baked up front:     %8.1f ms, %dx%d RGBA texture\n", bake_ms, w, h);
+  nk_font_atlas_clear(&atlas);
+
+  /* rasterize the glyphs of the string only, as the first frame showing it would */
+  font = bench_glyph_font(&atlas);
+  start = bench_now();
+  nk_font_atlas_bake_dynamic(&atlas, 1024, 1024, NK_FONT_ATLAS_RGBA32);
+  dynamic_ms = (bench_now() - start) * 1e3;
+  nk_font_atlas_end(&atlas, nk_handle_id(1), 0);
+  start = bench_now();
+  for(i = 0; i < len;)
+  {
+    struct nk_user_font_glyph glyph;
+    nk_rune unicode;
+    i += nk_utf_decode(text + i, &unicode, len - i);
+    font->handle.query(font->handle.userdata, 13.0f, &glyph, unicode, 0);
+  }
+  load_us = (bench_now() - start) * 1e6;
+  nk_font_atlas_dirty(&atlas, &dirty);
+  printf("  baked on demand:    %8.1f ms, 1024x1024 RGBA texture, %.1f us rasterizing the string "
+         "(%dx%d texels to upload)\n", dynamic_ms, load_us, dirty.w, dirty.h);
+  nk_font_atlas_clear(&atlas);
+}
+
+/* the glyph font baked on the calling thread against rasterized by the job pool */
+static void bench_bake(struct bench *b)
+{
+  struct nk_font_atlas atlas;
+  double start, serial_ms, pooled_ms;
+  void *pixels;
+  struct nk_font_glyph *glyphs;
+  size_t pixel_size, glyph_size;
+  int w, h, same;
+
+  bench_glyph_font(&atlas);
+  start = bench_now();
+  nk_font_atlas_bake(&atlas, &w, &h, NK_FONT_ATLAS_ALPHA8);
+  serial_ms = (bench_now() - start) * 1e3;
+  pixel_size = (size_t)w * (size_t)h;
+  glyph_size = sizeof(struct nk_font_glyph) * (size_t)atlas.glyph_count;
+  pixels = malloc(pixel_size);
+  glyphs = (struct nk_font_glyph *)malloc(glyph_size);
+  memcpy(pixels, atlas.pixel, pixel_size);
+  memcpy(glyphs, atlas.glyphs, glyph_size);
+  nk_font_atlas_end(&atlas, nk_handle_id(1), 0);
+  nk_font_atlas_clear(&atlas);
+
+  bench_glyph_font(&atlas);
+  atlas.dispatch = bench_dispatch;
+  atlas.scheduler = nk_handle_ptr(b->pool);
+  start = bench_now();
+  nk_font_atlas_bake(&atlas, &w, &h, NK_FONT_ATLAS_ALPHA8);
+  pooled_ms = (bench_now() - start) * 1e3;
+  same = (size_t)w * (size_t)h == pixel_size && !memcmp(pixels, atlas.pixel, pixel_size) &&
+         !memcmp(glyphs, atlas.glyphs, glyph_size);
+  nk_font_atlas_end(&atlas, nk_handle_id(1), 0);
+  nk_font_atlas_clear(&atlas);
+
+  printf("  nk_font_atlas_bake: %8.1f ms on the calling thread, %.1f ms on %d workers (%s)\n",
+         serial_ms, pooled_ms, nk_job_pool_size(b->pool), bench_check(same, "same image", "IMAGE DIFFERS"));
+  free(pixels);
+  free(glyphs);
+}
+
+/* the glyph font baked against loaded from a saved atlas, and the saved atlas offered to other fonts */
+static void bench_atlas_cache(void)
+{
+  struct nk_font_atlas atlas;
+  struct nk_font_config config = nk_font_config(14.0f);
+  struct nk_font *font;
+  double start, bake_ms, load_ms;
+  void *saved;
+  nk_size size;
+  int w, h, same, rejected;
+  const void *image;
+
+  bench_glyph_font(&atlas);
+  start = bench_now();
+  nk_font_atlas_bake(&atlas, &w, &h, NK_FONT_ATLAS_RGBA32);
+  bake_ms = (bench_now() - start) * 1e3;
+  size = nk_font_atlas_save(&atlas, NK_FONT_ATLAS_RGBA32, 0, 0);
+  saved = malloc(size);
+  nk_font_atlas_save(&atlas, NK_FONT_ATLAS_RGBA32, saved, size);
+  nk_font_atlas_end(&atlas, nk_handle_id(1), 0);
+  font = atlas.fonts;
+
+  /* loaded fonts have to lay out text exactly like the baked ones */
+  {
+    struct nk_font_atlas loaded;
+    struct nk_font *loaded_font;
+    static const char text[] = "Nuklear \xd0\x9f\xd1\x80\xd0\xb8 \xea\xb0\x80 \xe4\xb8\xad";
+    bench_glyph_font(&loaded);
+    start = bench_now();
+    image = nk_font_atlas_load(&loaded, saved, size, &w, &h, NK_FONT_ATLAS_RGBA32);
+    load_ms = (bench_now() - start) * 1e3;
+    loaded_font = loaded.fonts;
+    same = image && loaded.glyph_count == atlas.glyph_count &&
+           !memcmp(loaded.glyphs, atlas.glyphs, sizeof(struct nk_font_glyph) * (size_t)atlas.glyph_count) &&
+           nk_font_text_width(nk_handle_ptr(loaded_font), 13.0f, text, (int)sizeof(text) - 1) ==
+               nk_font_text_width(nk_handle_ptr(font), 13.0f, text, (int)sizeof(text) - 1);
+    nk_font_atlas_end(&loaded, nk_handle_id(1), 0);
+    nk_font_atlas_clear(&loaded);
+  }
+  nk_font_atlas_clear(&atlas);
+
+  /* another size of the same font has to bake */
+  nk_font_atlas_init_default(&atlas);
+  nk_font_atlas_begin(&atlas);
+  nk_font_atlas_add_default(&atlas, 14.0f, &config);
+  rejected = !nk_font_atlas_load(&atlas, saved, size, &w, &h, NK_FONT_ATLAS_RGBA32);
+  nk_font_atlas_clear(&atlas);
+  free(saved);
+
+  printf("  nk_font_atlas_load: %8.3f ms from %.1f MB in memory, %.1f ms to bake (%s, %s)\n",
+         load_ms, (double)size / (1024.0 * 1024.0), bake_ms, bench_check(same, "same glyphs", "GLYPHS DIFFER"),
+         bench_check(rejected, "other fonts rejected", "OTHER FONTS LOADED"));
+}
+
+int main(int argc, char **argv)
+{
+  static struct bench b;
+  int iterations = argc > 1 ? atoi(argv[1]) : 2000;
+  int threads = argc > 2 ? atoi(argv[2]) : 0;
+
+  bench_init(&b, threads);
+  bench_build(&b, bench_demo);
+  bench_convert_modes(&b, "demo", iterations);
+  bench_build(&b, bench_windows);
+  bench_convert_modes(&b, "windows", iterations / 10 + 1);
+  bench_build(&b, bench_stacked);
+  bench_convert_modes(&b, "stacked", iterations / 10 + 1);
+  bench_build(&b, bench_text);
+  bench_convert_modes(&b, "text", iterations);
+  bench_build(&b, bench_canvas);
+  bench_convert_modes(&b, "canvas", iterations / 10 + 1);
+  bench_build(&b, bench_curves);
+  bench_convert_modes(&b, "curves", iterations / 10 + 1);
+  bench_build(&b, bench_images);
+  bench_convert_modes(&b, "images", iterations);
+  bench_layout(&b, "demo", bench_demo, iterations);
+  bench_layout(&b, "windows", bench_windows, iterations / 10 + 1);
+  bench_layout(&b, "text", bench_text, iterations);
+  bench_shapes(&b, iterations / 10 + 1);
+  bench_glyphs(iterations / 10 + 1);
+  bench_bake(&b);
+  bench_atlas_cache();
+  bench_free(&b);
+  if(bench_failures)
+    fprintf(stderr, "%d checks failed\n", bench_failures);
+  return bench_failures ? 1 : 0;
+}
@@ -4,6 +4,7 @@
 #include <math.h>
 #include <math.h>
 #include <stdarg.h>
+#include <stddef.h>
 #include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
@@ -20,15 +21,21 @@
 #define NK_IMPLEMENTATION
 #define NK_KEYSTATE_BASED_INPUT
 #define NK_COCOA_IMPLEMENTATION
+#if defined(NK_COCOA_SOFTWARE)
+#elif defined(__APPLE__)
 #include <OpenGL/gl3.h>
+#else
+#include <GLES3/gl3.h>
+#endif
 #include "nuklear.h"
 #include "nuklear_cocoa.h"
 
 #define WINDOW_WIDTH 1200
 #define WINDOW_HEIGHT 800
 
-#define MAX_VERTEX_BUFFER 512 * 1024
-#define MAX_ELEMENT_BUFFER 128 * 1024
+/* nk_cocoa_render grows its buffers from these on demand */
+#define INITIAL_VERTEX_BUFFER 64 * 1024
+#define INITIAL_ELEMENT_BUFFER 16 * 1024
 
 /* ===============================================================
  *
@@ -71,18 +78,17 @@
 int main(void)
 {
   /* Platform */
-  int width = 0, height = 0;
   struct nk_context *ctx;
   struct nk_colorf bg;
 
-  width = 1024;
-  height = 1024;
   COCOA_Initialize();
   COCOAwindow *window = COCOA_NewWindow(WINDOW_WIDTH, WINDOW_HEIGHT, "Nuklear Demo");
   COCOAcontext *context = COCOA_NewGLContext(window);
   COCOA_SetGLContext(window, context);
+#ifndef NK_COCOA_SOFTWARE
   /* OpenGL */
   glViewport(0, 0, WINDOW_WIDTH, WINDOW_HEIGHT);
+#endif
 
   ctx = nk_cocoa_init(window, NK_COCOA_INSTALL_CALLBACKS);
   /* Load Fonts: if none of these are loaded a default font will be used  */
@@ -174,18 +180,41 @@ int main(void)
     /* ----------------------------------------- */
 
     /* Draw */
+#ifdef NK_COCOA_RETAINED
+    nk_cocoa_set_clear_color(bg);
+#endif
+    if(!nk_cocoa_frame_changed())
+    {
+      /* nothing to draw, wait about one display refresh instead of spinning */
+      struct timespec idle = {0, 16 * 1000 * 1000};
+      nanosleep(&idle, NULL);
+      continue;
+    }
+#ifndef NK_COCOA_SOFTWARE
+    int width, height;
     COCOA_GetFrameBufferSize(window, &width, &height);
     glViewport(0, 0, width, height);
     glClear(GL_COLOR_BUFFER_BIT);
     glClearColor(bg.r, bg.g, bg.b, bg.a);
+#endif
     /* IMPORTANT: `nk_cocoa_render` modifies some global OpenGL state
      * with blending, scissor, face culling, depth test and viewport and
      * defaults everything back into a default state.
      * Make sure to either a.) save and restore or b.) reset your own state after
      * rendering the UI. */
-    nk_cocoa_render(NK_ANTI_ALIASING_ON, MAX_VERTEX_BUFFER, MAX_ELEMENT_BUFFER);
+    nk_cocoa_render(NK_ANTI_ALIASING_ON, INITIAL_VERTEX_BUFFER, INITIAL_ELEMENT_BUFFER);
+#ifdef NK_COCOA_SOFTWARE
+    {
+      /* the UI was drawn on the CPU, hand the image to the window */
+      int width, height;
+      const void *pixels = nk_cocoa_framebuffer(&width, &height);
+      if(pixels)
+        COCOA_PresentPixels(window, pixels, width, height);
+    }
+#endif
     COCOA_SwapBuffers(window);
   }
+  nk_cocoa_print_frame_stats();
   nk_cocoa_shutdown();
   return 0;
 }
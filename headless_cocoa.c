@@ -0,0 +1,818 @@
+#include "headless_cocoa.h"
+
+#include <assert.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#ifndef COCOA_HEADLESS_NO_GL
+#include <EGL/egl.h>
+#include <EGL/eglext.h>
+#include <GLES3/gl3.h>
+#endif
+
+typedef struct COCOA_Context
+{
+#ifndef COCOA_HEADLESS_NO_GL
+  EGLContext eglContext;
+  EGLSurface eglSurface;
+#endif
+  int width;
+  int height;
+} COCOA_Context;
+
+typedef struct COCOA_ScriptEvent
+{
+  unsigned int frame;
+  int line;
+  int type;
+  int arg0;
+  double x;
+  double y;
+} COCOA_ScriptEvent;
+
+enum
+{
+  COCOA_SCRIPT_MOVE,
+  COCOA_SCRIPT_BUTTON,
+  COCOA_SCRIPT_KEY,
+  COCOA_SCRIPT_CHAR,
+  COCOA_SCRIPT_SCROLL,
+  COCOA_SCRIPT_RESIZE,
+  COCOA_SCRIPT_CLOSE
+};
+
+typedef struct COCOA_Window
+{
+  struct COCOA_Window *next;
+  COCOA_Context *glContext;
+  int width;
+  int height;
+  int scale;
+  int shouldClose;
+  double mouseX;
+  double mouseY;
+  char mouseButtons[3];
+  char keys[COCOA_KEY_LAST + 1];
+
+  unsigned char *pixels;
+  size_t pixelsSize;
+  int presented; /* pixels hold the image of COCOA_PresentPixels instead of the GL surface */
+
+  COCOA_ScriptEvent *script;
+  int scriptCount;
+  int scriptCursor;
+
+  COCOACharacterCallback characterCallback;
+  COCOAKeyCallback keyCallback;
+  COCOAMouseButtonCallback mouseButtonCallback;
+  COCOAScrollCallback scrollCallback;
+} COCOA_Window;
+
+typedef struct COCOA_GlobalState
+{
+  COCOA_Window *windowListHead;
+  COCOA_Context *currentContext;
+  struct timespec startTime;
+  double timeStep;
+  unsigned int frame;
+  unsigned int closeAfterFrames;
+  int defaultScale;
+#ifndef COCOA_HEADLESS_NO_GL
+  EGLDisplay eglDisplay;
+  EGLConfig eglConfig;
+#endif
+} COCOA_GlobalState;
+
+static COCOA_GlobalState s_COCOA = {0};
+
+static const struct
+{
+  const char *name;
+  int key;
+} s_KeyNames[] = {
+    {"space", COCOA_KEY_SPACE},
+    {"escape", COCOA_KEY_ESCAPE},
+    {"enter", COCOA_KEY_ENTER},
+    {"tab", COCOA_KEY_TAB},
+    {"backspace", COCOA_KEY_BACKSPACE},
+    {"insert", COCOA_KEY_INSERT},
+    {"delete", COCOA_KEY_DELETE},
+    {"right", COCOA_KEY_RIGHT},
+    {"left", COCOA_KEY_LEFT},
+    {"down", COCOA_KEY_DOWN},
+    {"up", COCOA_KEY_UP},
+    {"pageup", COCOA_KEY_PAGE_UP},
+    {"pagedown", COCOA_KEY_PAGE_DOWN},
+    {"home", COCOA_KEY_HOME},
+    {"end", COCOA_KEY_END},
+    {"lshift", COCOA_KEY_LEFT_SHIFT},
+    {"lctrl", COCOA_KEY_LEFT_CONTROL},
+    {"rshift", COCOA_KEY_RIGHT_SHIFT},
+    {"rctrl", COCOA_KEY_RIGHT_CONTROL},
+};
+
+static int TranslateKeyName(const char *name)
+{
+  char *end;
+  long value = strtol(name, &end, 10);
+  if(end != name && *end == '\0')
+    return (int)value;
+
+  if(name[0] && !name[1])
+  {
+    if(name[0] >= 'a' && name[0] <= 'z')
+      return name[0] - 'a' + 'A';
+    return (unsigned char)name[0];
+  }
+
+  for(size_t i = 0; i < sizeof(s_KeyNames) / sizeof(s_KeyNames[0]); ++i)
+  {
+    if(!strcmp(s_KeyNames[i].name, name))
+      return s_KeyNames[i].key;
+  }
+  return COCOA_KEY_UNKNOWN;
+}
+
+static int TranslateButtonName(const char *name)
+{
+  if(!strcmp(name, "left"))
+    return COCOA_MOUSE_BUTTON_LEFT;
+  if(!strcmp(name, "right"))
+    return COCOA_MOUSE_BUTTON_RIGHT;
+  if(!strcmp(name, "middle"))
+    return COCOA_MOUSE_BUTTON_MIDDLE;
+  return -1;
+}
+
+static int TranslateActionName(const char *name)
+{
+  if(!strcmp(name, "press"))
+    return COCOA_PRESS;
+  if(!strcmp(name, "release"))
+    return COCOA_RELEASE;
+  return -1;
+}
+
+#ifndef COCOA_HEADLESS_NO_GL
+static int InitializeEGL(void)
+{
+  PFNEGLGETPLATFORMDISPLAYEXTPROC getPlatformDisplay =
+      (PFNEGLGETPLATFORMDISPLAYEXTPROC)eglGetProcAddress("eglGetPlatformDisplayEXT");
+  EGLint major, minor, count;
+  const EGLint attributes[] = {EGL_SURFACE_TYPE,
+                               EGL_PBUFFER_BIT,
+                               EGL_RENDERABLE_TYPE,
+                               EGL_OPENGL_ES3_BIT,
+                               EGL_RED_SIZE,
+                               8,
+                               EGL_GREEN_SIZE,
+                               8,
+                               EGL_BLUE_SIZE,
+                               8,
+                               EGL_ALPHA_SIZE,
+                               8,
+                               EGL_NONE};
+
+  if(getPlatformDisplay)
+    s_COCOA.eglDisplay =
+        getPlatformDisplay(EGL_PLATFORM_SURFACELESS_MESA, EGL_DEFAULT_DISPLAY, NULL);
+  if(s_COCOA.eglDisplay == EGL_NO_DISPLAY)
+    s_COCOA.eglDisplay = eglGetDisplay(EGL_DEFAULT_DISPLAY);
+  if(s_COCOA.eglDisplay == EGL_NO_DISPLAY || !eglInitialize(s_COCOA.eglDisplay, &major, &minor))
+  {
+    s_COCOA.eglDisplay = EGL_NO_DISPLAY;
+    return COCOA_FALSE;
+  }
+
+  if(!eglChooseConfig(s_COCOA.eglDisplay, attributes, &s_COCOA.eglConfig, 1, &count) || !count ||
+     !eglBindAPI(EGL_OPENGL_ES_API))
+  {
+    eglTerminate(s_COCOA.eglDisplay);
+    s_COCOA.eglDisplay = EGL_NO_DISPLAY;
+    return COCOA_FALSE;
+  }
+  return COCOA_TRUE;
+}
+
+static void CreateSurface(COCOA_Context *context, int width, int height)
+{
+  const EGLint attributes[] = {EGL_WIDTH, width > 0 ? width : 1, EGL_HEIGHT,
+                               height > 0 ? height : 1, EGL_NONE};
+  context->eglSurface =
+      eglCreatePbufferSurface(s_COCOA.eglDisplay, s_COCOA.eglConfig, attributes);
+  assert(context->eglSurface != EGL_NO_SURFACE);
+  context->width = width;
+  context->height = height;
+}
+#endif
+
+static void SetCurrentGLContext(COCOA_Window *window, COCOA_Context *context)
+{
+  if(window)
+    window->glContext = context;
+#ifndef COCOA_HEADLESS_NO_GL
+  if(s_COCOA.eglDisplay != EGL_NO_DISPLAY)
+  {
+    if(context)
+      eglMakeCurrent(s_COCOA.eglDisplay, context->eglSurface, context->eglSurface,
+                     context->eglContext);
+    else
+      eglMakeCurrent(s_COCOA.eglDisplay, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+  }
+#endif
+  s_COCOA.currentContext = context;
+}
+
+static COCOA_Context *NewGLContext(COCOA_Window *window)
+{
+  COCOA_Context *glContext;
+  int width, height;
+
+#ifndef COCOA_HEADLESS_NO_GL
+  if(s_COCOA.eglDisplay == EGL_NO_DISPLAY && !InitializeEGL())
+    return NULL;
+#endif
+
+  glContext = calloc(1, sizeof(COCOA_Context));
+  COCOA_GetFrameBufferSize((COCOAwindow *)window, &width, &height);
+  glContext->width = width;
+  glContext->height = height;
+
+#ifndef COCOA_HEADLESS_NO_GL
+  {
+    const EGLint attributes[] = {EGL_CONTEXT_MAJOR_VERSION, 3, EGL_NONE};
+    glContext->eglContext =
+        eglCreateContext(s_COCOA.eglDisplay, s_COCOA.eglConfig, EGL_NO_CONTEXT, attributes);
+    assert(glContext->eglContext != EGL_NO_CONTEXT);
+    CreateSurface(glContext, width, height);
+  }
+#endif
+
+  return glContext;
+}
+
+static void DeleteGLContext(COCOA_Context *context)
+{
+  if(!context)
+    return;
+  if(s_COCOA.currentContext == context)
+    SetCurrentGLContext(NULL, NULL);
+
+  for(COCOA_Window *window = s_COCOA.windowListHead; window; window = window->next)
+  {
+    if(window->glContext == context)
+      window->glContext = NULL;
+  }
+
+#ifndef COCOA_HEADLESS_NO_GL
+  eglDestroySurface(s_COCOA.eglDisplay, context->eglSurface);
+  eglDestroyContext(s_COCOA.eglDisplay, context->eglContext);
+#endif
+  free(context);
+}
+
+static void UpdateGLContext(COCOA_Window *window)
+{
+  COCOA_Context *context = window->glContext;
+  int width, height;
+  if(!context)
+    return;
+
+  COCOA_GetFrameBufferSize((COCOAwindow *)window, &width, &height);
+  if(context->width == width && context->height == height)
+    return;
+
+#ifndef COCOA_HEADLESS_NO_GL
+  {
+    EGLSurface oldSurface = context->eglSurface;
+    CreateSurface(context, width, height);
+    if(s_COCOA.currentContext == context)
+      SetCurrentGLContext(window, context);
+    eglDestroySurface(s_COCOA.eglDisplay, oldSurface);
+  }
+#else
+  context->width = width;
+  context->height = height;
+#endif
+}
+
+static void InputMouseClick(COCOA_Window *window, int button, int action)
+{
+  if(button < 0 || button > 2)
+    return;
+
+  window->mouseButtons[button] = (char)action;
+  if(window->mouseButtonCallback)
+    window->mouseButtonCallback((COCOAwindow *)window, button, action, 0);
+}
+
+static void InputKey(COCOA_Window *window, int key, int action)
+{
+  if(key >= 0 && key <= COCOA_KEY_LAST)
+  {
+    if(action == COCOA_RELEASE && window->keys[key] == COCOA_RELEASE)
+      return;
+
+    window->keys[key] = (char)action;
+  }
+}
+
+static int CompareScriptEvents(const void *a, const void *b)
+{
+  const COCOA_ScriptEvent *ea = (const COCOA_ScriptEvent *)a;
+  const COCOA_ScriptEvent *eb = (const COCOA_ScriptEvent *)b;
+  if(ea->frame != eb->frame)
+    return ea->frame < eb->frame ? -1 : 1;
+  return ea->line - eb->line;
+}
+
+static void ReplayScript(COCOA_Window *window)
+{
+  while(window->scriptCursor < window->scriptCount &&
+        window->script[window->scriptCursor].frame <= s_COCOA.frame)
+  {
+    const COCOA_ScriptEvent *event = &window->script[window->scriptCursor++];
+    COCOAwindow *handle = (COCOAwindow *)window;
+    switch(event->type)
+    {
+      case COCOA_SCRIPT_MOVE: COCOA_HeadlessMouseMove(handle, event->x, event->y); break;
+      case COCOA_SCRIPT_BUTTON:
+        COCOA_HeadlessMouseButton(handle, (int)event->x, event->arg0);
+        break;
+      case COCOA_SCRIPT_KEY: COCOA_HeadlessKey(handle, (int)event->x, event->arg0); break;
+      case COCOA_SCRIPT_CHAR: COCOA_HeadlessChar(handle, (unsigned int)event->arg0); break;
+      case COCOA_SCRIPT_SCROLL: COCOA_HeadlessScroll(handle, event->x, event->y); break;
+      case COCOA_SCRIPT_RESIZE:
+        COCOA_HeadlessResize(handle, (int)event->x, (int)event->y);
+        break;
+      case COCOA_SCRIPT_CLOSE: COCOA_HeadlessClose(handle); break;
+    }
+  }
+}
+
+void COCOA_SwapBuffers(COCOAwindow *handle)
+{
+  COCOA_Window *window = (COCOA_Window *)handle;
+  assert(window);
+#ifndef COCOA_HEADLESS_NO_GL
+  /* pbuffers are single buffered, the frame stays readable until the next one is drawn */
+  if(window->glContext && s_COCOA.currentContext == window->glContext)
+    glFlush();
+#endif
+}
+
+void COCOA_PresentPixels(COCOAwindow *handle, const void *pixels, int width, int height)
+{
+  COCOA_Window *window = (COCOA_Window *)handle;
+  size_t size = (size_t)width * (size_t)height * 4;
+  assert(window);
+  assert(pixels);
+  if(size > window->pixelsSize)
+  {
+    window->pixels = realloc(window->pixels, size);
+    window->pixelsSize = size;
+  }
+  memcpy(window->pixels, pixels, size);
+  window->presented = 1;
+}
+
+void COCOA_GetWindowSize(COCOAwindow *handle, int *width, int *height)
+{
+  COCOA_Window *window = (COCOA_Window *)handle;
+  assert(window);
+  if(width)
+    *width = window->width;
+  if(height)
+    *height = window->height;
+}
+
+void COCOA_GetFrameBufferSize(COCOAwindow *handle, int *width, int *height)
+{
+  COCOA_Window *window = (COCOA_Window *)handle;
+  assert(window);
+  if(width)
+    *width = window->width * window->scale;
+  if(height)
+    *height = window->height * window->scale;
+}
+
+void COCOA_Poll(void)
+{
+  for(COCOA_Window *window = s_COCOA.windowListHead; window; window = window->next)
+    ReplayScript(window);
+
+  ++s_COCOA.frame;
+  if(s_COCOA.closeAfterFrames && s_COCOA.frame >= s_COCOA.closeAfterFrames)
+  {
+    for(COCOA_Window *window = s_COCOA.windowListHead; window; window = window->next)
+      window->shouldClose = COCOA_TRUE;
+  }
+}
+
+void COCOA_GetMousePosition(COCOAwindow *handle, double *xpos, double *ypos)
+{
+  COCOA_Window *window = (COCOA_Window *)handle;
+  assert(window);
+  if(xpos)
+    *xpos = window->mouseX;
+  if(ypos)
+    *ypos = window->mouseY;
+}
+
+int COCOA_WindowShouldClose(COCOAwindow *handle)
+{
+  COCOA_Window *window = (COCOA_Window *)handle;
+  assert(window);
+  return window->shouldClose;
+}
+
+void COCOA_SetCharacterCallback(COCOAwindow *handle, COCOACharacterCallback callback)
+{
+  COCOA_Window *window = (COCOA_Window *)handle;
+  assert(window);
+  window->characterCallback = callback;
+}
+
+void COCOA_SetKeyCallback(COCOAwindow *handle, COCOAKeyCallback callback)
+{
+  COCOA_Window *window = (COCOA_Window *)handle;
+  assert(window);
+  window->keyCallback = callback;
+}
+
+void COCOA_SetScrollCallback(COCOAwindow *handle, COCOAScrollCallback callback)
+{
+  COCOA_Window *window = (COCOA_Window *)handle;
+  assert(window);
+  window->scrollCallback = callback;
+}
+
+void COCOA_SetMouseButtonCallback(COCOAwindow *handle, COCOAMouseButtonCallback callback)
+{
+  COCOA_Window *window = (COCOA_Window *)handle;
+  assert(window);
+  window->mouseButtonCallback = callback;
+}
+
+double COCOA_GetTime(void)
+{
+  struct timespec now;
+  if(s_COCOA.timeStep > 0.0)
+    return s_COCOA.frame * s_COCOA.timeStep;
+
+  clock_gettime(CLOCK_MONOTONIC, &now);
+  return (double)(now.tv_sec - s_COCOA.startTime.tv_sec) +
+         (double)(now.tv_nsec - s_COCOA.startTime.tv_nsec) * 1e-9;
+}
+
+int COCOA_GetKeyState(COCOAwindow *handle, int key)
+{
+  COCOA_Window *window = (COCOA_Window *)handle;
+  assert(window);
+  assert(key >= COCOA_KEY_FIRST && key <= COCOA_KEY_LAST);
+  return (int)window->keys[key];
+}
+
+int COCOA_GetMouseButtonState(COCOAwindow *handle, int button)
+{
+  COCOA_Window *window = (COCOA_Window *)handle;
+  assert(window);
+  assert(button >= 0 && button <= 2);
+  return (int)window->mouseButtons[button];
+}
+
+int COCOA_Initialize(void)
+{
+  const char *env;
+  memset(&s_COCOA, 0, sizeof(s_COCOA));
+
+  clock_gettime(CLOCK_MONOTONIC, &s_COCOA.startTime);
+  s_COCOA.defaultScale = 1;
+#ifndef COCOA_HEADLESS_NO_GL
+  s_COCOA.eglDisplay = EGL_NO_DISPLAY;
+#endif
+
+  if((env = getenv("COCOA_HEADLESS_FRAMES")))
+    s_COCOA.closeAfterFrames = (unsigned int)strtoul(env, NULL, 10);
+  if((env = getenv("COCOA_HEADLESS_TIMESTEP")))
+    s_COCOA.timeStep = strtod(env, NULL);
+  if((env = getenv("COCOA_HEADLESS_SCALE")) && atoi(env) > 0)
+    s_COCOA.defaultScale = atoi(env);
+
+  return COCOA_TRUE;
+}
+
+void COCOA_Shutdown(void)
+{
+  while(s_COCOA.windowListHead)
+    COCOA_DeleteWindow((COCOAwindow *)s_COCOA.windowListHead);
+
+#ifndef COCOA_HEADLESS_NO_GL
+  if(s_COCOA.eglDisplay != EGL_NO_DISPLAY)
+    eglTerminate(s_COCOA.eglDisplay);
+#endif
+
+  memset(&s_COCOA, 0, sizeof(s_COCOA));
+}
+
+COCOAwindow *COCOA_NewWindow(int width, int height, const char *title)
+{
+  COCOA_Window *window;
+  const char *script;
+
+  assert(title);
+  assert(width >= 0);
+  assert(height >= 0);
+
+  window = calloc(1, sizeof(COCOA_Window));
+  window->next = s_COCOA.windowListHead;
+  s_COCOA.windowListHead = window;
+
+  window->width = width;
+  window->height = height;
+  window->scale = s_COCOA.defaultScale;
+  window->glContext = NULL;
+
+  if((script = getenv("COCOA_HEADLESS_SCRIPT")) && !COCOA_HeadlessLoadScript((COCOAwindow *)window, script))
+    fprintf(stderr, "Failed to load input script '%s'\n", script);
+
+  return (COCOAwindow *)window;
+}
+
+void COCOA_DeleteWindow(COCOAwindow *handle)
+{
+  COCOA_Window *window = (COCOA_Window *)handle;
+  if(window == NULL)
+    return;
+
+  window->characterCallback = NULL;
+  window->keyCallback = NULL;
+  window->mouseButtonCallback = NULL;
+  window->scrollCallback = NULL;
+
+  DeleteGLContext(window->glContext);
+  window->glContext = NULL;
+
+  COCOA_Window **prev = &s_COCOA.windowListHead;
+  while(*prev != window)
+    prev = &((*prev)->next);
+
+  *prev = window->next;
+
+  free(window->script);
+  free(window->pixels);
+  free(window);
+}
+
+COCOAcontext *COCOA_NewGLContext(COCOAwindow *handle)
+{
+  COCOA_Window *window = (COCOA_Window *)handle;
+  return (COCOAcontext *)NewGLContext(window);
+}
+
+void COCOA_DeleteGLContext(COCOAcontext *ctx)
+{
+  COCOA_Context *context = (COCOA_Context *)ctx;
+  DeleteGLContext(context);
+}
+
+COCOAcontext *COCOA_GetGLContext(COCOAwindow *handle)
+{
+  COCOA_Window *window = (COCOA_Window *)handle;
+  return (COCOAcontext *)(window->glContext);
+}
+
+void COCOA_SetGLContext(COCOAwindow *handle, COCOAcontext *ctx)
+{
+  COCOA_Window *window = (COCOA_Window *)handle;
+  COCOA_Context *context = (COCOA_Context *)ctx;
+  SetCurrentGLContext(window, context);
+  UpdateGLContext(window);
+}
+
+void *COCOA_SwitchLayerToMetal(COCOAwindow *handle, void *metalDevice)
+{
+  (void)handle;
+  (void)metalDevice;
+  return NULL;
+}
+
+void *COCOA_NextDrawable(COCOAwindow *handle)
+{
+  (void)handle;
+  return NULL;
+}
+
+void COCOA_HeadlessKey(COCOAwindow *handle, int key, int action)
+{
+  COCOA_Window *window = (COCOA_Window *)handle;
+  assert(window);
+  InputKey(window, key, action);
+  if(window->keyCallback)
+    window->keyCallback(handle, key, action);
+}
+
+void COCOA_HeadlessChar(COCOAwindow *handle, unsigned int codepoint)
+{
+  COCOA_Window *window = (COCOA_Window *)handle;
+  assert(window);
+  if(window->characterCallback)
+    window->characterCallback(handle, codepoint);
+}
+
+void COCOA_HeadlessMouseMove(COCOAwindow *handle, double xpos, double ypos)
+{
+  COCOA_Window *window = (COCOA_Window *)handle;
+  assert(window);
+  window->mouseX = xpos;
+  window->mouseY = ypos;
+}
+
+void COCOA_HeadlessMouseButton(COCOAwindow *handle, int button, int action)
+{
+  COCOA_Window *window = (COCOA_Window *)handle;
+  assert(window);
+  InputMouseClick(window, button, action);
+}
+
+void COCOA_HeadlessScroll(COCOAwindow *handle, double xoff, double yoff)
+{
+  COCOA_Window *window = (COCOA_Window *)handle;
+  assert(window);
+  if(window->scrollCallback)
+    window->scrollCallback(handle, xoff, yoff);
+}
+
+void COCOA_HeadlessResize(COCOAwindow *handle, int width, int height)
+{
+  COCOA_Window *window = (COCOA_Window *)handle;
+  assert(window);
+  assert(width >= 0);
+  assert(height >= 0);
+  window->width = width;
+  window->height = height;
+  UpdateGLContext(window);
+}
+
+void COCOA_HeadlessClose(COCOAwindow *handle)
+{
+  COCOA_Window *window = (COCOA_Window *)handle;
+  assert(window);
+  window->shouldClose = COCOA_TRUE;
+}
+
+int COCOA_HeadlessLoadScript(COCOAwindow *handle, const char *path)
+{
+  COCOA_Window *window = (COCOA_Window *)handle;
+  char line[256];
+  int lineNumber = 0;
+  int capacity = window->scriptCount;
+  FILE *file;
+
+  assert(window);
+  file = fopen(path, "r");
+  if(!file)
+    return COCOA_FALSE;
+
+  while(fgets(line, sizeof(line), file))
+  {
+    COCOA_ScriptEvent event;
+    char command[32], arg0[32], arg1[32];
+    unsigned int frame;
+    int fields;
+
+    ++lineNumber;
+    if(strchr(line, '#'))
+      *strchr(line, '#') = '\0';
+    fields = sscanf(line, "%u %31s %31s %31s", &frame, command, arg0, arg1);
+    if(fields < 2)
+      continue;
+
+    memset(&event, 0, sizeof(event));
+    event.frame = frame;
+    event.line = lineNumber;
+    event.type = -1;
+    if(!strcmp(command, "move") && fields == 4)
+    {
+      event.type = COCOA_SCRIPT_MOVE;
+      event.x = strtod(arg0, NULL);
+      event.y = strtod(arg1, NULL);
+    }
+    else if((!strcmp(command, "press") || !strcmp(command, "release")) && fields == 3)
+    {
+      event.type = COCOA_SCRIPT_BUTTON;
+      event.x = TranslateButtonName(arg0);
+      event.arg0 = TranslateActionName(command);
+    }
+    else if(!strcmp(command, "key") && fields == 4)
+    {
+      event.type = COCOA_SCRIPT_KEY;
+      event.x = TranslateKeyName(arg0);
+      event.arg0 = TranslateActionName(arg1);
+      if(event.x < COCOA_KEY_FIRST || event.x > COCOA_KEY_LAST || event.arg0 < 0)
+        event.type = -1;
+    }
+    else if(!strcmp(command, "char") && fields == 3)
+    {
+      event.type = COCOA_SCRIPT_CHAR;
+      event.arg0 = (int)strtol(arg0, NULL, 0);
+    }
+    else if(!strcmp(command, "scroll") && fields == 4)
+    {
+      event.type = COCOA_SCRIPT_SCROLL;
+      event.x = strtod(arg0, NULL);
+      event.y = strtod(arg1, NULL);
+    }
+    else if(!strcmp(command, "resize") && fields == 4)
+    {
+      event.type = COCOA_SCRIPT_RESIZE;
+      event.x = strtod(arg0, NULL);
+      event.y = strtod(arg1, NULL);
+    }
+    else if(!strcmp(command, "close"))
+      event.type = COCOA_SCRIPT_CLOSE;
+
+    if(event.type < 0 || (event.type == COCOA_SCRIPT_BUTTON && event.x < 0))
+    {
+      fprintf(stderr, "%s:%d: invalid script event\n", path, lineNumber);
+      continue;
+    }
+
+    if(window->scriptCount == capacity)
+    {
+      capacity = capacity ? capacity * 2 : 64;
+      window->script = realloc(window->script, (size_t)capacity * sizeof(COCOA_ScriptEvent));
+    }
+    window->script[window->scriptCount++] = event;
+  }
+  fclose(file);
+
+  qsort(window->script + window->scriptCursor, (size_t)(window->scriptCount - window->scriptCursor),
+        sizeof(COCOA_ScriptEvent), CompareScriptEvents);
+  return COCOA_TRUE;
+}
+
+unsigned int COCOA_HeadlessFrameCount(void)
+{
+  return s_COCOA.frame;
+}
+
+void COCOA_HeadlessSetTimeStep(double seconds)
+{
+  s_COCOA.timeStep = seconds;
+}
+
+void COCOA_HeadlessSetFrameBufferScale(COCOAwindow *handle, int scale)
+{
+  COCOA_Window *window = (COCOA_Window *)handle;
+  assert(window);
+  assert(scale > 0);
+  window->scale = scale;
+  UpdateGLContext(window);
+}
+
+const unsigned char *COCOA_HeadlessGetPixels(COCOAwindow *handle, int *width, int *height)
+{
+  COCOA_Window *window = (COCOA_Window *)handle;
+  int fbWidth, fbHeight;
+  size_t size, pitch;
+
+  assert(window);
+  COCOA_GetFrameBufferSize(handle, &fbWidth, &fbHeight);
+  pitch = (size_t)fbWidth * 4;
+  size = pitch * (size_t)fbHeight;
+  if(size > window->pixelsSize)
+  {
+    window->pixels = realloc(window->pixels, size);
+    memset(window->pixels, 0, size);
+    window->pixelsSize = size;
+  }
+
+#ifndef COCOA_HEADLESS_NO_GL
+  if(window->glContext && s_COCOA.currentContext == window->glContext && !window->presented)
+  {
+    unsigned char *row = malloc(pitch);
+    glBindFramebuffer(GL_READ_FRAMEBUFFER, 0);
+    glPixelStorei(GL_PACK_ALIGNMENT, 1);
+    glReadPixels(0, 0, fbWidth, fbHeight, GL_RGBA, GL_UNSIGNED_BYTE, window->pixels);
+    /* GL is bottom-up */
+    for(int y = 0; y < fbHeight / 2; ++y)
+    {
+      unsigned char *top = window->pixels + (size_t)y * pitch;
+      unsigned char *bottom = window->pixels + (size_t)(fbHeight - 1 - y) * pitch;
+      memcpy(row, top, pitch);
+      memcpy(top, bottom, pitch);
+      memcpy(bottom, row, pitch);
+    }
+    free(row);
+  }
+#endif
+
+  if(width)
+    *width = fbWidth;
+  if(height)
+    *height = fbHeight;
+  return window->pixels;
+}
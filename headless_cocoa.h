@@ -0,0 +1,58 @@
+#ifndef __HEADLESS_COCOA_H
+#define __HEADLESS_COCOA_H
+
+#include "apple_cocoa.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Extensions only provided by the headless (Linux) implementation of apple_cocoa.h.
+ *
+ * Windows are virtual: input is injected through the functions below or replayed from a
+ * script, and the framebuffer lives in memory. The following environment variables are read by
+ * COCOA_Initialize / COCOA_NewWindow so unmodified applications can be driven from the outside:
+ *
+ *   COCOA_HEADLESS_FRAMES   close every window after this many COCOA_Poll calls
+ *   COCOA_HEADLESS_SCRIPT   input script replayed by COCOA_Poll (see COCOA_HeadlessLoadScript)
+ *   COCOA_HEADLESS_TIMESTEP fixed seconds per COCOA_Poll returned by COCOA_GetTime
+ *   COCOA_HEADLESS_SCALE    integer framebuffer scale (2 simulates a retina display)
+ */
+
+void COCOA_HeadlessKey(COCOAwindow *window, int key, int action);
+void COCOA_HeadlessChar(COCOAwindow *window, unsigned int codepoint);
+void COCOA_HeadlessMouseMove(COCOAwindow *window, double xpos, double ypos);
+void COCOA_HeadlessMouseButton(COCOAwindow *window, int button, int action);
+void COCOA_HeadlessScroll(COCOAwindow *window, double xoff, double yoff);
+void COCOA_HeadlessResize(COCOAwindow *window, int width, int height);
+void COCOA_HeadlessClose(COCOAwindow *window);
+
+/*
+ * Script lines are "<frame> <command> <args...>", events are delivered by the COCOA_Poll call
+ * with that (zero based) frame number. '#' starts a comment.
+ *
+ *   10 move 100 120       mouse position in window coordinates
+ *   10 press left         mouse button press (left, right, middle)
+ *   12 release left
+ *   20 key enter press    key by name or COCOA_KEY_* value, then press/release
+ *   21 char 65            unicode codepoint
+ *   30 scroll 0 -1
+ *   40 resize 800 600
+ *   99 close
+ */
+int COCOA_HeadlessLoadScript(COCOAwindow *window, const char *path);
+
+unsigned int COCOA_HeadlessFrameCount(void);
+void COCOA_HeadlessSetTimeStep(double seconds);
+void COCOA_HeadlessSetFrameBufferScale(COCOAwindow *window, int scale);
+
+/* Top-down RGBA8 copy of the window framebuffer: the last COCOA_PresentPixels image, or read
+ * back from GL when a context is bound */
+const unsigned char *COCOA_HeadlessGetPixels(COCOAwindow *window, int *width, int *height);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif    // #ifndef __HEADLESS_COCOA_H
@@ -105,8 +105,9 @@
 /// NK_INCLUDE_COMMAND_USERDATA     | Defining this adds a userdata pointer into each command. Can be useful for example if you want to provide custom shaders depending on the used widget. Can be combined with the style structures.
 /// NK_BUTTON_TRIGGER_ON_RELEASE    | Different platforms require button clicks occurring either on buttons being pressed (up to down) or released (down to up). By default this library will react on buttons being pressed, but if you define this it will only trigger if a button is released.
 /// NK_ZERO_COMMAND_MEMORY          | Defining this will zero out memory for each drawing command added to a drawing queue (inside nk_command_buffer_push). Zeroing command memory is very useful for fast checking (using memcmp) if command buffers are equal and avoid drawing frames when nothing on screen has changed since previous frame.
-/// NK_UINT_DRAW_INDEX              | Defining this will set the size of vertex index elements when using NK_VERTEX_BUFFER_OUTPUT to 32bit instead of the default of 16bit
+/// NK_UINT_DRAW_INDEX              | Defining this will set the size of vertex index elements when using NK_VERTEX_BUFFER_OUTPUT to 32bit instead of the default of 16bit. With 16bit indices draw commands are split whenever they would reference more than 65536 vertices and carry the start of their vertex range in `vertex_offset`
 /// NK_KEYSTATE_BASED_INPUT         | Define this if your backend uses key state for each frame rather than key press/release events
+/// NK_GENERIC_VERTEX_WRITER        | Defining this disables the specialized vertex writers `nk_convert` selects for common vertex layouts and always goes through the generic layout interpreter. Mainly useful for comparison and debugging.
 ///
 /// !!! WARNING
 ///     The following flags will pull in the standard C library:
@@ -132,12 +133,19 @@
 /// NK_BUFFER_DEFAULT_INITIAL_SIZE  | Initial buffer size allocated by all buffers while using the default allocator functions included by defining NK_INCLUDE_DEFAULT_ALLOCATOR. If you don't want to allocate the default 4k memory then redefine it.
 /// NK_MAX_NUMBER_BUFFER            | Maximum buffer size for the conversion buffer between float and string Under normal circumstances this should be more than sufficient.
 /// NK_INPUT_MAX                    | Defines the max number of bytes which can be added as text input in one frame. Under normal circumstances this should be more than sufficient.
+/// NK_DRAW_LIST_QUAD_RUN           | Number of consecutive quads (glyphs, images, square filled rectangles without anti-aliasing or on pixel edges) after which `nk_convert` moves them into a draw command using the shared quad elements, if `nk_convert_config.quad_batch` is set, or into a draw command of quad instances, if `nk_convert_config.quad_instances` is set. Shorter runs keep their elements so they do not cost an extra draw call, which is the common case for widgets whose rounded and stroked shapes interrupt the runs of short labels: text blocks and image grids are what gets batched. Defaults to 32.
+/// NK_DRAW_LIST_CIRCLE_LUT         | Number of unit circle points a draw list keeps precomputed for circles, one table for every segment count in use. Circles not finding room for their table rotate their points one by one. Defaults to 512.
+/// NK_DRAW_MERGE_WINDOW            | Number of already merged draw commands `nk_draw_merge` looks back through for one a draw command can join. Defaults to 64.
+/// NK_OPTIMIZE_OCCLUDERS           | Number of windows, popups and overlay on top of the others whose opaque background `nk_optimize_commands` hides commands behind. Defaults to 32.
+/// NK_TEXT_WIDTH_CACHE_MIN_LEN     | Strings shorter than this many bytes are measured by `nk_cached_font` directly, measuring them is not slower than looking them up. Defaults to 4.
 ///
 /// !!! WARNING
 ///     The following constants if defined need to be defined for both header and implementation:
 ///     - NK_MAX_NUMBER_BUFFER
 ///     - NK_BUFFER_DEFAULT_INITIAL_SIZE
 ///     - NK_INPUT_MAX
+///     - NK_DRAW_LIST_QUAD_RUN
+///     - NK_DRAW_LIST_CIRCLE_LUT
 ///
 /// ### Dependencies
 /// Function    | Description
@@ -239,6 +247,12 @@ extern "C" {
 #ifndef NK_MAX_NUMBER_BUFFER
   #define NK_MAX_NUMBER_BUFFER 64
 #endif
+#ifndef NK_DRAW_LIST_QUAD_RUN
+  #define NK_DRAW_LIST_QUAD_RUN 32
+#endif
+#ifndef NK_DRAW_LIST_CIRCLE_LUT
+  #define NK_DRAW_LIST_CIRCLE_LUT 512
+#endif
 #ifndef NK_SCROLLBAR_HIDING_TIMEOUT
   #define NK_SCROLLBAR_HIDING_TIMEOUT 4.0f
 #endif
@@ -432,6 +446,10 @@ struct nk_allocator;
 struct nk_command_buffer;
 struct nk_draw_command;
 struct nk_convert_config;
+struct nk_convert_state;
+struct nk_draw_merge;
+struct nk_damage;
+struct nk_optimize_stats;
 struct nk_style_item;
 struct nk_text_edit;
 struct nk_draw_list;
@@ -1107,6 +1125,7 @@ NK_API void nk_input_end(struct nk_context*);
 /// cfg.circle_segment_count = 22;
 /// cfg.curve_segment_count = 22;
 /// cfg.arc_segment_count = 22;
+/// cfg.segment_error = 0.25f;
 /// cfg.global_alpha = 1.0f;
 /// cfg.null = dev->null;
 /// //
@@ -1158,10 +1177,14 @@ struct nk_convert_config {
     unsigned circle_segment_count; /* number of segments used for circles: default to 22 */
     unsigned arc_segment_count; /* number of segments used for arcs: default to 22 */
     unsigned curve_segment_count; /* number of segments used for curves: default to 22 */
+    float segment_error; /* largest distance in pixels allowed between a circle, arc or curve and its segments, the segment counts above become upper limits. 0 always uses them */
+    float pixel_scale; /* framebuffer pixels per unit for `segment_error`, for example the retina scale: 0 is taken as 1 */
     struct nk_draw_null_texture null; /* handle to texture with a white pixel for shape drawing */
     const struct nk_draw_vertex_layout_element *vertex_layout; /* describes the vertex output format and packing */
     nk_size vertex_size; /* sizeof one vertex for vertex packing */
     nk_size vertex_alignment; /* vertex alignment: Can be obtained by NK_ALIGNOF */
+    unsigned quad_batch; /* quads the backend's shared quad elements cover, 0 writes elements for quads like for every other shape (see NK_DRAW_LIST_QUAD_RUN) */
+    int quad_instances; /* write runs of single colored quads (glyphs, images) as `nk_draw_quad_instance` records into the vertex buffer, the backend has to draw them instanced */
 };
 /*/// #### nk__begin
 /// Returns a draw command list iterator to iterate all draw
@@ -1208,6 +1231,52 @@ NK_API const struct nk_command* nk__next(struct nk_context*, const struct nk_com
 /// Iterates over each draw command inside the context draw command list
 */
 #define nk_foreach(c, ctx) for((c) = nk__begin(ctx); (c) != 0; (c) = nk__next(ctx,c))
+/*/// #### nk_damage_update
+/// Compares the draw commands of the current frame against the previous call and
+/// returns the union of the screen areas that have to be redrawn. Commands are
+/// matched window by window (popups and the overlay count as their own window):
+/// inside a window only commands that differ contribute their old and new bounds,
+/// windows that appear, disappear or change their drawing order contribute all
+/// of their bounds.
+///
+/// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~c
+/// struct nk_rect nk_damage_update(struct nk_damage*, struct nk_context*, struct nk_rect screen);
+/// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+///
+/// Parameter   | Description
+/// ------------|-----------------------------------------------------------
+/// __damage__  | Must point to a `nk_damage` initialized with `nk_damage_init`
+/// __ctx__     | Must point to an previously initialized `nk_context` struct at the end of a frame
+/// __screen__  | Visible area, the result is clipped to it
+///
+/// Returns the damaged area, with zero width and height if nothing changed and
+/// `screen` for the first call or after `nk_damage_invalidate`
+*/
+NK_API struct nk_rect nk_damage_update(struct nk_damage*, struct nk_context*, struct nk_rect screen);
+/*/// #### nk_optimize_commands
+/// Peephole pass over the draw command list, meant to run once per frame after
+/// the UI was built and before `nk_convert` or any backend walks the commands.
+/// Commands are unlinked from the list, never moved, so it costs one walk over
+/// the commands. Skipped are no-ops, scissors that change nothing because the
+/// same clip rect is already set or another scissor follows before anything is
+/// drawn, commands that draw nothing because they have no area or are fully
+/// transparent, and commands lying completely outside their clip rect. A filled
+/// rect without rounding directly followed by one of the same color it extends
+/// to a larger rect is grown to cover both. Commands hidden behind the opaque
+/// background of a window, popup or the overlay drawn on top of them are skipped
+/// as well, which leaves a fully covered window with just its first command.
+/// The first command of every window, popup and the overlay is always kept.
+///
+/// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~c
+/// void nk_optimize_commands(struct nk_context*, struct nk_optimize_stats*);
+/// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+///
+/// Parameter   | Description
+/// ------------|-----------------------------------------------------------
+/// __ctx__     | Must point to an previously initialized `nk_context` struct at the end of a frame
+/// __stats__   | Optional, receives the number of commands of each `nk_command_type` before and removed
+*/
+NK_API void nk_optimize_commands(struct nk_context*, struct nk_optimize_stats*);
 #ifdef NK_INCLUDE_VERTEX_BUFFER_OUTPUT
 /*/// #### nk_convert
 /// Converts all internal draw commands into vertex draw commands and fills
@@ -1239,6 +1308,71 @@ NK_API const struct nk_command* nk__next(struct nk_context*, const struct nk_com
 /// NK_CONVERT_ELEMENT_BUFFER_FULL  | The provided buffer for storing indicies is full or failed to allocate more memory
 */
 NK_API nk_flags nk_convert(struct nk_context*, struct nk_buffer *cmds, struct nk_buffer *vertices, struct nk_buffer *elements, const struct nk_convert_config*);
+/*/// #### nk_convert_windows
+/// Same output as `nk_convert` but the command queue is split into one unit per
+/// window, popup and the overlay. Units are converted independently into private
+/// buffers kept in `state`, through `state->dispatch` if set so they can run on
+/// worker threads, and then concatenated in queue order with rebased indices.
+/// Every unit is fingerprinted by hashing its commands, the clip rect it starts
+/// with and `config`. Units whose fingerprint matches a unit converted by an
+/// earlier call are not tessellated again, their previous output is reused.
+/// Call `nk_convert_state_invalidate` whenever something not captured by the
+/// commands changes, like the glyphs of a font.
+///
+/// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~c
+/// nk_flags nk_convert_windows(struct nk_context *ctx, struct nk_convert_state *state,
+//      struct nk_buffer *cmds, struct nk_buffer *vertices, struct nk_buffer *elements,
+//      const struct nk_convert_config*);
+/// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+///
+/// Parameter   | Description
+/// ------------|-----------------------------------------------------------
+/// __ctx__     | Must point to an previously initialized `nk_context` struct at the end of a frame
+/// __state__   | Must point to a `nk_convert_state` initialized with `nk_convert_state_init`
+/// __cmds__    | Must point to a previously initialized buffer to hold converted vertex draw commands
+/// __vertices__| Must point to a previously initialized buffer to hold all produced vertices
+/// __elements__| Must point to a previously initialized buffer to hold all produced vertex indices
+/// __config__  | Must point to a filled out `nk_config` struct to configure the conversion process
+///
+/// Returns the same enum nk_convert_result error codes as `nk_convert`
+*/
+NK_API nk_flags nk_convert_windows(struct nk_context*, struct nk_convert_state*, struct nk_buffer *cmds, struct nk_buffer *vertices, struct nk_buffer *elements, const struct nk_convert_config*);
+/*/// #### nk_draw_merge
+/// Post-pass over the vertex draw commands of the last `nk_convert` or
+/// `nk_convert_windows` call that reduces the number of draw calls. A draw
+/// command joins an earlier one with the same texture and kind of batch if a
+/// single scissor rect can replace both clip rects: commands whose geometry lies
+/// inside their clip rect are not clipped at all and accept any scissor covering
+/// it, commands cut by their clip rect only join commands with the same clip rect
+/// or ones that fit inside it. A command may move in front of the commands
+/// between the two as long as it does not overlap any of them on screen.
+/// Elements are copied into `elements` in the new order, rebased to the vertex
+/// offset of the merged command, and the command buffer is rewritten in place.
+/// Runs of quads and quad instances have no elements and only join runs whose
+/// vertices they directly follow.
+///
+/// Commands only differ in texture between shapes and text if the null texture
+/// is not the font atlas, `nk_font_atlas_end` fills `nk_draw_null_texture` with
+/// the atlas and its white texel so they share one. What is left to merge is
+/// mostly images between widgets. Overlap is judged by the bounding rect of
+/// each command, so windows that touch or overlap keep their own draw calls,
+/// as does window content that scrolls past its clip rect.
+///
+/// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~c
+/// nk_flags nk_draw_merge(struct nk_draw_merge*, struct nk_context*, struct nk_buffer *elements);
+/// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+///
+/// Parameter   | Description
+/// ------------|-----------------------------------------------------------
+/// __merge__   | Must point to a `nk_draw_merge` initialized with `nk_draw_merge_init`
+/// __ctx__     | Must point to an previously initialized `nk_context` struct converted by `nk_convert` or `nk_convert_windows`
+/// __elements__| Must point to a previously initialized buffer other than the one passed to the conversion, receives all vertex indices
+///
+/// Returns NK_CONVERT_SUCCESS, NK_CONVERT_INVALID_PARAM or NK_CONVERT_ELEMENT_BUFFER_FULL,
+/// in which case the draw commands are left as they were. `merge->draws_before` and
+/// `merge->draws_after` hold the number of draw calls before and after merging.
+*/
+NK_API nk_flags nk_draw_merge(struct nk_draw_merge*, struct nk_context*, struct nk_buffer *elements);
 /*/// #### nk__draw_begin
 /// Returns a draw vertex command buffer iterator to iterate over the vertex draw command buffer
 ///
@@ -3825,6 +3959,51 @@ NK_API const char* nk_utf_at(const char *buffer, int length, int index, nk_rune
         cfg.coord_type = NK_COORD_PIXEL;
         nk_font *font = nk_font_atlas_add_from_file(&atlas, "Path/To/Your/TTF_Font.ttf", 13, &cfg);
 
+    Large ranges like `nk_font_chinese_glyph_ranges` take long to bake and need a
+    big texture. `nk_font_atlas_bake_dynamic` instead returns a texture of the given
+    size holding only the cursors and the white pixel, glyphs are rasterized into
+    it the first time they are drawn. The image stays in `atlas->pixel` and the
+    truetype blobs stay loaded until `nk_font_atlas_clear`. Before drawing each frame,
+    upload the part `nk_font_atlas_dirty` reports as changed. Glyphs not fitting the
+    texture anymore are drawn empty. Drawing queries glyphs from a single thread,
+    renderers querying them from several call `nk_font_atlas_prepare` first:
+
+        const void *img = nk_font_atlas_bake_dynamic(&atlas, 1024, 1024, NK_FONT_ATLAS_RGBA32);
+        nk_font_atlas_end(&atlas, nk_handle_id(texture), 0);
+        while (1) {
+            struct nk_recti dirty;
+            nk_font_atlas_prepare(&atlas, &ctx);
+            if (nk_font_atlas_dirty(&atlas, &dirty))
+                upload(texture, atlas.pixel, dirty);
+        }
+
+    `nk_font_atlas_bake` rasterizes glyphs on the calling thread. Setting `dispatch`
+    and `scheduler` in the atlas before baking hands the glyphs to your job system
+    in chunks instead. Each glyph is rendered into its own packed rectangle, so the
+    image and glyphs are identical to the serial bake. The temporary allocator is
+    called from the jobs too and therefore has to be thread safe:
+
+        atlas.dispatch = my_dispatch; // calls job(data, i, worker) for i in [0, count)
+        atlas.scheduler = nk_handle_ptr(my_thread_pool);
+        const void* img = nk_font_atlas_bake(&atlas, &img_width, &img_height, NK_FONT_ATLAS_RGBA32);
+
+    A baked atlas can be stored and reused by later runs. Between `nk_font_atlas_bake`
+    and `nk_font_atlas_end`, `nk_font_atlas_save` writes the image, glyphs and font metrics
+    into memory, a first call without memory returns the required size. The data starts
+    with a version and a hash of the added fonts and their configuration.
+    `nk_font_atlas_load` takes the place of `nk_font_atlas_bake` and returns 0 if the
+    data does not match the fonts added, otherwise the image inside the passed memory,
+    which therefore has to stay valid until the texture is created. Nothing is
+    rasterized, so memory mapping the file makes loading the atlas almost free:
+
+        const void *img = nk_font_atlas_load(&atlas, mapped, mapped_size, &w, &h, NK_FONT_ATLAS_RGBA32);
+        if (!img) {
+            img = nk_font_atlas_bake(&atlas, &w, &h, NK_FONT_ATLAS_RGBA32);
+            size = nk_font_atlas_save(&atlas, NK_FONT_ATLAS_RGBA32, 0, 0);
+            nk_font_atlas_save(&atlas, NK_FONT_ATLAS_RGBA32, memory_of(size), size);
+        }
+        upload(texture, img, w, h);
+        nk_font_atlas_end(&atlas, nk_handle_id(texture), 0);
 */
 struct nk_user_font_glyph;
 typedef float(*nk_text_width_f)(nk_handle, float h, const char*, int len);
@@ -3860,6 +4039,55 @@ struct nk_user_font {
 #endif
 };
 
+/* Text width cache: a bounded least recently used table of string widths that
+ * `nk_cached_font` puts in front of another font's width callback. Widgets measure
+ * the same labels every frame, with the cache a static UI only pays for hashing them.
+
+        struct nk_text_width_cache cache;
+        struct nk_cached_font cached;
+        nk_text_width_cache_init_default(&cache, 1024);
+        nk_cached_font_init(&cached, &font->handle, &cache);
+        nk_style_set_font(&ctx, &cached.handle);
+
+    Entries are keyed by font, height, length and two hashes of the string. Call
+    `nk_text_width_cache_clear` when the measured fonts change, for example after
+    baking the atlas again, and `nk_cached_font_init` again after `nk_font_atlas_end`.
+
+    The cache pays off for long labels and for scripts with expensive glyph lookups.
+    Strings shorter than NK_TEXT_WIDTH_CACHE_MIN_LEN bytes are not cached, and a frame
+    of mostly short or changing strings gains little to nothing. Check the `hits` and
+    `misses` counters before turning it on. */
+struct nk_text_width_entry {
+    const struct nk_user_font *font;
+    nk_hash hash, check;
+    float height, width;
+    int len;
+    int next; /* next entry in the same bucket */
+    int prev_used, next_used; /* least recently used list */
+};
+struct nk_text_width_cache {
+    struct nk_allocator alloc;
+    struct nk_text_width_entry *entries;
+    int *buckets;
+    int capacity, bucket_mask, count;
+    int newest, oldest;
+    nk_uint hits; /* widths returned from the cache */
+    nk_uint misses; /* widths measured by the font */
+    nk_uint evictions; /* entries replaced once the cache was full */
+};
+struct nk_cached_font {
+    struct nk_user_font handle; /* pass this to nuklear in place of the font */
+    const struct nk_user_font *font;
+    struct nk_text_width_cache *cache;
+};
+NK_API void nk_text_width_cache_init(struct nk_text_width_cache*, const struct nk_allocator*, int capacity);
+#ifdef NK_INCLUDE_DEFAULT_ALLOCATOR
+NK_API void nk_text_width_cache_init_default(struct nk_text_width_cache*, int capacity);
+#endif
+NK_API void nk_text_width_cache_free(struct nk_text_width_cache*);
+NK_API void nk_text_width_cache_clear(struct nk_text_width_cache*);
+NK_API void nk_cached_font_init(struct nk_cached_font*, const struct nk_user_font*, struct nk_text_width_cache*);
+
 #ifdef NK_INCLUDE_FONT_BAKING
 enum nk_font_coord_type {
     NK_COORD_UV, /* texture coordinates inside font glyphs are clamped between 0-1 */
@@ -3923,6 +4151,7 @@ struct nk_font_glyph {
     float u0, v0, u1, v1;
 };
 
+struct nk_font_atlas_dynamic;
 struct nk_font {
     struct nk_font *next;
     struct nk_user_font handle;
@@ -3933,6 +4162,13 @@ struct nk_font {
     nk_rune fallback_codepoint;
     nk_handle texture;
     struct nk_font_config *config;
+    /* glyph lookup built by nk_font_atlas_bake: one entry per 256 codepoint page up to
+     * `lookup_end`, holding the offset of the page's 256 entries or 0 if no glyph falls into
+     * it. Each page entry is the glyph index + 1, or 0 if the codepoint is not baked. The first
+     * page always exists, so ASCII and Latin-1 are a direct index */
+    nk_uint *lookup;
+    nk_rune lookup_end;
+    struct nk_font_atlas_dynamic *dynamic; /* atlas rasterizing glyphs on demand */
 };
 
 enum nk_font_atlas_format {
@@ -3940,6 +4176,11 @@ enum nk_font_atlas_format {
     NK_FONT_ATLAS_RGBA32
 };
 
+/* glyph rasterization jobs (nk_font_atlas_bake) */
+typedef void(*nk_font_bake_job)(void *data, int index, int worker);
+/* has to call job(data, i, worker) for every i in [0, count) and only return once all of them finished */
+typedef void(*nk_font_bake_dispatch)(nk_handle scheduler, int count, nk_font_bake_job job, void *data);
+
 struct nk_font_atlas {
     void *pixel;
     int tex_width;
@@ -3957,6 +4198,9 @@ struct nk_font_atlas {
     struct nk_font *fonts;
     struct nk_font_config *config;
     int font_num;
+    struct nk_font_atlas_dynamic *dynamic; /* set by nk_font_atlas_bake_dynamic */
+    nk_font_bake_dispatch dispatch; /* optional, glyphs are rasterized on the calling thread if not set */
+    nk_handle scheduler;
 };
 
 /* some language glyph codepoint ranges */
@@ -3983,7 +4227,12 @@ NK_API struct nk_font* nk_font_atlas_add_from_file(struct nk_font_atlas *atlas,
 NK_API struct nk_font *nk_font_atlas_add_compressed(struct nk_font_atlas*, void *memory, nk_size size, float height, const struct nk_font_config*);
 NK_API struct nk_font* nk_font_atlas_add_compressed_base85(struct nk_font_atlas*, const char *data, float height, const struct nk_font_config *config);
 NK_API const void* nk_font_atlas_bake(struct nk_font_atlas*, int *width, int *height, enum nk_font_atlas_format);
+NK_API const void* nk_font_atlas_bake_dynamic(struct nk_font_atlas*, int width, int height, enum nk_font_atlas_format);
+NK_API nk_size nk_font_atlas_save(struct nk_font_atlas*, enum nk_font_atlas_format, void *memory, nk_size size);
+NK_API const void* nk_font_atlas_load(struct nk_font_atlas*, const void *memory, nk_size size, int *width, int *height, enum nk_font_atlas_format);
 NK_API void nk_font_atlas_end(struct nk_font_atlas*, nk_handle tex, struct nk_draw_null_texture*);
+NK_API void nk_font_atlas_prepare(struct nk_font_atlas*, struct nk_context*);
+NK_API int nk_font_atlas_dirty(struct nk_font_atlas*, struct nk_recti *rect);
 NK_API const struct nk_font_glyph* nk_font_find_glyph(struct nk_font*, nk_rune unicode);
 NK_API void nk_font_atlas_cleanup(struct nk_font_atlas *atlas);
 NK_API void nk_font_atlas_clear(struct nk_font_atlas*);
@@ -4326,6 +4575,7 @@ enum nk_command_type {
     NK_COMMAND_IMAGE,
     NK_COMMAND_CUSTOM
 };
+#define NK_COMMAND_TYPE_COUNT (NK_COMMAND_CUSTOM + 1)
 
 /* command base and header of every command inside the buffer */
 struct nk_command {
@@ -4501,6 +4751,28 @@ struct nk_command_buffer {
     nk_size begin, end, last;
 };
 
+/* damage tracking (nk_damage_update) */
+struct nk_damage {
+    struct nk_buffer commands[2]; /* hash and bounds of every command, current and last frame */
+    struct nk_buffer units[2]; /* command ranges of every window, popup and the overlay */
+    int current; /* buffers of the last call */
+    int valid; /* false before the first call and after nk_damage_invalidate */
+};
+NK_API void nk_damage_init(struct nk_damage*, const struct nk_allocator*);
+#ifdef NK_INCLUDE_DEFAULT_ALLOCATOR
+NK_API void nk_damage_init_default(struct nk_damage*);
+#endif
+NK_API void nk_damage_free(struct nk_damage*);
+NK_API void nk_damage_invalidate(struct nk_damage*);
+
+/* command list optimization (nk_optimize_commands) */
+struct nk_optimize_stats {
+    int commands[NK_COMMAND_TYPE_COUNT]; /* commands of each type found */
+    int removed[NK_COMMAND_TYPE_COUNT]; /* commands of each type unlinked or merged into another */
+    int occluded[NK_COMMAND_TYPE_COUNT]; /* removed ones hidden behind a window on top */
+};
+NK_API const char *nk_command_type_name(enum nk_command_type);
+
 /* shape outlines */
 NK_API void nk_stroke_line(struct nk_command_buffer *b, float x0, float y0, float x1, float y1, float line_thickness, struct nk_color);
 NK_API void nk_stroke_curve(struct nk_command_buffer*, float, float, float, float, float, float, float, float, float line_thickness, struct nk_color);
@@ -4653,8 +4925,18 @@ struct nk_draw_vertex_layout_element {
 struct nk_draw_command {
     unsigned int elem_count;
     /* number of elements in the current draw batch */
+    unsigned int vertex_offset;
+    /* base vertex added to every element of this batch (always 0 with NK_UINT_DRAW_INDEX) */
+    int quads;
+    /* batch of quads that uses the shared quad elements (see `nk_convert_config.quad_batch`)
+     * instead of the element buffer */
+    int instances;
+    /* batch of `elem_count / 6` nk_draw_quad_instance records starting at vertex
+     * `vertex_offset` (see `nk_convert_config.quad_instances`), no elements */
     struct nk_rect clip_rect;
     /* current screen clipping rectangle */
+    struct nk_rect bounds;
+    /* screen area the batch draws into before clipping, empty if unknown */
     nk_handle texture;
     /* current texture to set */
 #ifdef NK_INCLUDE_COMMAND_USERDATA
@@ -4662,9 +4944,40 @@ struct nk_draw_command {
 #endif
 };
 
+/* An axis aligned quad as written by `nk_convert` with `quad_instances` set.
+ * It occupies NK_DRAW_QUAD_INSTANCE_SLOTS(vertex_size) vertices of the vertex
+ * buffer, the backend draws it as the two triangles a-b-c a-c-d with
+ * b = (c.x, a.y) and d = (a.x, c.y), uv alike. */
+struct nk_draw_quad_instance {
+    struct nk_vec2 a, c;
+    struct nk_vec2 uva, uvc;
+    struct nk_color col;
+};
+#define NK_DRAW_QUAD_INSTANCE_SLOTS(vertex_size)\
+    ((sizeof(struct nk_draw_quad_instance) + (vertex_size) - 1) / (vertex_size))
+
+enum nk_draw_vertex_writer {
+    NK_VERTEX_WRITER_GENERIC,
+    /* {float2 position, float2 uv, rgba8 color} packed into 20 bytes in that order */
+    NK_VERTEX_WRITER_XY_UV_RGBA8_PACKED,
+    /* float2 position, float2 uv and a color at arbitrary 4 byte aligned offsets */
+    NK_VERTEX_WRITER_XY_UV_RGBA8,
+    NK_VERTEX_WRITER_XY_UV_BGRA8,
+    NK_VERTEX_WRITER_XY_UV_RGBA32F
+};
+
+struct nk_draw_circle_table {
+    unsigned short segments;
+    unsigned short offset; /* first point in nk_draw_list.circle_lut */
+};
+
 struct nk_draw_list {
     struct nk_rect clip_rect;
     struct nk_vec2 circle_vtx[12];
+    struct nk_vec2 circle_lut[NK_DRAW_LIST_CIRCLE_LUT]; /* unit circles filled on first use */
+    struct nk_draw_circle_table circle_tables[32];
+    unsigned int circle_table_count;
+    unsigned int circle_lut_count;
     struct nk_convert_config config;
 
     struct nk_buffer *buffer;
@@ -4673,6 +4986,10 @@ struct nk_draw_list {
 
     unsigned int element_count;
     unsigned int vertex_count;
+    unsigned int vertex_base;
+    unsigned int quad_run;
+    unsigned int instance_run;
+    struct nk_draw_quad_instance instance_pending[NK_DRAW_LIST_QUAD_RUN];
     unsigned int cmd_count;
     nk_size cmd_offset;
 
@@ -4682,11 +4999,48 @@ struct nk_draw_list {
     enum nk_anti_aliasing line_AA;
     enum nk_anti_aliasing shape_AA;
 
+    enum nk_draw_vertex_writer vertex_writer;
+    nk_size vertex_offset[NK_VERTEX_ATTRIBUTE_COUNT];
+
 #ifdef NK_INCLUDE_COMMAND_USERDATA
     nk_handle userdata;
 #endif
 };
 
+/* window by window conversion (nk_convert_windows) */
+typedef void(*nk_convert_job)(void *data, int index, int worker);
+/* has to call job(data, i, worker) for every i in [0, count) and only return once all of them finished */
+typedef void(*nk_convert_dispatch)(nk_handle scheduler, int count, nk_convert_job job, void *data);
+
+struct nk_convert_unit;
+struct nk_convert_state {
+    struct nk_allocator pool;
+    nk_convert_dispatch dispatch; /* optional, units are converted in order on the calling thread if not set */
+    nk_handle scheduler;
+    struct nk_convert_unit *units;
+    int unit_count;
+    int unit_capacity;
+    int units_reused; /* units of the last call that were not converted again */
+};
+NK_API void nk_convert_state_init(struct nk_convert_state*, const struct nk_allocator*);
+#ifdef NK_INCLUDE_DEFAULT_ALLOCATOR
+NK_API void nk_convert_state_init_default(struct nk_convert_state*);
+#endif
+NK_API void nk_convert_state_free(struct nk_convert_state*);
+NK_API void nk_convert_state_invalidate(struct nk_convert_state*);
+
+/* draw command merging (nk_draw_merge) */
+struct nk_draw_merge {
+    struct nk_buffer scratch; /* copies of the draw commands and their groups */
+    int draws_before; /* draw calls of the last call before merging */
+    int draws_after; /* draw calls of the last call after merging */
+};
+NK_API void nk_draw_merge_init(struct nk_draw_merge*, const struct nk_allocator*);
+#ifdef NK_INCLUDE_DEFAULT_ALLOCATOR
+NK_API void nk_draw_merge_init_default(struct nk_draw_merge*);
+#endif
+NK_API void nk_draw_merge_free(struct nk_draw_merge*);
+
 /* draw list */
 NK_API void nk_draw_list_init(struct nk_draw_list*);
 NK_API void nk_draw_list_setup(struct nk_draw_list*, const struct nk_convert_config*, struct nk_buffer *cmds, struct nk_buffer *vertices, struct nk_buffer *elements, enum nk_anti_aliasing line_aa,enum nk_anti_aliasing shape_aa);
@@ -5633,6 +5987,16 @@ template<typename T> struct nk_alignof{struct Big {T x; char c;}; enum {
 #define NK_BUFFER_DEFAULT_INITIAL_SIZE (4*1024)
 #endif
 
+#ifndef NK_DRAW_MERGE_WINDOW
+#define NK_DRAW_MERGE_WINDOW 64
+#endif
+#ifndef NK_OPTIMIZE_OCCLUDERS
+#define NK_OPTIMIZE_OCCLUDERS 32
+#endif
+#ifndef NK_TEXT_WIDTH_CACHE_MIN_LEN
+#define NK_TEXT_WIDTH_CACHE_MIN_LEN 4
+#endif
+
 /* standard library headers */
 #ifdef NK_INCLUDE_DEFAULT_ALLOCATOR
 #include <stdlib.h> /* malloc, free */
@@ -9140,6 +9504,150 @@ nk_draw_text(struct nk_command_buffer *b, struct nk_rect r,
     NK_MEMCPY(cmd->string, string, (nk_size)length);
     cmd->string[length] = '\0';
 }
+/* bytes of a command up to the end of its last member, without the padding
+ * behind it that is only initialized with NK_ZERO_COMMAND_MEMORY */
+#define NK_COMMAND_END(st, m, n) (NK_OFFSETOF(st, m) + (n))
+NK_INTERN nk_hash
+nk_command_hash(const struct nk_command *cmd, nk_hash seed)
+{
+    /* skip the header: `next` moves whenever anything before the command changes */
+    const nk_byte *base = (const nk_byte*)cmd;
+    nk_size begin = sizeof(struct nk_command), end;
+    seed = nk_murmur_hash(&cmd->type, (int)sizeof(cmd->type), seed);
+#ifdef NK_INCLUDE_COMMAND_USERDATA
+    seed = nk_murmur_hash(&cmd->userdata, (int)sizeof(cmd->userdata), seed);
+#endif
+    switch (cmd->type) {
+    case NK_COMMAND_SCISSOR:
+        end = NK_COMMAND_END(struct nk_command_scissor, h, sizeof(unsigned short)); break;
+    case NK_COMMAND_LINE:
+        end = NK_COMMAND_END(struct nk_command_line, color, sizeof(struct nk_color)); break;
+    case NK_COMMAND_CURVE:
+        end = NK_COMMAND_END(struct nk_command_curve, color, sizeof(struct nk_color)); break;
+    case NK_COMMAND_RECT:
+        end = NK_COMMAND_END(struct nk_command_rect, color, sizeof(struct nk_color)); break;
+    case NK_COMMAND_RECT_FILLED:
+        end = NK_COMMAND_END(struct nk_command_rect_filled, color, sizeof(struct nk_color)); break;
+    case NK_COMMAND_RECT_MULTI_COLOR:
+        end = NK_COMMAND_END(struct nk_command_rect_multi_color, right, sizeof(struct nk_color)); break;
+    case NK_COMMAND_CIRCLE:
+        end = NK_COMMAND_END(struct nk_command_circle, color, sizeof(struct nk_color)); break;
+    case NK_COMMAND_CIRCLE_FILLED:
+        end = NK_COMMAND_END(struct nk_command_circle_filled, color, sizeof(struct nk_color)); break;
+    case NK_COMMAND_ARC:
+        end = NK_COMMAND_END(struct nk_command_arc, color, sizeof(struct nk_color)); break;
+    case NK_COMMAND_ARC_FILLED:
+        /* padding between the radius and the angles */
+        end = NK_COMMAND_END(struct nk_command_arc_filled, r, sizeof(unsigned short));
+        seed = nk_murmur_hash(base + begin, (int)(end - begin), seed);
+        begin = NK_OFFSETOF(struct nk_command_arc_filled, a);
+        end = NK_COMMAND_END(struct nk_command_arc_filled, color, sizeof(struct nk_color)); break;
+    case NK_COMMAND_TRIANGLE:
+        end = NK_COMMAND_END(struct nk_command_triangle, color, sizeof(struct nk_color)); break;
+    case NK_COMMAND_TRIANGLE_FILLED:
+        end = NK_COMMAND_END(struct nk_command_triangle_filled, color, sizeof(struct nk_color)); break;
+    case NK_COMMAND_POLYGON:
+        end = NK_COMMAND_END(struct nk_command_polygon, points, sizeof(struct nk_vec2i) *
+            ((const struct nk_command_polygon*)cmd)->point_count); break;
+    case NK_COMMAND_POLYGON_FILLED:
+        end = NK_COMMAND_END(struct nk_command_polygon_filled, points, sizeof(struct nk_vec2i) *
+            ((const struct nk_command_polygon_filled*)cmd)->point_count); break;
+    case NK_COMMAND_POLYLINE:
+        end = NK_COMMAND_END(struct nk_command_polyline, points, sizeof(struct nk_vec2i) *
+            ((const struct nk_command_polyline*)cmd)->point_count); break;
+    case NK_COMMAND_TEXT:
+        end = NK_COMMAND_END(struct nk_command_text, string,
+            (nk_size)((const struct nk_command_text*)cmd)->length); break;
+    case NK_COMMAND_IMAGE: {
+        /* struct nk_image ends in padding */
+        const struct nk_command_image *img = (const struct nk_command_image*)cmd;
+        end = NK_COMMAND_END(struct nk_command_image, img.region, sizeof(img->img.region));
+        seed = nk_murmur_hash(base + begin, (int)(end - begin), seed);
+        begin = NK_OFFSETOF(struct nk_command_image, col);
+        end = NK_COMMAND_END(struct nk_command_image, col, sizeof(struct nk_color));
+    } break;
+    case NK_COMMAND_CUSTOM:
+        end = NK_COMMAND_END(struct nk_command_custom, callback, sizeof(nk_command_custom_callback)); break;
+    default: end = begin; break;
+    }
+    return nk_murmur_hash(base + begin, (int)(end - begin), seed);
+}
+/* Splits the queue into the window, popup and overlay buffers nk_build linked, in
+ * queue order. Every command has to be passed to nk_command_units_next in turn,
+ * which only looks at the windows once for the whole queue. */
+struct nk_command_units {
+    const struct nk_window *win; /* next window to link */
+    const struct nk_window *popup; /* next window whose popup may be linked */
+    nk_size next; /* start of the next window, all ones once popups follow */
+    nk_size last; /* last command of the current unit */
+    nk_size prev; /* previous command, all ones before the first */
+};
+NK_INTERN int
+nk_command_window_linked(const struct nk_context *ctx, const struct nk_window *win)
+{
+    /* the windows nk_build links */
+    return win->buffer.last != win->buffer.begin && !(win->flags & NK_WINDOW_HIDDEN) &&
+        win->seq == ctx->seq;
+}
+NK_INTERN void
+nk_command_units_window(const struct nk_context *ctx, struct nk_command_units *units)
+{
+    while (units->win) {
+        const struct nk_window *win = units->win;
+        if (nk_command_window_linked(ctx, win)) {
+            units->next = win->buffer.begin;
+            return;
+        }
+        units->win = win->next;
+    }
+    units->next = ~(nk_size)0;
+}
+NK_INTERN void
+nk_command_units_begin(const struct nk_context *ctx, struct nk_command_units *units)
+{
+    units->win = ctx->begin;
+    units->popup = ctx->begin;
+    units->last = ~(nk_size)0;
+    units->prev = ~(nk_size)0;
+    nk_command_units_window(ctx, units);
+}
+/* true if `cmd` starts the commands of a window, popup or the overlay. `id` is set
+ * to a value identifying that buffer across frames. */
+NK_INTERN int
+nk_command_units_next(const struct nk_context *ctx, struct nk_command_units *units,
+    const struct nk_command *cmd, nk_hash *id)
+{
+    nk_size offset = (nk_size)((const nk_byte*)cmd - (const nk_byte*)ctx->memory.memory.ptr);
+    nk_size prev = units->prev;
+    units->prev = offset;
+    if (prev != ~(nk_size)0 && prev != units->last)
+        return nk_false;
+
+    if (ctx->overlay.end != ctx->overlay.begin && offset == ctx->overlay.begin) {
+        units->last = ctx->overlay.last;
+        if (id) *id = 0;
+        return nk_true;
+    }
+    if (offset == units->next) {
+        units->last = units->win->buffer.last;
+        if (id) *id = units->win->name;
+        units->win = units->win->next;
+        nk_command_units_window(ctx, units);
+        return nk_true;
+    }
+    /* popups are linked after all windows in window order */
+    while (units->popup && units->popup->popup.buf.begin != offset)
+        units->popup = units->popup->next;
+    if (units->popup) {
+        units->last = units->popup->popup.buf.last;
+        if (id) *id = ~units->popup->name;
+        units->popup = units->popup->next;
+    } else {
+        units->last = ~(nk_size)0;
+        if (id) *id = 0;
+    }
+    return nk_true;
+}
 
 
 
@@ -9147,143 +9655,923 @@ nk_draw_text(struct nk_command_buffer *b, struct nk_rect r,
 
 /* ===============================================================
  *
- *                              VERTEX
+ *                              DAMAGE
  *
  * ===============================================================*/
-#ifdef NK_INCLUDE_VERTEX_BUFFER_OUTPUT
+struct nk_damage_command {
+    nk_hash hash;
+    struct nk_rect bounds;
+};
+struct nk_damage_unit {
+    nk_hash id;
+    int first, count;
+    struct nk_rect bounds;
+    int matched;
+};
 NK_API void
-nk_draw_list_init(struct nk_draw_list *list)
+nk_damage_init(struct nk_damage *damage, const struct nk_allocator *alloc)
 {
-    nk_size i = 0;
-    NK_ASSERT(list);
-    if (!list) return;
-    nk_zero(list, sizeof(*list));
-    for (i = 0; i < NK_LEN(list->circle_vtx); ++i) {
-        const float a = ((float)i / (float)NK_LEN(list->circle_vtx)) * 2 * NK_PI;
-        list->circle_vtx[i].x = (float)NK_COS(a);
-        list->circle_vtx[i].y = (float)NK_SIN(a);
+    int i;
+    NK_ASSERT(damage);
+    NK_ASSERT(alloc);
+    if (!damage || !alloc) return;
+    nk_zero(damage, sizeof(*damage));
+    for (i = 0; i < 2; ++i) {
+        nk_buffer_init(&damage->commands[i], alloc, NK_BUFFER_DEFAULT_INITIAL_SIZE);
+        nk_buffer_init(&damage->units[i], alloc, NK_BUFFER_DEFAULT_INITIAL_SIZE);
     }
 }
+#ifdef NK_INCLUDE_DEFAULT_ALLOCATOR
 NK_API void
-nk_draw_list_setup(struct nk_draw_list *canvas, const struct nk_convert_config *config,
-    struct nk_buffer *cmds, struct nk_buffer *vertices, struct nk_buffer *elements,
-    enum nk_anti_aliasing line_aa, enum nk_anti_aliasing shape_aa)
+nk_damage_init_default(struct nk_damage *damage)
 {
-    NK_ASSERT(canvas);
-    NK_ASSERT(config);
-    NK_ASSERT(cmds);
-    NK_ASSERT(vertices);
-    NK_ASSERT(elements);
-    if (!canvas || !config || !cmds || !vertices || !elements)
-        return;
-
-    canvas->buffer = cmds;
-    canvas->config = *config;
-    canvas->elements = elements;
-    canvas->vertices = vertices;
-    canvas->line_AA = line_aa;
-    canvas->shape_AA = shape_aa;
-    canvas->clip_rect = nk_null_rect;
-
-    canvas->cmd_offset = 0;
-    canvas->element_count = 0;
-    canvas->vertex_count = 0;
-    canvas->cmd_offset = 0;
-    canvas->cmd_count = 0;
-    canvas->path_count = 0;
+    struct nk_allocator alloc;
+    alloc.userdata.ptr = 0;
+    alloc.alloc = nk_malloc;
+    alloc.free = nk_mfree;
+    nk_damage_init(damage, &alloc);
 }
-NK_API const struct nk_draw_command*
-nk__draw_list_begin(const struct nk_draw_list *canvas, const struct nk_buffer *buffer)
+#endif
+NK_API void
+nk_damage_free(struct nk_damage *damage)
 {
-    nk_byte *memory;
-    nk_size offset;
-    const struct nk_draw_command *cmd;
-
-    NK_ASSERT(buffer);
-    if (!buffer || !buffer->size || !canvas->cmd_count)
-        return 0;
-
-    memory = (nk_byte*)buffer->memory.ptr;
-    offset = buffer->memory.size - canvas->cmd_offset;
-    cmd = nk_ptr_add(const struct nk_draw_command, memory, offset);
-    return cmd;
+    int i;
+    NK_ASSERT(damage);
+    if (!damage) return;
+    for (i = 0; i < 2; ++i) {
+        nk_buffer_free(&damage->commands[i]);
+        nk_buffer_free(&damage->units[i]);
+    }
+    damage->valid = nk_false;
 }
-NK_API const struct nk_draw_command*
-nk__draw_list_end(const struct nk_draw_list *canvas, const struct nk_buffer *buffer)
+NK_API void
+nk_damage_invalidate(struct nk_damage *damage)
 {
-    nk_size size;
-    nk_size offset;
-    nk_byte *memory;
-    const struct nk_draw_command *end;
-
-    NK_ASSERT(buffer);
-    NK_ASSERT(canvas);
-    if (!buffer || !canvas)
-        return 0;
-
-    memory = (nk_byte*)buffer->memory.ptr;
-    size = buffer->memory.size;
-    offset = size - canvas->cmd_offset;
-    end = nk_ptr_add(const struct nk_draw_command, memory, offset);
-    end -= (canvas->cmd_count-1);
-    return end;
+    NK_ASSERT(damage);
+    if (!damage) return;
+    damage->valid = nk_false;
 }
-NK_API const struct nk_draw_command*
-nk__draw_list_next(const struct nk_draw_command *cmd,
-    const struct nk_buffer *buffer, const struct nk_draw_list *canvas)
+NK_INTERN struct nk_rect
+nk_damage_union(struct nk_rect a, struct nk_rect b)
 {
-    const struct nk_draw_command *end;
-    NK_ASSERT(buffer);
-    NK_ASSERT(canvas);
-    if (!cmd || !buffer || !canvas)
-        return 0;
-
-    end = nk__draw_list_end(canvas, buffer);
-    if (cmd <= end) return 0;
-    return (cmd-1);
+    float x0, y0, x1, y1;
+    if (a.w <= 0 || a.h <= 0) return b;
+    if (b.w <= 0 || b.h <= 0) return a;
+    x0 = NK_MIN(a.x, b.x);
+    y0 = NK_MIN(a.y, b.y);
+    x1 = NK_MAX(a.x + a.w, b.x + b.w);
+    y1 = NK_MAX(a.y + a.h, b.y + b.h);
+    return nk_rect(x0, y0, x1 - x0, y1 - y0);
 }
-NK_INTERN struct nk_vec2*
-nk_draw_list_alloc_path(struct nk_draw_list *list, int count)
+NK_INTERN struct nk_rect
+nk_damage_points(const struct nk_vec2i *points, int count, float pad)
 {
-    struct nk_vec2 *points;
-    NK_STORAGE const nk_size point_align = NK_ALIGNOF(struct nk_vec2);
-    NK_STORAGE const nk_size point_size = sizeof(struct nk_vec2);
-    points = (struct nk_vec2*)
-        nk_buffer_alloc(list->buffer, NK_BUFFER_FRONT,
-                        point_size * (nk_size)count, point_align);
-
-    if (!points) return 0;
-    if (!list->path_offset) {
-        void *memory = nk_buffer_memory(list->buffer);
-        list->path_offset = (unsigned int)((nk_byte*)points - (nk_byte*)memory);
+    float x0 = points[0].x, y0 = points[0].y, x1 = x0, y1 = y0;
+    int i;
+    for (i = 1; i < count; ++i) {
+        x0 = NK_MIN(x0, points[i].x); y0 = NK_MIN(y0, points[i].y);
+        x1 = NK_MAX(x1, points[i].x); y1 = NK_MAX(y1, points[i].y);
+    }
+    return nk_rect(x0 - pad, y0 - pad, x1 - x0 + 2 * pad, y1 - y0 + 2 * pad);
+}
+NK_INTERN struct nk_rect
+nk_damage_box(float x, float y, float w, float h, float pad)
+{
+    return nk_rect(x - pad, y - pad, w + 2 * pad, h + 2 * pad);
+}
+/* area a command draws into, including half the stroke width and the
+ * anti-aliasing fringe */
+NK_INTERN struct nk_rect
+nk_damage_command_bounds(const struct nk_command *cmd)
+{
+    switch (cmd->type) {
+    case NK_COMMAND_LINE: {
+        const struct nk_command_line *c = (const struct nk_command_line*)cmd;
+        struct nk_vec2i p[2];
+        p[0] = c->begin; p[1] = c->end;
+        return nk_damage_points(p, 2, c->line_thickness + 1);
+    }
+    case NK_COMMAND_CURVE: {
+        const struct nk_command_curve *c = (const struct nk_command_curve*)cmd;
+        struct nk_vec2i p[4];
+        p[0] = c->begin; p[1] = c->ctrl[0]; p[2] = c->ctrl[1]; p[3] = c->end;
+        return nk_damage_points(p, 4, c->line_thickness + 1);
+    }
+    case NK_COMMAND_RECT: {
+        const struct nk_command_rect *c = (const struct nk_command_rect*)cmd;
+        return nk_damage_box(c->x, c->y, c->w, c->h, c->line_thickness + 1);
+    }
+    case NK_COMMAND_RECT_FILLED: {
+        const struct nk_command_rect_filled *c = (const struct nk_command_rect_filled*)cmd;
+        return nk_damage_box(c->x, c->y, c->w, c->h, 1);
+    }
+    case NK_COMMAND_RECT_MULTI_COLOR: {
+        const struct nk_command_rect_multi_color *c = (const struct nk_command_rect_multi_color*)cmd;
+        return nk_damage_box(c->x, c->y, c->w, c->h, 1);
+    }
+    case NK_COMMAND_CIRCLE: {
+        const struct nk_command_circle *c = (const struct nk_command_circle*)cmd;
+        return nk_damage_box(c->x, c->y, c->w, c->h, c->line_thickness + 1);
+    }
+    case NK_COMMAND_CIRCLE_FILLED: {
+        const struct nk_command_circle_filled *c = (const struct nk_command_circle_filled*)cmd;
+        return nk_damage_box(c->x, c->y, c->w, c->h, 1);
+    }
+    case NK_COMMAND_ARC: {
+        const struct nk_command_arc *c = (const struct nk_command_arc*)cmd;
+        return nk_damage_box(c->cx - c->r, c->cy - c->r, 2 * c->r, 2 * c->r, c->line_thickness + 1);
+    }
+    case NK_COMMAND_ARC_FILLED: {
+        const struct nk_command_arc_filled *c = (const struct nk_command_arc_filled*)cmd;
+        return nk_damage_box(c->cx - c->r, c->cy - c->r, 2 * c->r, 2 * c->r, 1);
+    }
+    case NK_COMMAND_TRIANGLE: {
+        const struct nk_command_triangle *c = (const struct nk_command_triangle*)cmd;
+        struct nk_vec2i p[3];
+        p[0] = c->a; p[1] = c->b; p[2] = c->c;
+        return nk_damage_points(p, 3, c->line_thickness + 1);
+    }
+    case NK_COMMAND_TRIANGLE_FILLED: {
+        const struct nk_command_triangle_filled *c = (const struct nk_command_triangle_filled*)cmd;
+        struct nk_vec2i p[3];
+        p[0] = c->a; p[1] = c->b; p[2] = c->c;
+        return nk_damage_points(p, 3, 1);
+    }
+    case NK_COMMAND_POLYGON: {
+        const struct nk_command_polygon *c = (const struct nk_command_polygon*)cmd;
+        if (!c->point_count) break;
+        return nk_damage_points(c->points, c->point_count, c->line_thickness + 1);
+    }
+    case NK_COMMAND_POLYGON_FILLED: {
+        const struct nk_command_polygon_filled *c = (const struct nk_command_polygon_filled*)cmd;
+        if (!c->point_count) break;
+        return nk_damage_points(c->points, c->point_count, 1);
+    }
+    case NK_COMMAND_POLYLINE: {
+        const struct nk_command_polyline *c = (const struct nk_command_polyline*)cmd;
+        if (!c->point_count) break;
+        return nk_damage_points(c->points, c->point_count, c->line_thickness + 1);
+    }
+    case NK_COMMAND_TEXT: {
+        const struct nk_command_text *c = (const struct nk_command_text*)cmd;
+        return nk_damage_box(c->x, c->y, c->w, NK_MAX(c->h, c->height), 2);
+    }
+    case NK_COMMAND_IMAGE: {
+        const struct nk_command_image *c = (const struct nk_command_image*)cmd;
+        return nk_damage_box(c->x, c->y, c->w, c->h, 1);
+    }
+    case NK_COMMAND_CUSTOM: {
+        const struct nk_command_custom *c = (const struct nk_command_custom*)cmd;
+        return nk_damage_box(c->x, c->y, c->w, c->h, 1);
     }
-    list->path_count += (unsigned int)count;
-    return points;
+    default: break;
+    }
+    return nk_rect(0,0,0,0);
 }
-NK_INTERN struct nk_vec2
-nk_draw_list_path_last(struct nk_draw_list *list)
+NK_INTERN struct nk_rect
+nk_damage_commands(const struct nk_damage_command *cmds, int count)
 {
-    void *memory;
-    struct nk_vec2 *point;
-    NK_ASSERT(list->path_count);
-    memory = nk_buffer_memory(list->buffer);
-    point = nk_ptr_add(struct nk_vec2, memory, list->path_offset);
-    point += (list->path_count-1);
-    return *point;
+    struct nk_rect area = nk_rect(0,0,0,0);
+    int i;
+    for (i = 0; i < count; ++i)
+        area = nk_damage_union(area, cmds[i].bounds);
+    return area;
+}
+/* area changed between two versions of the same window */
+NK_INTERN struct nk_rect
+nk_damage_diff(const struct nk_damage_command *cur, int cur_count,
+    const struct nk_damage_command *prev, int prev_count)
+{
+    struct nk_rect area = nk_rect(0,0,0,0);
+    int i, head = 0, tail = 0;
+    if (cur_count == prev_count) {
+        /* same layout, compare command by command */
+        for (i = 0; i < cur_count; ++i) {
+            if (cur[i].hash == prev[i].hash) continue;
+            area = nk_damage_union(area, cur[i].bounds);
+            area = nk_damage_union(area, prev[i].bounds);
+        }
+        return area;
+    }
+    /* commands were added or removed, only the part between the common head
+     * and tail changed (a text cursor appearing for example) */
+    while (head < cur_count && head < prev_count && cur[head].hash == prev[head].hash)
+        head++;
+    while (tail < cur_count - head && tail < prev_count - head &&
+        cur[cur_count-tail-1].hash == prev[prev_count-tail-1].hash)
+        tail++;
+    area = nk_damage_commands(cur + head, cur_count - head - tail);
+    return nk_damage_union(area, nk_damage_commands(prev + head, prev_count - head - tail));
 }
-NK_INTERN struct nk_draw_command*
-nk_draw_list_push_command(struct nk_draw_list *list, struct nk_rect clip,
-    nk_handle texture)
-{
-    NK_STORAGE const nk_size cmd_align = NK_ALIGNOF(struct nk_draw_command);
-    NK_STORAGE const nk_size cmd_size = sizeof(struct nk_draw_command);
-    struct nk_draw_command *cmd;
-
-    NK_ASSERT(list);
-    cmd = (struct nk_draw_command*)
-        nk_buffer_alloc(list->buffer, NK_BUFFER_BACK, cmd_size, cmd_align);
+NK_API struct nk_rect
+nk_damage_update(struct nk_damage *damage, struct nk_context *ctx, struct nk_rect screen)
+{
+    struct nk_damage_command *cmds, *prev_cmds;
+    struct nk_damage_unit *units, *prev_units;
+    struct nk_damage_unit *unit = 0;
+    struct nk_command_units queue;
+    struct nk_buffer *cmd_buf, *unit_buf;
+    struct nk_rect area = nk_rect(0,0,0,0);
+    struct nk_rect clip = nk_null_rect;
+    const struct nk_command *cmd;
+    int unit_count, prev_count, last_match = -1;
+    int cmd_count = 0, i, j;
+    float x0, y0, x1, y1;
 
-    if (!cmd) return 0;
+    NK_ASSERT(damage);
+    NK_ASSERT(ctx);
+    if (!damage || !ctx) return screen;
+
+    /* record hash and bounds of every command, split into units like nk_build linked them */
+    damage->current = !damage->current;
+    cmd_buf = &damage->commands[damage->current];
+    unit_buf = &damage->units[damage->current];
+    nk_buffer_clear(cmd_buf);
+    nk_buffer_clear(unit_buf);
+    nk_command_units_begin(ctx, &queue);
+    nk_foreach(cmd, ctx) {
+        struct nk_damage_command *rec;
+        nk_hash id = 0;
+        if (nk_command_units_next(ctx, &queue, cmd, &id) || !unit) {
+            unit = (struct nk_damage_unit*)nk_buffer_alloc(unit_buf, NK_BUFFER_FRONT,
+                sizeof(struct nk_damage_unit), NK_ALIGNOF(struct nk_damage_unit));
+            if (!unit) {damage->valid = nk_false; return screen;}
+            unit->id = id;
+            unit->first = cmd_count;
+            unit->count = 0;
+            unit->bounds = nk_rect(0,0,0,0);
+            unit->matched = nk_false;
+        }
+        rec = (struct nk_damage_command*)nk_buffer_alloc(cmd_buf, NK_BUFFER_FRONT,
+            sizeof(struct nk_damage_command), NK_ALIGNOF(struct nk_damage_command));
+        if (!rec) {damage->valid = nk_false; return screen;}
+        /* the active clip rect is part of what a command looks like */
+        rec->hash = nk_command_hash(cmd, nk_murmur_hash(&clip, (int)sizeof(clip), 0));
+        if (cmd->type == NK_COMMAND_SCISSOR) {
+            const struct nk_command_scissor *s = (const struct nk_command_scissor*)cmd;
+            clip = nk_rect(s->x, s->y, s->w, s->h);
+            rec->bounds = nk_rect(0,0,0,0);
+        } else {
+            struct nk_rect b = nk_damage_command_bounds(cmd);
+            x0 = NK_MAX(b.x, clip.x); y0 = NK_MAX(b.y, clip.y);
+            x1 = NK_MIN(b.x + b.w, clip.x + clip.w); y1 = NK_MIN(b.y + b.h, clip.y + clip.h);
+            rec->bounds = (x0 < x1 && y0 < y1) ? nk_rect(x0, y0, x1 - x0, y1 - y0): nk_rect(0,0,0,0);
+        }
+        unit->bounds = nk_damage_union(unit->bounds, rec->bounds);
+        unit->count++;
+        cmd_count++;
+    }
+
+    if (!damage->valid) {
+        damage->valid = nk_true;
+        return screen;
+    }
+    cmds = (struct nk_damage_command*)nk_buffer_memory(cmd_buf);
+    units = (struct nk_damage_unit*)nk_buffer_memory(unit_buf);
+    unit_count = (int)(unit_buf->allocated / sizeof(struct nk_damage_unit));
+    prev_cmds = (struct nk_damage_command*)nk_buffer_memory(&damage->commands[!damage->current]);
+    prev_units = (struct nk_damage_unit*)nk_buffer_memory(&damage->units[!damage->current]);
+    prev_count = (int)(damage->units[!damage->current].allocated / sizeof(struct nk_damage_unit));
+
+    for (i = 0; i < unit_count; ++i) {
+        struct nk_damage_unit *u = &units[i];
+        for (j = 0; j < prev_count; ++j)
+            if (!prev_units[j].matched && prev_units[j].id == u->id) break;
+        if (j == prev_count) {
+            /* new window */
+            area = nk_damage_union(area, u->bounds);
+            continue;
+        }
+        prev_units[j].matched = nk_true;
+        if (j < last_match) {
+            /* drawn before a window it was drawn after last frame: their overlap changed */
+            area = nk_damage_union(area, u->bounds);
+            area = nk_damage_union(area, prev_units[j].bounds);
+        } else {
+            area = nk_damage_union(area, nk_damage_diff(cmds + u->first, u->count,
+                prev_cmds + prev_units[j].first, prev_units[j].count));
+        }
+        last_match = NK_MAX(last_match, j);
+    }
+    for (j = 0; j < prev_count; ++j) {
+        /* closed or hidden window */
+        if (!prev_units[j].matched)
+            area = nk_damage_union(area, prev_units[j].bounds);
+    }
+
+    x0 = NK_MAX(area.x, screen.x); y0 = NK_MAX(area.y, screen.y);
+    x1 = NK_MIN(area.x + area.w, screen.x + screen.w);
+    y1 = NK_MIN(area.y + area.h, screen.y + screen.h);
+    if (area.w <= 0 || area.h <= 0 || x0 >= x1 || y0 >= y1)
+        return nk_rect(screen.x, screen.y, 0, 0);
+    return nk_rect(x0, y0, x1 - x0, y1 - y0);
+}
+
+
+
+
+
+/* ===============================================================
+ *
+ *                              OPTIMIZER
+ *
+ * ===============================================================*/
+/* true if the command cannot change a pixel, whatever the clip rect */
+NK_INTERN int
+nk_optimize_empty(const struct nk_command *cmd)
+{
+    switch (cmd->type) {
+    case NK_COMMAND_NOP: return nk_true;
+    case NK_COMMAND_LINE: {
+        const struct nk_command_line *c = (const struct nk_command_line*)cmd;
+        return !c->color.a || !c->line_thickness;
+    }
+    case NK_COMMAND_CURVE: {
+        const struct nk_command_curve *c = (const struct nk_command_curve*)cmd;
+        return !c->color.a || !c->line_thickness;
+    }
+    case NK_COMMAND_RECT: {
+        const struct nk_command_rect *c = (const struct nk_command_rect*)cmd;
+        return !c->color.a || !c->line_thickness || !c->w || !c->h;
+    }
+    case NK_COMMAND_RECT_FILLED: {
+        const struct nk_command_rect_filled *c = (const struct nk_command_rect_filled*)cmd;
+        return !c->color.a || !c->w || !c->h;
+    }
+    case NK_COMMAND_RECT_MULTI_COLOR: {
+        const struct nk_command_rect_multi_color *c = (const struct nk_command_rect_multi_color*)cmd;
+        return (!c->left.a && !c->top.a && !c->right.a && !c->bottom.a) || !c->w || !c->h;
+    }
+    case NK_COMMAND_CIRCLE: {
+        const struct nk_command_circle *c = (const struct nk_command_circle*)cmd;
+        return !c->color.a || !c->line_thickness || !c->w || !c->h;
+    }
+    case NK_COMMAND_CIRCLE_FILLED: {
+        const struct nk_command_circle_filled *c = (const struct nk_command_circle_filled*)cmd;
+        return !c->color.a || !c->w || !c->h;
+    }
+    case NK_COMMAND_ARC: {
+        const struct nk_command_arc *c = (const struct nk_command_arc*)cmd;
+        return !c->color.a || !c->line_thickness || !c->r;
+    }
+    case NK_COMMAND_ARC_FILLED: {
+        const struct nk_command_arc_filled *c = (const struct nk_command_arc_filled*)cmd;
+        return !c->color.a || !c->r;
+    }
+    case NK_COMMAND_TRIANGLE: {
+        const struct nk_command_triangle *c = (const struct nk_command_triangle*)cmd;
+        return !c->color.a || !c->line_thickness;
+    }
+    case NK_COMMAND_TRIANGLE_FILLED: {
+        const struct nk_command_triangle_filled *c = (const struct nk_command_triangle_filled*)cmd;
+        return !c->color.a;
+    }
+    case NK_COMMAND_POLYGON: {
+        const struct nk_command_polygon *c = (const struct nk_command_polygon*)cmd;
+        return !c->color.a || !c->line_thickness || c->point_count < 2;
+    }
+    case NK_COMMAND_POLYGON_FILLED: {
+        const struct nk_command_polygon_filled *c = (const struct nk_command_polygon_filled*)cmd;
+        return !c->color.a || c->point_count < 3;
+    }
+    case NK_COMMAND_POLYLINE: {
+        const struct nk_command_polyline *c = (const struct nk_command_polyline*)cmd;
+        return !c->color.a || !c->line_thickness || c->point_count < 2;
+    }
+    case NK_COMMAND_TEXT: {
+        /* backends only draw the foreground */
+        const struct nk_command_text *c = (const struct nk_command_text*)cmd;
+        return !c->foreground.a || !c->length;
+    }
+    case NK_COMMAND_IMAGE: {
+        const struct nk_command_image *c = (const struct nk_command_image*)cmd;
+        return !c->col.a || !c->w || !c->h;
+    }
+    default: return nk_false;
+    }
+}
+/* grows filled rect `a` by `b` if both together form a rect drawn the same way */
+NK_INTERN int
+nk_optimize_merge_rects(struct nk_command_rect_filled *a, const struct nk_command_rect_filled *b)
+{
+    if (a->rounding || b->rounding || a->color.r != b->color.r || a->color.g != b->color.g ||
+        a->color.b != b->color.b || a->color.a != b->color.a)
+        return nk_false;
+    if (a->y == b->y && a->h == b->h && (int)a->w + (int)b->w <= NK_USHORT_MAX) {
+        if (a->x + a->w == b->x) {
+            a->w = (unsigned short)(a->w + b->w);
+            return nk_true;
+        }
+        if (b->x + b->w == a->x) {
+            a->x = b->x;
+            a->w = (unsigned short)(a->w + b->w);
+            return nk_true;
+        }
+    }
+    if (a->x == b->x && a->w == b->w && (int)a->h + (int)b->h <= NK_USHORT_MAX) {
+        if (a->y + a->h == b->y) {
+            a->h = (unsigned short)(a->h + b->h);
+            return nk_true;
+        }
+        if (b->y + b->h == a->y) {
+            a->y = b->y;
+            a->h = (unsigned short)(a->h + b->h);
+            return nk_true;
+        }
+    }
+    return nk_false;
+}
+struct nk_optimize_occluder {
+    struct nk_rect area; /* opaque once drawn */
+    int unit; /* index of the window, popup or overlay drawing it */
+};
+NK_INTERN int
+nk_optimize_join(struct nk_rect *a, struct nk_rect b)
+{
+    if (a->x == b.x && a->w == b.w && b.y <= a->y + a->h && a->y <= b.y + b.h) {
+        float y = NK_MIN(a->y, b.y);
+        a->h = NK_MAX(a->y + a->h, b.y + b.h) - y;
+        a->y = y;
+        return nk_true;
+    }
+    if (a->y == b.y && a->h == b.h && b.x <= a->x + a->w && a->x <= b.x + b.w) {
+        float x = NK_MIN(a->x, b.x);
+        a->w = NK_MAX(a->x + a->w, b.x + b.w) - x;
+        a->x = x;
+        return nk_true;
+    }
+    return nk_false;
+}
+/* collects the opaque area of the last NK_OPTIMIZE_OCCLUDERS units having one,
+ * that is their largest opaque filled rect joined with rects extending it */
+NK_INTERN int
+nk_optimize_occluders(struct nk_context *ctx, struct nk_optimize_occluder *occluders)
+{
+    const struct nk_command *cmd;
+    const struct nk_window *win;
+    struct nk_command_units units;
+    struct nk_optimize_occluder *current = 0;
+    struct nk_rect clip = nk_null_rect; /* every backend carries the clip rect from unit to unit */
+    int unit = -1, count = 0;
+
+    nk_command_units_begin(ctx, &units);
+    /* nothing is drawn on top of a lone window */
+    for (win = ctx->begin; win && !nk_command_window_linked(ctx, win); win = win->next);
+    if (win && nk_ptr_add_const(struct nk_command, ctx->memory.memory.ptr,
+            win->buffer.last)->next >= ctx->memory.allocated)
+        return 0;
+
+    nk_command_units_begin(ctx, &units);
+    nk_foreach(cmd, ctx) {
+        if (nk_command_units_next(ctx, &units, cmd, 0) || unit < 0) {
+            unit++;
+            current = 0;
+        }
+        if (cmd->type == NK_COMMAND_SCISSOR) {
+            const struct nk_command_scissor *s = (const struct nk_command_scissor*)cmd;
+            clip = nk_rect(s->x, s->y, s->w, s->h);
+        } else if (cmd->type == NK_COMMAND_RECT_FILLED) {
+            const struct nk_command_rect_filled *r = (const struct nk_command_rect_filled*)cmd;
+            float x0, y0, x1, y1;
+            struct nk_rect area;
+            if (r->color.a != 255) continue;
+            /* a rounded rect is opaque at least inside its straight edges */
+            x0 = NK_MAX((float)(r->x + r->rounding), clip.x);
+            y0 = NK_MAX((float)(r->y + r->rounding), clip.y);
+            x1 = NK_MIN((float)(r->x + r->w - r->rounding), clip.x + clip.w);
+            y1 = NK_MIN((float)(r->y + r->h - r->rounding), clip.y + clip.h);
+            if (x0 >= x1 || y0 >= y1) continue;
+            area = nk_rect(x0, y0, x1 - x0, y1 - y0);
+            if (!current) {
+                current = &occluders[count++ % NK_OPTIMIZE_OCCLUDERS];
+                current->area = area;
+                current->unit = unit;
+            } else if (!nk_optimize_join(&current->area, area) &&
+                area.w * area.h > current->area.w * current->area.h)
+                current->area = area;
+        }
+    }
+    return NK_MIN(count, NK_OPTIMIZE_OCCLUDERS);
+}
+NK_INTERN int
+nk_optimize_occluded(const struct nk_optimize_occluder *occluders, int count,
+    int unit, struct nk_rect bounds)
+{
+    int i;
+    for (i = 0; i < count; ++i) {
+        /* the outermost pixel of an anti-aliased fill is blended */
+        const struct nk_rect *a = &occluders[i].area;
+        if (occluders[i].unit > unit && bounds.x >= a->x + 1 && bounds.y >= a->y + 1 &&
+            bounds.x + bounds.w <= a->x + a->w - 1 && bounds.y + bounds.h <= a->y + a->h - 1)
+            return nk_true;
+    }
+    return nk_false;
+}
+NK_GLOBAL const char *nk_command_type_names[NK_COMMAND_TYPE_COUNT] = {
+    "nop", "scissor", "line", "curve", "rect", "rect filled", "rect multi color",
+    "circle", "circle filled", "arc", "arc filled", "triangle", "triangle filled",
+    "polygon", "polygon filled", "polyline", "text", "image", "custom"
+};
+NK_API const char*
+nk_command_type_name(enum nk_command_type type)
+{
+    return ((unsigned)type < NK_COMMAND_TYPE_COUNT) ? nk_command_type_names[type] : "unknown";
+}
+NK_API void
+nk_optimize_commands(struct nk_context *ctx, struct nk_optimize_stats *stats)
+{
+    struct nk_command *cmd, *prev = 0; /* last command kept */
+    struct nk_command *scissor = 0; /* last scissor kept if nothing was drawn since */
+    struct nk_command *before_scissor = 0;
+    struct nk_rect clip = nk_null_rect, scissor_clip = nk_null_rect;
+    int clip_set = nk_false, scissor_clip_set = nk_false;
+    struct nk_optimize_occluder occluders[NK_OPTIMIZE_OCCLUDERS];
+    struct nk_command_units units;
+    int occluder_count, unit = -1;
+
+    NK_ASSERT(ctx);
+    if (stats) nk_zero(stats, sizeof(*stats));
+    if (!ctx) return;
+    cmd = (struct nk_command*)nk__begin(ctx);
+    occluder_count = nk_optimize_occluders(ctx, occluders);
+    nk_command_units_begin(ctx, &units);
+    while (cmd) {
+        struct nk_command *next = (struct nk_command*)nk__next(ctx, cmd);
+        int start = nk_command_units_next(ctx, &units, cmd, 0);
+        int drop = nk_false, occluded = nk_false;
+        if (stats) stats->commands[cmd->type]++;
+        if (start || unit < 0) unit++;
+        if (start) {
+            /* units may be converted on their own, so assume nothing about the clip rect */
+            scissor = 0;
+            clip_set = nk_false;
+        }
+        if (cmd->type == NK_COMMAND_SCISSOR) {
+            const struct nk_command_scissor *s = (const struct nk_command_scissor*)cmd;
+            struct nk_rect r = nk_rect(s->x, s->y, s->w, s->h);
+            if (scissor && before_scissor) {
+                /* nothing was drawn with the previous scissor */
+                before_scissor->next = scissor->next;
+                if (stats) stats->removed[NK_COMMAND_SCISSOR]++;
+                prev = before_scissor;
+                clip = scissor_clip;
+                clip_set = scissor_clip_set;
+            }
+            scissor = 0;
+            drop = clip_set && clip.x == r.x && clip.y == r.y && clip.w == r.w && clip.h == r.h;
+            if (!drop && !start) {
+                scissor = cmd;
+                before_scissor = prev;
+                scissor_clip = clip;
+                scissor_clip_set = clip_set;
+            }
+            clip = r;
+            clip_set = nk_true;
+        } else if (nk_optimize_empty(cmd)) {
+            drop = nk_true;
+        } else if (cmd->type != NK_COMMAND_CUSTOM && clip_set) {
+            /* scissor rects are rounded outwards so keep anything touching the border */
+            struct nk_rect b = nk_damage_command_bounds(cmd);
+            drop = b.w <= 0 || b.h <= 0 || b.x >= clip.x + clip.w + 1 || b.x + b.w <= clip.x - 1 ||
+                b.y >= clip.y + clip.h + 1 || b.y + b.h <= clip.y - 1;
+            drop = drop || (occluded = nk_optimize_occluded(occluders, occluder_count, unit, b));
+        } else if (cmd->type != NK_COMMAND_CUSTOM) {
+            drop = occluded = nk_optimize_occluded(occluders, occluder_count, unit,
+                nk_damage_command_bounds(cmd));
+        }
+        if (!drop && !start && prev && prev->type == NK_COMMAND_RECT_FILLED &&
+            cmd->type == NK_COMMAND_RECT_FILLED)
+            drop = nk_optimize_merge_rects((struct nk_command_rect_filled*)prev,
+                (const struct nk_command_rect_filled*)cmd);
+
+        if (drop && prev && !start) {
+            prev->next = cmd->next;
+            if (stats) stats->removed[cmd->type]++;
+            if (stats && occluded) stats->occluded[cmd->type]++;
+        } else {
+            if (cmd->type != NK_COMMAND_SCISSOR) scissor = 0;
+            prev = cmd;
+        }
+        cmd = next;
+    }
+    if (scissor && before_scissor) {
+        /* nothing is drawn after the last scissor */
+        before_scissor->next = scissor->next;
+        if (stats) stats->removed[NK_COMMAND_SCISSOR]++;
+    }
+}
+
+
+
+
+
+/* ===============================================================
+ *
+ *                          TEXT WIDTH CACHE
+ *
+ * ===============================================================*/
+NK_API void
+nk_text_width_cache_init(struct nk_text_width_cache *cache,
+    const struct nk_allocator *alloc, int capacity)
+{
+    int buckets = 1;
+    NK_ASSERT(cache);
+    NK_ASSERT(alloc);
+    if (!cache || !alloc) return;
+    nk_zero(cache, sizeof(*cache));
+    cache->alloc = *alloc;
+    if (capacity <= 0) return;
+
+    while (buckets < capacity) buckets <<= 1;
+    cache->entries = (struct nk_text_width_entry*)alloc->alloc(alloc->userdata, 0,
+        sizeof(struct nk_text_width_entry) * (nk_size)capacity + sizeof(int) * (nk_size)buckets);
+    if (!cache->entries) return;
+    cache->buckets = (int*)(void*)(cache->entries + capacity);
+    cache->capacity = capacity;
+    cache->bucket_mask = buckets - 1;
+    nk_text_width_cache_clear(cache);
+}
+#ifdef NK_INCLUDE_DEFAULT_ALLOCATOR
+NK_API void
+nk_text_width_cache_init_default(struct nk_text_width_cache *cache, int capacity)
+{
+    struct nk_allocator alloc;
+    alloc.userdata.ptr = 0;
+    alloc.alloc = nk_malloc;
+    alloc.free = nk_mfree;
+    nk_text_width_cache_init(cache, &alloc, capacity);
+}
+#endif
+NK_API void
+nk_text_width_cache_free(struct nk_text_width_cache *cache)
+{
+    NK_ASSERT(cache);
+    if (!cache) return;
+    if (cache->entries)
+        cache->alloc.free(cache->alloc.userdata, cache->entries);
+    cache->entries = 0;
+    cache->buckets = 0;
+    cache->capacity = 0;
+    cache->count = 0;
+}
+NK_API void
+nk_text_width_cache_clear(struct nk_text_width_cache *cache)
+{
+    int i;
+    NK_ASSERT(cache);
+    if (!cache || !cache->buckets) return;
+    for (i = 0; i <= cache->bucket_mask; ++i)
+        cache->buckets[i] = -1;
+    cache->count = 0;
+    cache->newest = cache->oldest = -1;
+}
+NK_INTERN void
+nk_text_width_cache_unlink(struct nk_text_width_cache *cache, int index)
+{
+    struct nk_text_width_entry *e = &cache->entries[index];
+    if (e->prev_used >= 0) cache->entries[e->prev_used].next_used = e->next_used;
+    else cache->oldest = e->next_used;
+    if (e->next_used >= 0) cache->entries[e->next_used].prev_used = e->prev_used;
+    else cache->newest = e->prev_used;
+}
+NK_INTERN void
+nk_text_width_cache_touch(struct nk_text_width_cache *cache, int index)
+{
+    struct nk_text_width_entry *e = &cache->entries[index];
+    e->prev_used = cache->newest;
+    e->next_used = -1;
+    if (cache->newest >= 0) cache->entries[cache->newest].next_used = index;
+    else cache->oldest = index;
+    cache->newest = index;
+}
+NK_INTERN float
+nk_cached_font_text_width(nk_handle handle, float height, const char *text, int len)
+{
+    struct nk_cached_font *cached = (struct nk_cached_font*)handle.ptr;
+    struct nk_text_width_cache *cache = cached->cache;
+    const struct nk_user_font *font = cached->font;
+    struct nk_text_width_entry *e;
+    nk_hash hash, check;
+    int index, *link;
+
+    if (!cache->capacity || len < NK_TEXT_WIDTH_CACHE_MIN_LEN)
+        return font->width(font->userdata, height, text, len);
+
+    hash = nk_murmur_hash(text, len, 0);
+    check = nk_murmur_hash(text, len, hash);
+    for (index = cache->buckets[hash & (nk_hash)cache->bucket_mask]; index >= 0; index = e->next) {
+        e = &cache->entries[index];
+        if (e->hash != hash || e->check != check || e->len != len ||
+            e->height != height || e->font != font) continue;
+        if (index != cache->newest) {
+            nk_text_width_cache_unlink(cache, index);
+            nk_text_width_cache_touch(cache, index);
+        }
+        cache->hits++;
+        return e->width;
+    }
+    cache->misses++;
+
+    if (cache->count < cache->capacity) {
+        index = cache->count++;
+    } else {
+        /* reuse the least recently used entry */
+        index = cache->oldest;
+        e = &cache->entries[index];
+        link = &cache->buckets[e->hash & (nk_hash)cache->bucket_mask];
+        while (*link != index) link = &cache->entries[*link].next;
+        *link = e->next;
+        nk_text_width_cache_unlink(cache, index);
+        cache->evictions++;
+    }
+    e = &cache->entries[index];
+    e->font = font;
+    e->hash = hash;
+    e->check = check;
+    e->height = height;
+    e->len = len;
+    e->width = font->width(font->userdata, height, text, len);
+    link = &cache->buckets[hash & (nk_hash)cache->bucket_mask];
+    e->next = *link;
+    *link = index;
+    nk_text_width_cache_touch(cache, index);
+    return e->width;
+}
+#ifdef NK_INCLUDE_VERTEX_BUFFER_OUTPUT
+NK_INTERN void
+nk_cached_font_query_font_glyph(nk_handle handle, float height,
+    struct nk_user_font_glyph *glyph, nk_rune codepoint, nk_rune next_codepoint)
+{
+    const struct nk_user_font *font = ((struct nk_cached_font*)handle.ptr)->font;
+    font->query(font->userdata, height, glyph, codepoint, next_codepoint);
+}
+#endif
+NK_API void
+nk_cached_font_init(struct nk_cached_font *cached, const struct nk_user_font *font,
+    struct nk_text_width_cache *cache)
+{
+    NK_ASSERT(cached);
+    NK_ASSERT(font);
+    NK_ASSERT(cache);
+    if (!cached || !font || !cache) return;
+    cached->font = font;
+    cached->cache = cache;
+    cached->handle = *font;
+    cached->handle.userdata = nk_handle_ptr(cached);
+    cached->handle.width = nk_cached_font_text_width;
+#ifdef NK_INCLUDE_VERTEX_BUFFER_OUTPUT
+    cached->handle.query = nk_cached_font_query_font_glyph;
+#endif
+}
+
+
+
+
+
+/* ===============================================================
+ *
+ *                              VERTEX
+ *
+ * ===============================================================*/
+#ifdef NK_INCLUDE_VERTEX_BUFFER_OUTPUT
+NK_API void
+nk_draw_list_init(struct nk_draw_list *list)
+{
+    nk_size i = 0;
+    NK_ASSERT(list);
+    if (!list) return;
+    nk_zero(list, sizeof(*list));
+    for (i = 0; i < NK_LEN(list->circle_vtx); ++i) {
+        const float a = ((float)i / (float)NK_LEN(list->circle_vtx)) * 2 * NK_PI;
+        list->circle_vtx[i].x = (float)NK_COS(a);
+        list->circle_vtx[i].y = (float)NK_SIN(a);
+    }
+}
+NK_INTERN void nk_draw_list_select_vertex_writer(struct nk_draw_list *list);
+NK_API void
+nk_draw_list_setup(struct nk_draw_list *canvas, const struct nk_convert_config *config,
+    struct nk_buffer *cmds, struct nk_buffer *vertices, struct nk_buffer *elements,
+    enum nk_anti_aliasing line_aa, enum nk_anti_aliasing shape_aa)
+{
+    NK_ASSERT(canvas);
+    NK_ASSERT(config);
+    NK_ASSERT(cmds);
+    NK_ASSERT(vertices);
+    NK_ASSERT(elements);
+    if (!canvas || !config || !cmds || !vertices || !elements)
+        return;
+
+    canvas->buffer = cmds;
+    canvas->config = *config;
+    canvas->elements = elements;
+    canvas->vertices = vertices;
+    canvas->line_AA = line_aa;
+    canvas->shape_AA = shape_aa;
+    canvas->clip_rect = nk_null_rect;
+
+    canvas->cmd_offset = 0;
+    canvas->element_count = 0;
+    canvas->vertex_count = 0;
+    canvas->vertex_base = 0;
+    canvas->quad_run = 0;
+    canvas->instance_run = 0;
+    canvas->cmd_offset = 0;
+    canvas->cmd_count = 0;
+    canvas->path_count = 0;
+    nk_draw_list_select_vertex_writer(canvas);
+}
+NK_API const struct nk_draw_command*
+nk__draw_list_begin(const struct nk_draw_list *canvas, const struct nk_buffer *buffer)
+{
+    nk_byte *memory;
+    nk_size offset;
+    const struct nk_draw_command *cmd;
+
+    NK_ASSERT(buffer);
+    if (!buffer || !buffer->size || !canvas->cmd_count)
+        return 0;
+
+    memory = (nk_byte*)buffer->memory.ptr;
+    offset = buffer->memory.size - canvas->cmd_offset;
+    cmd = nk_ptr_add(const struct nk_draw_command, memory, offset);
+    return cmd;
+}
+NK_API const struct nk_draw_command*
+nk__draw_list_end(const struct nk_draw_list *canvas, const struct nk_buffer *buffer)
+{
+    nk_size size;
+    nk_size offset;
+    nk_byte *memory;
+    const struct nk_draw_command *end;
+
+    NK_ASSERT(buffer);
+    NK_ASSERT(canvas);
+    if (!buffer || !canvas)
+        return 0;
+
+    memory = (nk_byte*)buffer->memory.ptr;
+    size = buffer->memory.size;
+    offset = size - canvas->cmd_offset;
+    end = nk_ptr_add(const struct nk_draw_command, memory, offset);
+    end -= (canvas->cmd_count-1);
+    return end;
+}
+NK_API const struct nk_draw_command*
+nk__draw_list_next(const struct nk_draw_command *cmd,
+    const struct nk_buffer *buffer, const struct nk_draw_list *canvas)
+{
+    const struct nk_draw_command *end;
+    NK_ASSERT(buffer);
+    NK_ASSERT(canvas);
+    if (!cmd || !buffer || !canvas)
+        return 0;
+
+    end = nk__draw_list_end(canvas, buffer);
+    if (cmd <= end) return 0;
+    return (cmd-1);
+}
+NK_INTERN struct nk_vec2*
+nk_draw_list_alloc_path(struct nk_draw_list *list, int count)
+{
+    struct nk_vec2 *points;
+    NK_STORAGE const nk_size point_align = NK_ALIGNOF(struct nk_vec2);
+    NK_STORAGE const nk_size point_size = sizeof(struct nk_vec2);
+    points = (struct nk_vec2*)
+        nk_buffer_alloc(list->buffer, NK_BUFFER_FRONT,
+                        point_size * (nk_size)count, point_align);
+
+    if (!points) return 0;
+    if (!list->path_offset) {
+        void *memory = nk_buffer_memory(list->buffer);
+        list->path_offset = (unsigned int)((nk_byte*)points - (nk_byte*)memory);
+    }
+    list->path_count += (unsigned int)count;
+    return points;
+}
+NK_INTERN struct nk_vec2
+nk_draw_list_path_last(struct nk_draw_list *list)
+{
+    void *memory;
+    struct nk_vec2 *point;
+    NK_ASSERT(list->path_count);
+    memory = nk_buffer_memory(list->buffer);
+    point = nk_ptr_add(struct nk_vec2, memory, list->path_offset);
+    point += (list->path_count-1);
+    return *point;
+}
+NK_INTERN struct nk_draw_command*
+nk_draw_list_push_command(struct nk_draw_list *list, struct nk_rect clip,
+    nk_handle texture)
+{
+    NK_STORAGE const nk_size cmd_align = NK_ALIGNOF(struct nk_draw_command);
+    NK_STORAGE const nk_size cmd_size = sizeof(struct nk_draw_command);
+    struct nk_draw_command *cmd;
+
+    NK_ASSERT(list);
+    cmd = (struct nk_draw_command*)
+        nk_buffer_alloc(list->buffer, NK_BUFFER_BACK, cmd_size, cmd_align);
+
+    if (!cmd) return 0;
     if (!list->cmd_count) {
         nk_byte *memory = (nk_byte*)nk_buffer_memory(list->buffer);
         nk_size total = nk_buffer_total(list->buffer);
@@ -9292,7 +10580,13 @@ nk_draw_list_push_command(struct nk_draw_list *list, struct nk_rect clip,
     }
 
     cmd->elem_count = 0;
+    cmd->vertex_offset = list->vertex_base;
+    cmd->quads = nk_false;
+    cmd->instances = nk_false;
+    list->quad_run = 0;
+    list->instance_run = 0;
     cmd->clip_rect = clip;
+    cmd->bounds = nk_rect(0,0,0,0);
     cmd->texture = texture;
 #ifdef NK_INCLUDE_COMMAND_USERDATA
     cmd->userdata = list->userdata;
@@ -9368,19 +10662,35 @@ nk_draw_list_alloc_vertices(struct nk_draw_list *list, nk_size count)
     if (!vtx) return 0;
     list->vertex_count += (unsigned int)count;
 
-    /* This assert triggers because your are drawing a lot of stuff and nuklear
-     * defined `nk_draw_index` as `nk_ushort` to safe space be default.
-     *
-     * So you reached the maximum number of indicies or rather vertexes.
-     * To solve this issue please change typdef `nk_draw_index` to `nk_uint`
-     * and don't forget to specify the new element size in your drawing
-     * backend (OpenGL, DirectX, ...). For example in OpenGL for `glDrawElements`
-     * instead of specifing `GL_UNSIGNED_SHORT` you have to define `GL_UNSIGNED_INT`.
-     * Sorry for the inconvenience. */
-    if(sizeof(nk_draw_index)==2) NK_ASSERT((list->vertex_count < NK_USHORT_MAX &&
+    /* This assert triggers because a single shape needs more vertices than
+     * 16-bit indices can address, splitting draw commands does not help here.
+     * To solve this issue please define NK_UINT_DRAW_INDEX which changes
+     * `nk_draw_index` to `nk_uint` and don't forget to specify the new
+     * element size in your drawing backend (OpenGL, DirectX, ...). For
+     * example in OpenGL for `glDrawElements` instead of specifing
+     * `GL_UNSIGNED_SHORT` you have to define `GL_UNSIGNED_INT`. */
+    if(sizeof(nk_draw_index)==2) NK_ASSERT((list->vertex_count - list->vertex_base <= NK_USHORT_MAX + 1 &&
         "To many verticies for 16-bit vertex indicies. Please read comment above on how to solve this problem"));
     return vtx;
 }
+NK_INTERN nk_size
+nk_draw_list_vertex_index(struct nk_draw_list *list, nk_size count)
+{
+    /* Returns the element index the next `count` vertices will get. With
+     * 16-bit indices the current draw command is ended once the new vertices
+     * would not be addressable anymore and the following one starts its
+     * vertex range (`vertex_offset`) at the current vertex. */
+    NK_ASSERT(list);
+    if (sizeof(nk_draw_index) == 2 && list->cmd_count &&
+        list->vertex_count - list->vertex_base + count > NK_USHORT_MAX + 1) {
+        struct nk_draw_command *prev = nk_draw_list_command_last(list);
+        list->vertex_base = list->vertex_count;
+        if (prev->elem_count == 0)
+            prev->vertex_offset = list->vertex_base;
+        else nk_draw_list_push_command(list, prev->clip_rect, prev->texture);
+    }
+    return list->vertex_count - list->vertex_base;
+}
 NK_INTERN nk_draw_index*
 nk_draw_list_alloc_elements(struct nk_draw_list *list, nk_size count)
 {
@@ -9395,10 +10705,82 @@ nk_draw_list_alloc_elements(struct nk_draw_list *list, nk_size count)
         nk_buffer_alloc(list->elements, NK_BUFFER_FRONT, elem_size*count, elem_align);
     if (!ids) return 0;
     cmd = nk_draw_list_command_last(list);
+    if (cmd->quads || cmd->instances) {
+        cmd = nk_draw_list_push_command(list, cmd->clip_rect, cmd->texture);
+        if (!cmd) return 0;
+    }
+    list->quad_run = 0;
+    list->instance_run = 0;
     list->element_count += (unsigned int)count;
     cmd->elem_count += (unsigned int)count;
     return ids;
 }
+NK_INTERN void*
+nk_draw_list_alloc_quad(struct nk_draw_list *list)
+{
+    /* Allocates the four vertices of a quad drawn as 0-1-2 0-2-3 and writes
+     * its six elements. With `quad_batch` set, a run of consecutive quads
+     * that grows long enough to be worth a draw command of its own takes its
+     * elements back and moves into a command marked `quads`, which the
+     * backend draws with its shared quad elements. Following quads of the
+     * run are appended to that command without writing elements. */
+    struct nk_draw_command *cmd;
+    nk_draw_index *idx;
+    nk_size index;
+    unsigned int run;
+    void *vtx;
+    NK_ASSERT(list);
+    if (!list) return 0;
+
+    if (list->config.quad_batch) {
+        unsigned int quads;
+        cmd = nk_draw_list_command_last(list);
+        quads = cmd->elem_count / 6;
+        if (cmd->quads && quads < list->config.quad_batch &&
+            cmd->vertex_offset + quads * 4 == list->vertex_count) {
+            /* indexed shapes after the run start a new vertex range */
+            list->vertex_base = list->vertex_count;
+            vtx = nk_draw_list_alloc_vertices(list, 4);
+            if (!vtx) return 0;
+            cmd->elem_count += 6;
+            return vtx;
+        }
+    }
+
+    index = nk_draw_list_vertex_index(list, 4);
+    run = list->quad_run;
+    vtx = nk_draw_list_alloc_vertices(list, 4);
+    idx = nk_draw_list_alloc_elements(list, 6);
+    if (!vtx || !idx) return 0;
+    idx[0] = (nk_draw_index)(index+0); idx[1] = (nk_draw_index)(index+1);
+    idx[2] = (nk_draw_index)(index+2); idx[3] = (nk_draw_index)(index+0);
+    idx[4] = (nk_draw_index)(index+2); idx[5] = (nk_draw_index)(index+3);
+    list->quad_run = ++run;
+
+    if (list->config.quad_batch &&
+        run >= NK_MIN(list->config.quad_batch, NK_DRAW_LIST_QUAD_RUN)) {
+        /* the run's elements are the last ones written */
+        const nk_size count = run * 6;
+        list->elements->allocated -= count * sizeof(nk_draw_index);
+        list->elements->needed -= count * sizeof(nk_draw_index);
+        list->element_count -= (unsigned int)count;
+        cmd = nk_draw_list_command_last(list);
+        cmd->elem_count -= (unsigned int)count;
+        if (cmd->elem_count) {
+            /* the run may have started with earlier commands' geometry */
+            const struct nk_rect bounds = cmd->bounds;
+            cmd = nk_draw_list_push_command(list, cmd->clip_rect, cmd->texture);
+            if (cmd) cmd->bounds = bounds;
+        }
+        if (!cmd) return 0;
+        cmd->quads = nk_true;
+        cmd->vertex_offset = list->vertex_count - run * 4;
+        cmd->elem_count = (unsigned int)count;
+        list->vertex_base = list->vertex_count;
+        list->quad_run = 0;
+    }
+    return vtx;
+}
 NK_INTERN int
 nk_draw_vertex_layout_element_is_end_of_layout(
     const struct nk_draw_vertex_layout_element *element)
@@ -9536,7 +10918,7 @@ nk_draw_vertex_element(void *dst, const float *values, int value_count,
     }
 }
 NK_INTERN void*
-nk_draw_vertex(void *dst, const struct nk_convert_config *config,
+nk_draw_vertex_generic(void *dst, const struct nk_convert_config *config,
     struct nk_vec2 pos, struct nk_vec2 uv, struct nk_colorf color)
 {
     void *result = (void*)((char*)dst + config->vertex_size);
@@ -9554,6 +10936,112 @@ nk_draw_vertex(void *dst, const struct nk_convert_config *config,
     }
     return result;
 }
+/* Specialized writers for the common layouts, straight stores instead of
+ * interpreting the layout for every single vertex. Colors are saturated and
+ * truncated exactly like nk_draw_vertex_color does. */
+#define NK_DRAW_VERTEX_STORE_RGBA8(d, c)\
+    (d)[0] = (nk_byte)(NK_SATURATE((c).r) * 255.0f);\
+    (d)[1] = (nk_byte)(NK_SATURATE((c).g) * 255.0f);\
+    (d)[2] = (nk_byte)(NK_SATURATE((c).b) * 255.0f);\
+    (d)[3] = (nk_byte)(NK_SATURATE((c).a) * 255.0f)
+#define NK_DRAW_VERTEX_STORE_BGRA8(d, c)\
+    (d)[0] = (nk_byte)(NK_SATURATE((c).b) * 255.0f);\
+    (d)[1] = (nk_byte)(NK_SATURATE((c).g) * 255.0f);\
+    (d)[2] = (nk_byte)(NK_SATURATE((c).r) * 255.0f);\
+    (d)[3] = (nk_byte)(NK_SATURATE((c).a) * 255.0f)
+#define NK_DRAW_VERTEX_STORE_RGBA32F(d, c)\
+    ((float*)(void*)(d))[0] = NK_SATURATE((c).r);\
+    ((float*)(void*)(d))[1] = NK_SATURATE((c).g);\
+    ((float*)(void*)(d))[2] = NK_SATURATE((c).b);\
+    ((float*)(void*)(d))[3] = NK_SATURATE((c).a)
+#define NK_DRAW_VERTEX_WRITER(name, pos_offset, uv_offset, col_offset, size, store_color)\
+NK_INTERN void*\
+name(void *dst, const struct nk_draw_list *list,\
+    struct nk_vec2 pos, struct nk_vec2 uv, struct nk_colorf color)\
+{\
+    nk_byte *vtx = (nk_byte*)dst;\
+    float *p = (float*)(void*)(vtx + (pos_offset));\
+    float *t = (float*)(void*)(vtx + (uv_offset));\
+    nk_byte *c = vtx + (col_offset);\
+    NK_UNUSED(list);\
+    p[0] = pos.x; p[1] = pos.y;\
+    t[0] = uv.x; t[1] = uv.y;\
+    store_color(c, color);\
+    return vtx + (size);\
+}
+NK_DRAW_VERTEX_WRITER(nk_draw_vertex_xy_uv_rgba8_packed, 0, 8, 16, 20,
+    NK_DRAW_VERTEX_STORE_RGBA8)
+NK_DRAW_VERTEX_WRITER(nk_draw_vertex_xy_uv_rgba8,
+    list->vertex_offset[NK_VERTEX_POSITION], list->vertex_offset[NK_VERTEX_TEXCOORD],
+    list->vertex_offset[NK_VERTEX_COLOR], list->config.vertex_size, NK_DRAW_VERTEX_STORE_RGBA8)
+NK_DRAW_VERTEX_WRITER(nk_draw_vertex_xy_uv_bgra8,
+    list->vertex_offset[NK_VERTEX_POSITION], list->vertex_offset[NK_VERTEX_TEXCOORD],
+    list->vertex_offset[NK_VERTEX_COLOR], list->config.vertex_size, NK_DRAW_VERTEX_STORE_BGRA8)
+NK_DRAW_VERTEX_WRITER(nk_draw_vertex_xy_uv_rgba32f,
+    list->vertex_offset[NK_VERTEX_POSITION], list->vertex_offset[NK_VERTEX_TEXCOORD],
+    list->vertex_offset[NK_VERTEX_COLOR], list->config.vertex_size, NK_DRAW_VERTEX_STORE_RGBA32F)
+#undef NK_DRAW_VERTEX_WRITER
+
+NK_INTERN void
+nk_draw_list_select_vertex_writer(struct nk_draw_list *list)
+{
+    const struct nk_convert_config *config = &list->config;
+    const struct nk_draw_vertex_layout_element *elem_iter = config->vertex_layout;
+    enum nk_draw_vertex_layout_format format[NK_VERTEX_ATTRIBUTE_COUNT];
+    const nk_size *offset = list->vertex_offset;
+    int seen = 0;
+
+    list->vertex_writer = NK_VERTEX_WRITER_GENERIC;
+#ifdef NK_GENERIC_VERTEX_WRITER
+    return;
+#endif
+    if (!elem_iter || config->vertex_size % sizeof(float) ||
+        config->vertex_alignment < NK_ALIGNOF(float)) return;
+
+    /* every attribute exactly once, all of them 4 byte aligned */
+    while (!nk_draw_vertex_layout_element_is_end_of_layout(elem_iter)) {
+        if (seen & (1 << elem_iter->attribute)) return;
+        if (elem_iter->offset % sizeof(float)) return;
+        seen |= 1 << elem_iter->attribute;
+        format[elem_iter->attribute] = elem_iter->format;
+        list->vertex_offset[elem_iter->attribute] = elem_iter->offset;
+        elem_iter++;
+    }
+    if (seen != (1 << NK_VERTEX_ATTRIBUTE_COUNT) - 1) return;
+    if (format[NK_VERTEX_POSITION] != NK_FORMAT_FLOAT ||
+        format[NK_VERTEX_TEXCOORD] != NK_FORMAT_FLOAT) return;
+
+    switch (format[NK_VERTEX_COLOR]) {
+    case NK_FORMAT_R8G8B8A8:
+        if (offset[NK_VERTEX_POSITION] == 0 && offset[NK_VERTEX_TEXCOORD] == 8 &&
+            offset[NK_VERTEX_COLOR] == 16 && config->vertex_size == 20)
+            list->vertex_writer = NK_VERTEX_WRITER_XY_UV_RGBA8_PACKED;
+        else list->vertex_writer = NK_VERTEX_WRITER_XY_UV_RGBA8;
+        break;
+    case NK_FORMAT_B8G8R8A8:
+        list->vertex_writer = NK_VERTEX_WRITER_XY_UV_BGRA8; break;
+    case NK_FORMAT_R32G32B32A32_FLOAT:
+        list->vertex_writer = NK_VERTEX_WRITER_XY_UV_RGBA32F; break;
+    default: break;
+    }
+}
+NK_INTERN void*
+nk_draw_vertex(void *dst, const struct nk_draw_list *list,
+    struct nk_vec2 pos, struct nk_vec2 uv, struct nk_colorf color)
+{
+    switch (list->vertex_writer) {
+    case NK_VERTEX_WRITER_XY_UV_RGBA8_PACKED:
+        return nk_draw_vertex_xy_uv_rgba8_packed(dst, list, pos, uv, color);
+    case NK_VERTEX_WRITER_XY_UV_RGBA8:
+        return nk_draw_vertex_xy_uv_rgba8(dst, list, pos, uv, color);
+    case NK_VERTEX_WRITER_XY_UV_BGRA8:
+        return nk_draw_vertex_xy_uv_bgra8(dst, list, pos, uv, color);
+    case NK_VERTEX_WRITER_XY_UV_RGBA32F:
+        return nk_draw_vertex_xy_uv_rgba32f(dst, list, pos, uv, color);
+    case NK_VERTEX_WRITER_GENERIC:
+    default: return nk_draw_vertex_generic(dst, &list->config, pos, uv, color);
+    }
+}
 NK_API void
 nk_draw_list_stroke_poly_line(struct nk_draw_list *list, const struct nk_vec2 *points,
     const unsigned int points_count, struct nk_color color, enum nk_draw_list_stroke closed,
@@ -9589,10 +11077,10 @@ nk_draw_list_stroke_poly_line(struct nk_draw_list *list, const struct nk_vec2 *p
         /* allocate vertices and elements  */
         nk_size i1 = 0;
         nk_size vertex_offset;
-        nk_size index = list->vertex_count;
 
         const nk_size idx_count = (thick_line) ?  (count * 18) : (count * 12);
         const nk_size vtx_count = (thick_line) ? (points_count * 4): (points_count *3);
+        nk_size index = nk_draw_list_vertex_index(list, vtx_count);
 
         void *vtx = nk_draw_list_alloc_vertices(list, vtx_count);
         nk_draw_index *ids = nk_draw_list_alloc_elements(list, idx_count);
@@ -9677,9 +11165,9 @@ nk_draw_list_stroke_poly_line(struct nk_draw_list *list, const struct nk_vec2 *p
             /* fill vertices */
             for (i = 0; i < points_count; ++i) {
                 const struct nk_vec2 uv = list->config.null.uv;
-                vtx = nk_draw_vertex(vtx, &list->config, points[i], uv, col);
-                vtx = nk_draw_vertex(vtx, &list->config, temp[i*2+0], uv, col_trans);
-                vtx = nk_draw_vertex(vtx, &list->config, temp[i*2+1], uv, col_trans);
+                vtx = nk_draw_vertex(vtx, list, points[i], uv, col);
+                vtx = nk_draw_vertex(vtx, list, temp[i*2+0], uv, col_trans);
+                vtx = nk_draw_vertex(vtx, list, temp[i*2+1], uv, col_trans);
             }
         } else {
             nk_size idx1, i;
@@ -9742,10 +11230,10 @@ nk_draw_list_stroke_poly_line(struct nk_draw_list *list, const struct nk_vec2 *p
             /* add vertices */
             for (i = 0; i < points_count; ++i) {
                 const struct nk_vec2 uv = list->config.null.uv;
-                vtx = nk_draw_vertex(vtx, &list->config, temp[i*4+0], uv, col_trans);
-                vtx = nk_draw_vertex(vtx, &list->config, temp[i*4+1], uv, col);
-                vtx = nk_draw_vertex(vtx, &list->config, temp[i*4+2], uv, col);
-                vtx = nk_draw_vertex(vtx, &list->config, temp[i*4+3], uv, col_trans);
+                vtx = nk_draw_vertex(vtx, list, temp[i*4+0], uv, col_trans);
+                vtx = nk_draw_vertex(vtx, list, temp[i*4+1], uv, col);
+                vtx = nk_draw_vertex(vtx, list, temp[i*4+2], uv, col);
+                vtx = nk_draw_vertex(vtx, list, temp[i*4+3], uv, col_trans);
             }
         }
         /* free temporary normals + points */
@@ -9753,9 +11241,9 @@ nk_draw_list_stroke_poly_line(struct nk_draw_list *list, const struct nk_vec2 *p
     } else {
         /* NON ANTI-ALIASED STROKE */
         nk_size i1 = 0;
-        nk_size idx = list->vertex_count;
         const nk_size idx_count = count * 6;
         const nk_size vtx_count = count * 4;
+        nk_size idx = nk_draw_list_vertex_index(list, vtx_count);
         void *vtx = nk_draw_list_alloc_vertices(list, vtx_count);
         nk_draw_index *ids = nk_draw_list_alloc_elements(list, idx_count);
         if (!vtx || !ids) return;
@@ -9780,10 +11268,10 @@ nk_draw_list_stroke_poly_line(struct nk_draw_list *list, const struct nk_vec2 *p
             dx = diff.x * (thickness * 0.5f);
             dy = diff.y * (thickness * 0.5f);
 
-            vtx = nk_draw_vertex(vtx, &list->config, nk_vec2(p1.x + dy, p1.y - dx), uv, col);
-            vtx = nk_draw_vertex(vtx, &list->config, nk_vec2(p2.x + dy, p2.y - dx), uv, col);
-            vtx = nk_draw_vertex(vtx, &list->config, nk_vec2(p2.x - dy, p2.y + dx), uv, col);
-            vtx = nk_draw_vertex(vtx, &list->config, nk_vec2(p1.x - dy, p1.y + dx), uv, col);
+            vtx = nk_draw_vertex(vtx, list, nk_vec2(p1.x + dy, p1.y - dx), uv, col);
+            vtx = nk_draw_vertex(vtx, list, nk_vec2(p2.x + dy, p2.y - dx), uv, col);
+            vtx = nk_draw_vertex(vtx, list, nk_vec2(p2.x - dy, p2.y + dx), uv, col);
+            vtx = nk_draw_vertex(vtx, list, nk_vec2(p1.x - dy, p1.y + dx), uv, col);
 
             ids[0] = (nk_draw_index)(idx+0); ids[1] = (nk_draw_index)(idx+1);
             ids[2] = (nk_draw_index)(idx+2); ids[3] = (nk_draw_index)(idx+0);
@@ -9823,10 +11311,10 @@ nk_draw_list_fill_poly_convex(struct nk_draw_list *list,
 
         const float AA_SIZE = 1.0f;
         nk_size vertex_offset = 0;
-        nk_size index = list->vertex_count;
 
         const nk_size idx_count = (points_count-2)*3 + points_count*6;
         const nk_size vtx_count = (points_count*2);
+        nk_size index = nk_draw_list_vertex_index(list, vtx_count);
 
         void *vtx = nk_draw_list_alloc_vertices(list, vtx_count);
         nk_draw_index *ids = nk_draw_list_alloc_elements(list, idx_count);
@@ -9885,8 +11373,8 @@ nk_draw_list_fill_poly_convex(struct nk_draw_list *list,
             dm = nk_vec2_muls(dm, AA_SIZE * 0.5f);
 
             /* add vertices */
-            vtx = nk_draw_vertex(vtx, &list->config, nk_vec2_sub(points[i1], dm), uv, col);
-            vtx = nk_draw_vertex(vtx, &list->config, nk_vec2_add(points[i1], dm), uv, col_trans);
+            vtx = nk_draw_vertex(vtx, list, nk_vec2_sub(points[i1], dm), uv, col);
+            vtx = nk_draw_vertex(vtx, list, nk_vec2_add(points[i1], dm), uv, col_trans);
 
             /* add indexes */
             ids[0] = (nk_draw_index)(vtx_inner_idx+(i1<<1));
@@ -9901,15 +11389,15 @@ nk_draw_list_fill_poly_convex(struct nk_draw_list *list,
         nk_buffer_reset(list->vertices, NK_BUFFER_FRONT);
     } else {
         nk_size i = 0;
-        nk_size index = list->vertex_count;
         const nk_size idx_count = (points_count-2)*3;
         const nk_size vtx_count = points_count;
+        nk_size index = nk_draw_list_vertex_index(list, vtx_count);
         void *vtx = nk_draw_list_alloc_vertices(list, vtx_count);
         nk_draw_index *ids = nk_draw_list_alloc_elements(list, idx_count);
 
         if (!vtx || !ids) return;
         for (i = 0; i < vtx_count; ++i)
-            vtx = nk_draw_vertex(vtx, &list->config, points[i], list->config.null.uv, col);
+            vtx = nk_draw_vertex(vtx, list, points[i], list->config.null.uv, col);
         for (i = 2; i < points_count; ++i) {
             ids[0] = (nk_draw_index)index;
             ids[1] = (nk_draw_index)(index+ i - 1);
@@ -9927,21 +11415,26 @@ nk_draw_list_path_clear(struct nk_draw_list *list)
     list->path_count = 0;
     list->path_offset = 0;
 }
-NK_API void
-nk_draw_list_path_line_to(struct nk_draw_list *list, struct nk_vec2 pos)
+/* appends `count` points to the path, for filling them in place */
+NK_INTERN struct nk_vec2*
+nk_draw_list_path_points(struct nk_draw_list *list, int count)
 {
-    struct nk_vec2 *points = 0;
     struct nk_draw_command *cmd = 0;
-    NK_ASSERT(list);
-    if (!list) return;
     if (!list->cmd_count)
         nk_draw_list_add_clip(list, nk_null_rect);
 
     cmd = nk_draw_list_command_last(list);
     if (cmd && cmd->texture.ptr != list->config.null.texture.ptr)
         nk_draw_list_push_image(list, list->config.null.texture);
-
-    points = nk_draw_list_alloc_path(list, 1);
+    return nk_draw_list_alloc_path(list, count);
+}
+NK_API void
+nk_draw_list_path_line_to(struct nk_draw_list *list, struct nk_vec2 pos)
+{
+    struct nk_vec2 *points = 0;
+    NK_ASSERT(list);
+    if (!list) return;
+    points = nk_draw_list_path_points(list, 1);
     if (!points) return;
     points[0] = pos;
 }
@@ -9961,14 +11454,26 @@ nk_draw_list_path_arc_to_fast(struct nk_draw_list *list, struct nk_vec2 center,
         }
     }
 }
-NK_API void
-nk_draw_list_path_arc_to(struct nk_draw_list *list, struct nk_vec2 center,
+/* Number of segments keeping a circular arc of `radius` spanning `angle` radians within
+ * `segment_error` pixels, at most `segments`. A segment spanning `s` radians strays
+ * radius * (1 - cos(s/2)) <= radius * s^2 / 8 from the arc, which gives s = sqrt(8 * error / radius). */
+NK_INTERN unsigned int
+nk_draw_list_arc_segments(const struct nk_draw_list *list, float radius,
+    float angle, unsigned int segments, unsigned int min)
+{
+    float pixels, n;
+    if (list->config.segment_error <= 0.0f || segments <= min)
+        return segments;
+    pixels = NK_ABS(radius) * ((list->config.pixel_scale > 0.0f) ? list->config.pixel_scale : 1.0f);
+    n = NK_ABS(angle) * NK_SQRT(pixels / (8.0f * list->config.segment_error));
+    if (n >= (float)segments) return segments;
+    return NK_MAX(min, (unsigned int)n + 1);
+}
+NK_INTERN void
+nk_draw_list_path_arc_segments(struct nk_draw_list *list, struct nk_vec2 center,
     float radius, float a_min, float a_max, unsigned int segments)
 {
     unsigned int i = 0;
-    NK_ASSERT(list);
-    if (!list) return;
-    if (radius == 0.0f) return;
 
     /*  This algorithm for arc drawing relies on these two trigonometric identities[1]:
             sin(a + b) = sin(a) * cos(b) + cos(a) * sin(b)
@@ -9989,16 +11494,27 @@ nk_draw_list_path_arc_to(struct nk_draw_list *list, struct nk_vec2 center,
         [1] https://en.wikipedia.org/wiki/List_of_trigonometric_identities#Angle_sum_and_difference_identities
     */
     {const float d_angle = (a_max - a_min) / (float)segments;
-    const float sin_d = (float)NK_SIN(d_angle);
-    const float cos_d = (float)NK_COS(d_angle);
+    float sin_d = (float)NK_SIN(d_angle);
+    float cos_d = (float)NK_COS(d_angle);
+    float cx = (float)NK_COS(a_min);
+    float cy = (float)NK_SIN(a_min);
+    float n;
+    struct nk_vec2 *points;
 
-    float cx = (float)NK_COS(a_min) * radius;
-    float cy = (float)NK_SIN(a_min) * radius;
+    /* NK_SIN and NK_COS are approximations a few tenths of a percent off the unit circle, which every
+     * rotation would add to the radius. Both are scaled back with 1/sqrt(x) ~ (3 - x)/2 */
+    n = (3.0f - (sin_d * sin_d + cos_d * cos_d)) * 0.5f;
+    sin_d *= n;
+    cos_d *= n;
+    n = (3.0f - (cx * cx + cy * cy)) * 0.5f * radius;
+    cx *= n;
+    cy *= n;
+    points = nk_draw_list_path_points(list, (int)segments + 1);
+    if (!points) return;
     for(i = 0; i <= segments; ++i) {
         float new_cx, new_cy;
-        const float x = center.x + cx;
-        const float y = center.y + cy;
-        nk_draw_list_path_line_to(list, nk_vec2(x, y));
+        points[i].x = center.x + cx;
+        points[i].y = center.y + cy;
 
         new_cx = cx * cos_d - cy * sin_d;
         new_cy = cy * cos_d + cx * sin_d;
@@ -10007,6 +11523,16 @@ nk_draw_list_path_arc_to(struct nk_draw_list *list, struct nk_vec2 center,
     }}
 }
 NK_API void
+nk_draw_list_path_arc_to(struct nk_draw_list *list, struct nk_vec2 center,
+    float radius, float a_min, float a_max, unsigned int segments)
+{
+    NK_ASSERT(list);
+    if (!list) return;
+    if (radius == 0.0f) return;
+    segments = nk_draw_list_arc_segments(list, radius, a_max - a_min, segments, 1);
+    nk_draw_list_path_arc_segments(list, center, radius, a_min, a_max, segments);
+}
+NK_API void
 nk_draw_list_path_rect_to(struct nk_draw_list *list, struct nk_vec2 a,
     struct nk_vec2 b, float rounding)
 {
@@ -10023,10 +11549,28 @@ nk_draw_list_path_rect_to(struct nk_draw_list *list, struct nk_vec2 a,
         nk_draw_list_path_line_to(list, b);
         nk_draw_list_path_line_to(list, nk_vec2(a.x,b.y));
     } else {
-        nk_draw_list_path_arc_to_fast(list, nk_vec2(a.x + r, a.y + r), r, 6, 9);
-        nk_draw_list_path_arc_to_fast(list, nk_vec2(b.x - r, a.y + r), r, 9, 12);
-        nk_draw_list_path_arc_to_fast(list, nk_vec2(b.x - r, b.y - r), r, 0, 3);
-        nk_draw_list_path_arc_to_fast(list, nk_vec2(a.x + r, b.y - r), r, 3, 6);
+        /* the four corners share one scaled table, the same points
+         * nk_draw_list_path_arc_to_fast would place */
+        static const struct {int right, bottom, a_min;} corners[4] = {
+            {0, 0, 6}, {1, 0, 9}, {1, 1, 0}, {0, 1, 3}
+        };
+        struct nk_vec2 fan[NK_LEN(list->circle_vtx)];
+        struct nk_vec2 *points;
+        int i, j;
+        for (i = 0; i < (int)NK_LEN(fan); ++i) {
+            fan[i].x = list->circle_vtx[i].x * r;
+            fan[i].y = list->circle_vtx[i].y * r;
+        }
+        points = nk_draw_list_path_points(list, 16);
+        if (!points) return;
+        for (i = 0; i < 4; ++i) {
+            const float cx = corners[i].right ? b.x - r : a.x + r;
+            const float cy = corners[i].bottom ? b.y - r : a.y + r;
+            for (j = 0; j < 4; ++j) {
+                const struct nk_vec2 c = fan[(corners[i].a_min + j) % (int)NK_LEN(fan)];
+                points[i * 4 + j] = nk_vec2(cx + c.x, cy + c.y);
+            }
+        }
     }
 }
 NK_API void
@@ -10043,6 +11587,17 @@ nk_draw_list_path_curve_to(struct nk_draw_list *list, struct nk_vec2 p2,
     num_segments = NK_MAX(num_segments, 1);
 
     p1 = nk_draw_list_path_last(list);
+    if (list->config.segment_error > 0.0f && num_segments > 1) {
+        /* Wang's formula: n segments keep a cubic within 3/4 * M / n^2 of its chords,
+         * M being the largest second difference of the control points */
+        const float scale = (list->config.pixel_scale > 0.0f) ? list->config.pixel_scale : 1.0f;
+        const struct nk_vec2 d0 = nk_vec2(p1.x - 2*p2.x + p3.x, p1.y - 2*p2.y + p3.y);
+        const struct nk_vec2 d1 = nk_vec2(p2.x - 2*p3.x + p4.x, p2.y - 2*p3.y + p4.y);
+        const float m = NK_MAX(d0.x*d0.x + d0.y*d0.y, d1.x*d1.x + d1.y*d1.y);
+        const float n = NK_SQRT(0.75f * NK_SQRT(m) * scale / list->config.segment_error);
+        if (n < (float)num_segments)
+            num_segments = NK_MAX(1, (unsigned int)n + 1);
+    }
     t_step = 1.0f/(float)num_segments;
     for (i_step = 1; i_step <= num_segments; ++i_step) {
         float t = t_step * (float)i_step;
@@ -10093,20 +11648,45 @@ nk_draw_list_stroke_line(struct nk_draw_list *list, struct nk_vec2 a,
     }
     nk_draw_list_path_stroke(list,  col, NK_STROKE_OPEN, thickness);
 }
+NK_INTERN int
+nk_draw_list_pixel_aligned(const struct nk_draw_list *list, struct nk_vec2 p)
+{
+    const float scale = (list->config.pixel_scale > 0.0f) ? list->config.pixel_scale : 1.0f;
+    return (float)nk_ifloorf(p.x * scale) == p.x * scale &&
+        (float)nk_ifloorf(p.y * scale) == p.y * scale;
+}
 NK_API void
 nk_draw_list_fill_rect(struct nk_draw_list *list, struct nk_rect rect,
     struct nk_color col, float rounding)
 {
+    struct nk_vec2 a, c;
     NK_ASSERT(list);
     if (!list || !col.a) return;
 
     if (list->line_AA == NK_ANTI_ALIASING_ON) {
-        nk_draw_list_path_rect_to(list, nk_vec2(rect.x, rect.y),
-            nk_vec2(rect.x + rect.w, rect.y + rect.h), rounding);
-    } else {
-        nk_draw_list_path_rect_to(list, nk_vec2(rect.x-0.5f, rect.y-0.5f),
-            nk_vec2(rect.x + rect.w, rect.y + rect.h), rounding);
-    } nk_draw_list_path_fill(list,  col);
+        a = nk_vec2(rect.x, rect.y);
+    } else a = nk_vec2(rect.x-0.5f, rect.y-0.5f);
+    c = nk_vec2(rect.x + rect.w, rect.y + rect.h);
+
+    /* a square rect without anti-aliasing is a single quad, and so is an
+     * anti-aliased one on pixel edges since its feather falls between
+     * pixel centers. Those join the quad runs instead of a polygon fill */
+    if (rounding == 0.0f && (list->config.shape_AA == NK_ANTI_ALIASING_OFF ||
+        (nk_draw_list_pixel_aligned(list, a) && nk_draw_list_pixel_aligned(list, c)))) {
+        void *vtx;
+        struct nk_colorf colf;
+        nk_color_fv(&colf.r, col);
+        nk_draw_list_push_image(list, list->config.null.texture);
+        vtx = nk_draw_list_alloc_quad(list);
+        if (!vtx) return;
+        vtx = nk_draw_vertex(vtx, list, a, list->config.null.uv, colf);
+        vtx = nk_draw_vertex(vtx, list, nk_vec2(c.x, a.y), list->config.null.uv, colf);
+        vtx = nk_draw_vertex(vtx, list, c, list->config.null.uv, colf);
+        vtx = nk_draw_vertex(vtx, list, nk_vec2(a.x, c.y), list->config.null.uv, colf);
+        return;
+    }
+    nk_draw_list_path_rect_to(list, a, c, rounding);
+    nk_draw_list_path_fill(list,  col);
 }
 NK_API void
 nk_draw_list_stroke_rect(struct nk_draw_list *list, struct nk_rect rect,
@@ -10130,8 +11710,6 @@ nk_draw_list_fill_rect_multi_color(struct nk_draw_list *list, struct nk_rect rec
     void *vtx;
     struct nk_colorf col_left, col_top;
     struct nk_colorf col_right, col_bottom;
-    nk_draw_index *idx;
-    nk_draw_index index;
 
     nk_color_fv(&col_left.r, left);
     nk_color_fv(&col_right.r, right);
@@ -10142,19 +11720,13 @@ nk_draw_list_fill_rect_multi_color(struct nk_draw_list *list, struct nk_rect rec
     if (!list) return;
 
     nk_draw_list_push_image(list, list->config.null.texture);
-    index = (nk_draw_index)list->vertex_count;
-    vtx = nk_draw_list_alloc_vertices(list, 4);
-    idx = nk_draw_list_alloc_elements(list, 6);
-    if (!vtx || !idx) return;
+    vtx = nk_draw_list_alloc_quad(list);
+    if (!vtx) return;
 
-    idx[0] = (nk_draw_index)(index+0); idx[1] = (nk_draw_index)(index+1);
-    idx[2] = (nk_draw_index)(index+2); idx[3] = (nk_draw_index)(index+0);
-    idx[4] = (nk_draw_index)(index+2); idx[5] = (nk_draw_index)(index+3);
-
-    vtx = nk_draw_vertex(vtx, &list->config, nk_vec2(rect.x, rect.y), list->config.null.uv, col_left);
-    vtx = nk_draw_vertex(vtx, &list->config, nk_vec2(rect.x + rect.w, rect.y), list->config.null.uv, col_top);
-    vtx = nk_draw_vertex(vtx, &list->config, nk_vec2(rect.x + rect.w, rect.y + rect.h), list->config.null.uv, col_right);
-    vtx = nk_draw_vertex(vtx, &list->config, nk_vec2(rect.x, rect.y + rect.h), list->config.null.uv, col_bottom);
+    vtx = nk_draw_vertex(vtx, list, nk_vec2(rect.x, rect.y), list->config.null.uv, col_left);
+    vtx = nk_draw_vertex(vtx, list, nk_vec2(rect.x + rect.w, rect.y), list->config.null.uv, col_top);
+    vtx = nk_draw_vertex(vtx, list, nk_vec2(rect.x + rect.w, rect.y + rect.h), list->config.null.uv, col_right);
+    vtx = nk_draw_vertex(vtx, list, nk_vec2(rect.x, rect.y + rect.h), list->config.null.uv, col_bottom);
 }
 NK_API void
 nk_draw_list_fill_triangle(struct nk_draw_list *list, struct nk_vec2 a,
@@ -10178,26 +11750,75 @@ nk_draw_list_stroke_triangle(struct nk_draw_list *list, struct nk_vec2 a,
     nk_draw_list_path_line_to(list, c);
     nk_draw_list_path_stroke(list, col, NK_STROKE_CLOSED, thickness);
 }
+/* unit circle points of a circle of `segments` segments, computed once per draw
+ * list. As with nk_draw_list_path_arc_to the segments span all but the last
+ * segment's share of the circle, which the closing edge covers. */
+NK_INTERN const struct nk_vec2*
+nk_draw_list_circle_table(struct nk_draw_list *list, unsigned int segments)
+{
+    struct nk_draw_circle_table *table;
+    struct nk_vec2 *points;
+    unsigned int i;
+    for (i = 0; i < list->circle_table_count; ++i) {
+        if (list->circle_tables[i].segments == segments)
+            return list->circle_lut + list->circle_tables[i].offset;
+    }
+    if (list->circle_table_count == NK_LEN(list->circle_tables) ||
+        segments + 1 > NK_LEN(list->circle_lut) - list->circle_lut_count)
+        return 0;
+
+    table = &list->circle_tables[list->circle_table_count++];
+    table->segments = (unsigned short)segments;
+    table->offset = (unsigned short)list->circle_lut_count;
+    points = list->circle_lut + list->circle_lut_count;
+    list->circle_lut_count += segments + 1;
+    for (i = 0; i <= segments; ++i) {
+        const float a = NK_PI * 2.0f * ((float)segments - 1.0f) / (float)segments *
+            (float)i / (float)segments;
+        points[i].x = (float)NK_COS(a);
+        points[i].y = (float)NK_SIN(a);
+    }
+    return points;
+}
+NK_INTERN void
+nk_draw_list_path_circle(struct nk_draw_list *list, struct nk_vec2 center,
+    float radius, unsigned int segs)
+{
+    const struct nk_vec2 *table;
+    struct nk_vec2 *points;
+    unsigned int i;
+    if (radius == 0.0f || !segs) return;
+    table = nk_draw_list_circle_table(list, segs);
+    if (!table) {
+        nk_draw_list_path_arc_segments(list, center, radius, 0.0f,
+            NK_PI * 2.0f * ((float)segs - 1.0f) / (float)segs, segs);
+        return;
+    }
+    points = nk_draw_list_path_points(list, (int)segs + 1);
+    if (!points) return;
+    for (i = 0; i <= segs; ++i) {
+        points[i].x = center.x + table[i].x * radius;
+        points[i].y = center.y + table[i].y * radius;
+    }
+}
 NK_API void
 nk_draw_list_fill_circle(struct nk_draw_list *list, struct nk_vec2 center,
     float radius, struct nk_color col, unsigned int segs)
 {
-    float a_max;
     NK_ASSERT(list);
     if (!list || !col.a) return;
-    a_max = NK_PI * 2.0f * ((float)segs - 1.0f) / (float)segs;
-    nk_draw_list_path_arc_to(list, center, radius, 0.0f, a_max, segs);
+    segs = nk_draw_list_arc_segments(list, radius, NK_PI * 2.0f, segs, 3);
+    nk_draw_list_path_circle(list, center, radius, segs);
     nk_draw_list_path_fill(list, col);
 }
 NK_API void
 nk_draw_list_stroke_circle(struct nk_draw_list *list, struct nk_vec2 center,
     float radius, struct nk_color col, unsigned int segs, float thickness)
 {
-    float a_max;
     NK_ASSERT(list);
     if (!list || !col.a) return;
-    a_max = NK_PI * 2.0f * ((float)segs - 1.0f) / (float)segs;
-    nk_draw_list_path_arc_to(list, center, radius, 0.0f, a_max, segs);
+    segs = nk_draw_list_arc_segments(list, radius, NK_PI * 2.0f, segs, 3);
+    nk_draw_list_path_circle(list, center, radius, segs);
     nk_draw_list_path_stroke(list, col, NK_STROKE_CLOSED, thickness);
 }
 NK_API void
@@ -10211,6 +11832,84 @@ nk_draw_list_stroke_curve(struct nk_draw_list *list, struct nk_vec2 p0,
     nk_draw_list_path_curve_to(list, cp0, cp1, p1, segments);
     nk_draw_list_path_stroke(list, col, NK_STROKE_OPEN, thickness);
 }
+NK_INTERN int
+nk_draw_list_write_quad_instances(struct nk_draw_list *list,
+    const struct nk_draw_quad_instance *quads, unsigned int count)
+{
+    const nk_size slots = NK_DRAW_QUAD_INSTANCE_SLOTS(list->config.vertex_size);
+    nk_byte *dst = (nk_byte*)nk_draw_list_alloc_vertices(list, slots * count);
+    unsigned int i;
+    if (!dst) return nk_false;
+    for (i = 0; i < count; ++i) {
+        NK_MEMCPY(dst, &quads[i], sizeof(quads[i]));
+        dst += slots * list->config.vertex_size;
+    }
+    list->vertex_base = list->vertex_count;
+    return nk_true;
+}
+NK_INTERN void*
+nk_draw_list_alloc_quad_instance(struct nk_draw_list *list,
+    const struct nk_draw_quad_instance *quad)
+{
+    /* Counterpart of nk_draw_list_alloc_quad for `quad_instances`. A run of
+     * quads is written as usual while the quads are remembered, the quad that
+     * makes it NK_DRAW_LIST_QUAD_RUN long takes the run's vertices and
+     * elements back and writes all of them as instance records into a command
+     * marked `instances`. Following quads of the run are appended to it.
+     * Returns the four vertices to fill or 0 if the quad became an instance. */
+    const nk_size slots = NK_DRAW_QUAD_INSTANCE_SLOTS(list->config.vertex_size);
+    struct nk_draw_command *cmd;
+    nk_draw_index *idx;
+    nk_size index;
+    unsigned int run;
+    void *vtx;
+
+    cmd = nk_draw_list_command_last(list);
+    if (cmd->instances &&
+        cmd->vertex_offset + cmd->elem_count / 6 * slots == list->vertex_count) {
+        if (nk_draw_list_write_quad_instances(list, quad, 1))
+            cmd->elem_count += 6;
+        return 0;
+    }
+
+    run = list->instance_run;
+    if (run + 1 >= NK_DRAW_LIST_QUAD_RUN) {
+        /* the run's vertices and elements are the last ones written */
+        list->vertices->allocated -= run * 4 * list->config.vertex_size;
+        list->vertices->needed -= run * 4 * list->config.vertex_size;
+        list->vertex_count -= run * 4;
+        list->elements->allocated -= run * 6 * sizeof(nk_draw_index);
+        list->elements->needed -= run * 6 * sizeof(nk_draw_index);
+        list->element_count -= run * 6;
+        cmd->elem_count -= run * 6;
+        if (cmd->elem_count) {
+            /* the run may have started with earlier commands' geometry */
+            const struct nk_rect bounds = cmd->bounds;
+            cmd = nk_draw_list_push_command(list, cmd->clip_rect, cmd->texture);
+            if (cmd) cmd->bounds = bounds;
+        }
+        if (!cmd) return 0;
+        cmd->instances = nk_true;
+        cmd->vertex_offset = list->vertex_count;
+        list->instance_pending[run] = *quad;
+        if (nk_draw_list_write_quad_instances(list, list->instance_pending, run + 1))
+            cmd->elem_count = (run + 1) * 6;
+        list->instance_run = 0;
+        return 0;
+    }
+
+    index = nk_draw_list_vertex_index(list, 4);
+    run = list->instance_run;
+    vtx = nk_draw_list_alloc_vertices(list, 4);
+    idx = nk_draw_list_alloc_elements(list, 6);
+    if (!vtx || !idx) return 0;
+    idx[0] = (nk_draw_index)(index+0); idx[1] = (nk_draw_index)(index+1);
+    idx[2] = (nk_draw_index)(index+2); idx[3] = (nk_draw_index)(index+0);
+    idx[4] = (nk_draw_index)(index+2); idx[5] = (nk_draw_index)(index+3);
+    list->instance_pending[run] = *quad;
+    list->instance_run = run + 1;
+    return vtx;
+}
 NK_INTERN void
 nk_draw_list_push_rect_uv(struct nk_draw_list *list, struct nk_vec2 a,
     struct nk_vec2 c, struct nk_vec2 uva, struct nk_vec2 uvc,
@@ -10223,8 +11922,6 @@ nk_draw_list_push_rect_uv(struct nk_draw_list *list, struct nk_vec2 a,
     struct nk_vec2 d;
 
     struct nk_colorf col;
-    nk_draw_index *idx;
-    nk_draw_index index;
     NK_ASSERT(list);
     if (!list) return;
 
@@ -10234,19 +11931,19 @@ nk_draw_list_push_rect_uv(struct nk_draw_list *list, struct nk_vec2 a,
     b = nk_vec2(c.x, a.y);
     d = nk_vec2(a.x, c.y);
 
-    index = (nk_draw_index)list->vertex_count;
-    vtx = nk_draw_list_alloc_vertices(list, 4);
-    idx = nk_draw_list_alloc_elements(list, 6);
-    if (!vtx || !idx) return;
-
-    idx[0] = (nk_draw_index)(index+0); idx[1] = (nk_draw_index)(index+1);
-    idx[2] = (nk_draw_index)(index+2); idx[3] = (nk_draw_index)(index+0);
-    idx[4] = (nk_draw_index)(index+2); idx[5] = (nk_draw_index)(index+3);
+    if (list->config.quad_instances && list->cmd_count) {
+        struct nk_draw_quad_instance quad;
+        quad.a = a; quad.c = c;
+        quad.uva = uva; quad.uvc = uvc;
+        quad.col = nk_rgba_cf(col);
+        vtx = nk_draw_list_alloc_quad_instance(list, &quad);
+    } else vtx = nk_draw_list_alloc_quad(list);
+    if (!vtx) return;
 
-    vtx = nk_draw_vertex(vtx, &list->config, a, uva, col);
-    vtx = nk_draw_vertex(vtx, &list->config, b, uvb, col);
-    vtx = nk_draw_vertex(vtx, &list->config, c, uvc, col);
-    vtx = nk_draw_vertex(vtx, &list->config, d, uvd, col);
+    vtx = nk_draw_vertex(vtx, list, a, uva, col);
+    vtx = nk_draw_vertex(vtx, list, b, uvb, col);
+    vtx = nk_draw_vertex(vtx, list, c, uvc, col);
+    vtx = nk_draw_vertex(vtx, list, d, uvd, col);
 }
 NK_API void
 nk_draw_list_add_image(struct nk_draw_list *list, struct nk_image texture,
@@ -10319,6 +12016,139 @@ nk_draw_list_add_text(struct nk_draw_list *list, const struct nk_user_font *font
         unicode = next;
     }
 }
+NK_INTERN void
+nk_convert_command(struct nk_draw_list *list, const struct nk_command *cmd,
+    const struct nk_convert_config *config)
+{
+    unsigned int first = list->cmd_count, first_elements = 0;
+#ifdef NK_INCLUDE_COMMAND_USERDATA
+    list->userdata = cmd->userdata;
+#endif
+    if (first) first_elements = nk_draw_list_command_last(list)->elem_count;
+    switch (cmd->type) {
+    case NK_COMMAND_NOP: break;
+    case NK_COMMAND_SCISSOR: {
+        const struct nk_command_scissor *s = (const struct nk_command_scissor*)cmd;
+        nk_draw_list_add_clip(list, nk_rect(s->x, s->y, s->w, s->h));
+    } break;
+    case NK_COMMAND_LINE: {
+        const struct nk_command_line *l = (const struct nk_command_line*)cmd;
+        nk_draw_list_stroke_line(list, nk_vec2(l->begin.x, l->begin.y),
+            nk_vec2(l->end.x, l->end.y), l->color, l->line_thickness);
+    } break;
+    case NK_COMMAND_CURVE: {
+        const struct nk_command_curve *q = (const struct nk_command_curve*)cmd;
+        nk_draw_list_stroke_curve(list, nk_vec2(q->begin.x, q->begin.y),
+            nk_vec2(q->ctrl[0].x, q->ctrl[0].y), nk_vec2(q->ctrl[1].x,
+            q->ctrl[1].y), nk_vec2(q->end.x, q->end.y), q->color,
+            config->curve_segment_count, q->line_thickness);
+    } break;
+    case NK_COMMAND_RECT: {
+        const struct nk_command_rect *r = (const struct nk_command_rect*)cmd;
+        nk_draw_list_stroke_rect(list, nk_rect(r->x, r->y, r->w, r->h),
+            r->color, (float)r->rounding, r->line_thickness);
+    } break;
+    case NK_COMMAND_RECT_FILLED: {
+        const struct nk_command_rect_filled *r = (const struct nk_command_rect_filled*)cmd;
+        nk_draw_list_fill_rect(list, nk_rect(r->x, r->y, r->w, r->h),
+            r->color, (float)r->rounding);
+    } break;
+    case NK_COMMAND_RECT_MULTI_COLOR: {
+        const struct nk_command_rect_multi_color *r = (const struct nk_command_rect_multi_color*)cmd;
+        nk_draw_list_fill_rect_multi_color(list, nk_rect(r->x, r->y, r->w, r->h),
+            r->left, r->top, r->right, r->bottom);
+    } break;
+    case NK_COMMAND_CIRCLE: {
+        const struct nk_command_circle *c = (const struct nk_command_circle*)cmd;
+        nk_draw_list_stroke_circle(list, nk_vec2((float)c->x + (float)c->w/2,
+            (float)c->y + (float)c->h/2), (float)c->w/2, c->color,
+            config->circle_segment_count, c->line_thickness);
+    } break;
+    case NK_COMMAND_CIRCLE_FILLED: {
+        const struct nk_command_circle_filled *c = (const struct nk_command_circle_filled *)cmd;
+        nk_draw_list_fill_circle(list, nk_vec2((float)c->x + (float)c->w/2,
+            (float)c->y + (float)c->h/2), (float)c->w/2, c->color,
+            config->circle_segment_count);
+    } break;
+    case NK_COMMAND_ARC: {
+        const struct nk_command_arc *c = (const struct nk_command_arc*)cmd;
+        nk_draw_list_path_line_to(list, nk_vec2(c->cx, c->cy));
+        nk_draw_list_path_arc_to(list, nk_vec2(c->cx, c->cy), c->r,
+            c->a[0], c->a[1], config->arc_segment_count);
+        nk_draw_list_path_stroke(list, c->color, NK_STROKE_CLOSED, c->line_thickness);
+    } break;
+    case NK_COMMAND_ARC_FILLED: {
+        const struct nk_command_arc_filled *c = (const struct nk_command_arc_filled*)cmd;
+        nk_draw_list_path_line_to(list, nk_vec2(c->cx, c->cy));
+        nk_draw_list_path_arc_to(list, nk_vec2(c->cx, c->cy), c->r,
+            c->a[0], c->a[1], config->arc_segment_count);
+        nk_draw_list_path_fill(list, c->color);
+    } break;
+    case NK_COMMAND_TRIANGLE: {
+        const struct nk_command_triangle *t = (const struct nk_command_triangle*)cmd;
+        nk_draw_list_stroke_triangle(list, nk_vec2(t->a.x, t->a.y),
+            nk_vec2(t->b.x, t->b.y), nk_vec2(t->c.x, t->c.y), t->color,
+            t->line_thickness);
+    } break;
+    case NK_COMMAND_TRIANGLE_FILLED: {
+        const struct nk_command_triangle_filled *t = (const struct nk_command_triangle_filled*)cmd;
+        nk_draw_list_fill_triangle(list, nk_vec2(t->a.x, t->a.y),
+            nk_vec2(t->b.x, t->b.y), nk_vec2(t->c.x, t->c.y), t->color);
+    } break;
+    case NK_COMMAND_POLYGON: {
+        int i;
+        const struct nk_command_polygon*p = (const struct nk_command_polygon*)cmd;
+        for (i = 0; i < p->point_count; ++i) {
+            struct nk_vec2 pnt = nk_vec2((float)p->points[i].x, (float)p->points[i].y);
+            nk_draw_list_path_line_to(list, pnt);
+        }
+        nk_draw_list_path_stroke(list, p->color, NK_STROKE_CLOSED, p->line_thickness);
+    } break;
+    case NK_COMMAND_POLYGON_FILLED: {
+        int i;
+        const struct nk_command_polygon_filled *p = (const struct nk_command_polygon_filled*)cmd;
+        for (i = 0; i < p->point_count; ++i) {
+            struct nk_vec2 pnt = nk_vec2((float)p->points[i].x, (float)p->points[i].y);
+            nk_draw_list_path_line_to(list, pnt);
+        }
+        nk_draw_list_path_fill(list, p->color);
+    } break;
+    case NK_COMMAND_POLYLINE: {
+        int i;
+        const struct nk_command_polyline *p = (const struct nk_command_polyline*)cmd;
+        for (i = 0; i < p->point_count; ++i) {
+            struct nk_vec2 pnt = nk_vec2((float)p->points[i].x, (float)p->points[i].y);
+            nk_draw_list_path_line_to(list, pnt);
+        }
+        nk_draw_list_path_stroke(list, p->color, NK_STROKE_OPEN, p->line_thickness);
+    } break;
+    case NK_COMMAND_TEXT: {
+        const struct nk_command_text *t = (const struct nk_command_text*)cmd;
+        nk_draw_list_add_text(list, t->font, nk_rect(t->x, t->y, t->w, t->h),
+            t->string, t->length, t->height, t->foreground);
+    } break;
+    case NK_COMMAND_IMAGE: {
+        const struct nk_command_image *i = (const struct nk_command_image*)cmd;
+        nk_draw_list_add_image(list, i->img, nk_rect(i->x, i->y, i->w, i->h), i->col);
+    } break;
+    case NK_COMMAND_CUSTOM: {
+        const struct nk_command_custom *c = (const struct nk_command_custom*)cmd;
+        c->callback(list, c->x, c->y, c->w, c->h, c->callback_data);
+    } break;
+    default: break;
+    }
+    if (list->cmd_count && cmd->type != NK_COMMAND_NOP && cmd->type != NK_COMMAND_SCISSOR) {
+        /* every draw command the command added to: the new ones and the one
+         * that was last before it, if its elements changed */
+        struct nk_rect bounds = nk_damage_command_bounds(cmd);
+        struct nk_draw_command *last = nk_draw_list_command_last(list);
+        unsigned int i = first ? first - 1 : 0;
+        if (first && last[list->cmd_count - first].elem_count == first_elements) i = first;
+        for (; i < list->cmd_count; ++i)
+            last[list->cmd_count - 1 - i].bounds =
+                nk_damage_union(last[list->cmd_count - 1 - i].bounds, bounds);
+    }
+}
 NK_API nk_flags
 nk_convert(struct nk_context *ctx, struct nk_buffer *cmds,
     struct nk_buffer *vertices, struct nk_buffer *elements,
@@ -10339,127 +12169,631 @@ nk_convert(struct nk_context *ctx, struct nk_buffer *cmds,
     nk_draw_list_setup(&ctx->draw_list, config, cmds, vertices, elements,
         config->line_AA, config->shape_AA);
     nk_foreach(cmd, ctx)
-    {
-#ifdef NK_INCLUDE_COMMAND_USERDATA
-        ctx->draw_list.userdata = cmd->userdata;
+        nk_convert_command(&ctx->draw_list, cmd, config);
+    res |= (cmds->needed > cmds->allocated + (cmds->memory.size - cmds->size)) ? NK_CONVERT_COMMAND_BUFFER_FULL: 0;
+    res |= (vertices->needed > vertices->allocated) ? NK_CONVERT_VERTEX_BUFFER_FULL: 0;
+    res |= (elements->needed > elements->allocated) ? NK_CONVERT_ELEMENT_BUFFER_FULL: 0;
+    return res;
+}
+struct nk_convert_unit {
+    nk_size begin; /* offset of the first command */
+    int count; /* number of commands */
+    struct nk_rect clip; /* clip rect active before the first command */
+    nk_hash key; /* fingerprint of the commands above */
+    nk_hash hash; /* fingerprint of the commands converted into the buffers below */
+    int valid; /* buffers hold a conversion of `hash` */
+    int reuse; /* buffers already hold the conversion of `key` */
+    struct nk_draw_list list;
+    struct nk_buffer cmds;
+    struct nk_buffer vertices;
+    struct nk_buffer elements;
+};
+struct nk_convert_work {
+    struct nk_context *ctx;
+    struct nk_convert_state *state;
+    const struct nk_convert_config *config;
+};
+NK_API void
+nk_convert_state_init(struct nk_convert_state *state, const struct nk_allocator *alloc)
+{
+    NK_ASSERT(state);
+    NK_ASSERT(alloc);
+    if (!state || !alloc) return;
+    nk_zero(state, sizeof(*state));
+    state->pool = *alloc;
+}
+#ifdef NK_INCLUDE_DEFAULT_ALLOCATOR
+NK_API void
+nk_convert_state_init_default(struct nk_convert_state *state)
+{
+    struct nk_allocator alloc;
+    alloc.userdata.ptr = 0;
+    alloc.alloc = nk_malloc;
+    alloc.free = nk_mfree;
+    nk_convert_state_init(state, &alloc);
+}
 #endif
-        switch (cmd->type) {
-        case NK_COMMAND_NOP: break;
-        case NK_COMMAND_SCISSOR: {
+NK_API void
+nk_convert_state_free(struct nk_convert_state *state)
+{
+    int i;
+    NK_ASSERT(state);
+    if (!state || !state->units) return;
+    for (i = 0; i < state->unit_capacity; ++i) {
+        nk_buffer_free(&state->units[i].cmds);
+        nk_buffer_free(&state->units[i].vertices);
+        nk_buffer_free(&state->units[i].elements);
+    }
+    state->pool.free(state->pool.userdata, state->units);
+    state->units = 0;
+    state->unit_count = state->unit_capacity = 0;
+}
+NK_API void
+nk_convert_state_invalidate(struct nk_convert_state *state)
+{
+    int i;
+    NK_ASSERT(state);
+    if (!state) return;
+    for (i = 0; i < state->unit_capacity; ++i)
+        state->units[i].valid = nk_false;
+}
+NK_INTERN struct nk_convert_unit*
+nk_convert_state_push_unit(struct nk_convert_state *state)
+{
+    if (state->unit_count == state->unit_capacity) {
+        int i, capacity = state->unit_capacity ? state->unit_capacity * 2 : 16;
+        struct nk_convert_unit *units = (struct nk_convert_unit*)state->pool.alloc(
+            state->pool.userdata, 0, sizeof(struct nk_convert_unit) * (nk_size)capacity);
+        if (!units) return 0;
+        if (state->units) {
+            /* draw lists point into their own unit but are set up again before use */
+            NK_MEMCPY(units, state->units, sizeof(struct nk_convert_unit) * (nk_size)state->unit_capacity);
+            state->pool.free(state->pool.userdata, state->units);
+        }
+        for (i = state->unit_capacity; i < capacity; ++i) {
+            units[i].valid = nk_false;
+            nk_draw_list_init(&units[i].list);
+            nk_buffer_init(&units[i].cmds, &state->pool, NK_BUFFER_DEFAULT_INITIAL_SIZE);
+            nk_buffer_init(&units[i].vertices, &state->pool, NK_BUFFER_DEFAULT_INITIAL_SIZE);
+            nk_buffer_init(&units[i].elements, &state->pool, NK_BUFFER_DEFAULT_INITIAL_SIZE);
+        }
+        state->units = units;
+        state->unit_capacity = capacity;
+    }
+    return &state->units[state->unit_count++];
+}
+NK_INTERN nk_hash
+nk_convert_config_hash(const struct nk_convert_config *config)
+{
+    const struct nk_draw_vertex_layout_element *elem;
+    nk_hash h = 0;
+    h = nk_murmur_hash(&config->global_alpha, (int)sizeof(config->global_alpha), h);
+    h = nk_murmur_hash(&config->line_AA, (int)sizeof(config->line_AA), h);
+    h = nk_murmur_hash(&config->shape_AA, (int)sizeof(config->shape_AA), h);
+    h = nk_murmur_hash(&config->circle_segment_count, (int)sizeof(config->circle_segment_count), h);
+    h = nk_murmur_hash(&config->arc_segment_count, (int)sizeof(config->arc_segment_count), h);
+    h = nk_murmur_hash(&config->curve_segment_count, (int)sizeof(config->curve_segment_count), h);
+    h = nk_murmur_hash(&config->segment_error, (int)sizeof(config->segment_error), h);
+    h = nk_murmur_hash(&config->pixel_scale, (int)sizeof(config->pixel_scale), h);
+    h = nk_murmur_hash(&config->null.texture, (int)sizeof(config->null.texture), h);
+    h = nk_murmur_hash(&config->null.uv, (int)sizeof(config->null.uv), h);
+    h = nk_murmur_hash(&config->vertex_size, (int)sizeof(config->vertex_size), h);
+    h = nk_murmur_hash(&config->vertex_alignment, (int)sizeof(config->vertex_alignment), h);
+    h = nk_murmur_hash(&config->quad_batch, (int)sizeof(config->quad_batch), h);
+    h = nk_murmur_hash(&config->quad_instances, (int)sizeof(config->quad_instances), h);
+    for (elem = config->vertex_layout; elem->attribute != NK_VERTEX_ATTRIBUTE_COUNT; ++elem) {
+        h = nk_murmur_hash(&elem->attribute, (int)sizeof(elem->attribute), h);
+        h = nk_murmur_hash(&elem->format, (int)sizeof(elem->format), h);
+        h = nk_murmur_hash(&elem->offset, (int)sizeof(elem->offset), h);
+    }
+    return h;
+}
+NK_INTERN void
+nk_convert_unit_swap_output(struct nk_convert_unit *a, struct nk_convert_unit *b)
+{
+    struct nk_convert_unit tmp = *a;
+    a->hash = b->hash; a->valid = b->valid; a->list = b->list;
+    a->cmds = b->cmds; a->vertices = b->vertices; a->elements = b->elements;
+    b->hash = tmp.hash; b->valid = tmp.valid; b->list = tmp.list;
+    b->cmds = tmp.cmds; b->vertices = tmp.vertices; b->elements = tmp.elements;
+}
+NK_INTERN void
+nk_convert_state_match_unit(struct nk_convert_state *state, int index)
+{
+    struct nk_convert_unit *unit = &state->units[index];
+    int i;
+    if (!unit->valid || unit->hash != unit->key) {
+        /* windows change places when focused, look for the output further back */
+        for (i = index + 1; i < state->unit_capacity; ++i) {
+            struct nk_convert_unit *other = &state->units[i];
+            if (!other->valid || other->hash != unit->key) continue;
+            nk_convert_unit_swap_output(unit, other);
+            break;
+        }
+    }
+    unit->reuse = unit->valid && unit->hash == unit->key;
+}
+NK_INTERN void
+nk_convert_unit_job(void *data, int index, int worker)
+{
+    struct nk_convert_work *work = (struct nk_convert_work*)data;
+    struct nk_convert_unit *unit = &work->state->units[index];
+    const struct nk_convert_config *config = work->config;
+    const struct nk_command *cmd;
+    int i;
+    NK_UNUSED(worker);
+    if (unit->reuse) return;
+
+    nk_buffer_clear(&unit->cmds);
+    nk_buffer_clear(&unit->vertices);
+    nk_buffer_clear(&unit->elements);
+    nk_draw_list_setup(&unit->list, config, &unit->cmds, &unit->vertices, &unit->elements,
+        config->line_AA, config->shape_AA);
+    /* continue with the clip rect the previous unit left behind */
+    nk_draw_list_push_command(&unit->list, unit->clip, config->null.texture);
+
+    cmd = nk_ptr_add_const(struct nk_command, work->ctx->memory.memory.ptr, unit->begin);
+    for (i = 0; i < unit->count && cmd; ++i, cmd = nk__next(work->ctx, cmd))
+        nk_convert_command(&unit->list, cmd, config);
+    unit->hash = unit->key;
+    unit->valid = nk_true;
+}
+NK_INTERN void
+nk_convert_append_unit(struct nk_draw_list *list, const struct nk_convert_unit *unit)
+{
+    const struct nk_draw_list *src = &unit->list;
+    const struct nk_draw_command *cmd;
+    const nk_draw_index *src_idx;
+    nk_draw_index *dst_idx;
+    unsigned int base = list->vertex_count;
+    unsigned int shift = base;
+    int first = nk_true;
+    unsigned int i;
+
+    /* the unit's elements are shifted into the vertex range of the current
+     * draw command while they stay addressable, with 16-bit indices the unit
+     * otherwise starts a new range and keeps its elements as they are */
+    if (sizeof(nk_draw_index) == 2) {
+        if (base - list->vertex_base + src->vertex_count <= NK_USHORT_MAX + 1)
+            shift = base - list->vertex_base;
+        else shift = 0;
+    }
+    if (src->vertex_count) {
+        nk_size size = list->config.vertex_size * src->vertex_count;
+        void *vtx = nk_buffer_alloc(list->vertices, NK_BUFFER_FRONT, size,
+            list->config.vertex_alignment);
+        if (!vtx) {
+            /* still count the elements so both buffers can be resized at once */
+            list->elements->needed += sizeof(nk_draw_index) * src->element_count;
+            return;
+        }
+        NK_MEMCPY(vtx, nk_buffer_memory_const(&unit->vertices), size);
+        list->vertex_count += src->vertex_count;
+    }
+    if (src->element_count) {
+        dst_idx = (nk_draw_index*)nk_buffer_alloc(list->elements, NK_BUFFER_FRONT,
+            sizeof(nk_draw_index) * src->element_count, NK_ALIGNOF(nk_draw_index));
+        if (!dst_idx) return;
+        src_idx = (const nk_draw_index*)nk_buffer_memory_const(&unit->elements);
+        if (shift) {
+            for (i = 0; i < src->element_count; ++i)
+                dst_idx[i] = (nk_draw_index)(src_idx[i] + shift);
+        } else NK_MEMCPY(dst_idx, src_idx, sizeof(nk_draw_index) * src->element_count);
+        list->element_count += src->element_count;
+    }
+
+    nk_draw_list_foreach(cmd, src, &unit->cmds) {
+        struct nk_draw_command *prev = list->cmd_count ? nk_draw_list_command_last(list) : 0;
+        if (!cmd->elem_count) continue;
+        if (cmd->quads || cmd->instances) {
+            /* runs of quads have no elements, only their vertices move */
+        #ifdef NK_INCLUDE_COMMAND_USERDATA
+            list->userdata = cmd->userdata;
+        #endif
+            prev = nk_draw_list_push_command(list, cmd->clip_rect, cmd->texture);
+            if (!prev) return;
+            prev->quads = cmd->quads;
+            prev->instances = cmd->instances;
+            prev->vertex_offset = base + cmd->vertex_offset;
+            prev->elem_count = cmd->elem_count;
+            prev->bounds = cmd->bounds;
+            first = nk_false;
+            continue;
+        }
+        list->vertex_base = base - shift + cmd->vertex_offset;
+        if (first && prev && !prev->quads && !prev->instances && prev->texture.id == cmd->texture.id &&
+            prev->vertex_offset == list->vertex_base &&
+            prev->clip_rect.x == cmd->clip_rect.x && prev->clip_rect.y == cmd->clip_rect.y &&
+            prev->clip_rect.w == cmd->clip_rect.w && prev->clip_rect.h == cmd->clip_rect.h
+        #ifdef NK_INCLUDE_COMMAND_USERDATA
+            && prev->userdata.id == cmd->userdata.id
+        #endif
+        ) {
+            /* the unit continues with the state the previous one ended in */
+            prev->elem_count += cmd->elem_count;
+            prev->bounds = nk_damage_union(prev->bounds, cmd->bounds);
+        } else {
+        #ifdef NK_INCLUDE_COMMAND_USERDATA
+            list->userdata = cmd->userdata;
+        #endif
+            prev = nk_draw_list_push_command(list, cmd->clip_rect, cmd->texture);
+            if (!prev) return;
+            prev->elem_count = cmd->elem_count;
+            prev->bounds = cmd->bounds;
+        }
+        first = nk_false;
+    }
+}
+NK_API nk_flags
+nk_convert_windows(struct nk_context *ctx, struct nk_convert_state *state,
+    struct nk_buffer *cmds, struct nk_buffer *vertices, struct nk_buffer *elements,
+    const struct nk_convert_config *config)
+{
+    nk_flags res = NK_CONVERT_SUCCESS;
+    const struct nk_command *cmd;
+    struct nk_convert_unit *unit = 0;
+    struct nk_command_units units;
+    struct nk_convert_work work;
+    struct nk_rect clip = nk_null_rect;
+    nk_hash config_hash;
+    int i;
+
+    NK_ASSERT(ctx);
+    NK_ASSERT(state);
+    NK_ASSERT(cmds);
+    NK_ASSERT(vertices);
+    NK_ASSERT(elements);
+    NK_ASSERT(config);
+    NK_ASSERT(config->vertex_layout);
+    NK_ASSERT(config->vertex_size);
+    if (!ctx || !state || !cmds || !vertices || !elements || !config || !config->vertex_layout)
+        return NK_CONVERT_INVALID_PARAM;
+
+    /* split the queue at every window, popup and overlay buffer */
+    state->unit_count = 0;
+    config_hash = nk_convert_config_hash(config);
+    nk_command_units_begin(ctx, &units);
+    nk_foreach(cmd, ctx) {
+        nk_size offset = (nk_size)((const nk_byte*)cmd - (const nk_byte*)ctx->memory.memory.ptr);
+        if (nk_command_units_next(ctx, &units, cmd, 0) || !unit) {
+            unit = nk_convert_state_push_unit(state);
+            if (!unit) return NK_CONVERT_COMMAND_BUFFER_FULL;
+            unit->begin = offset;
+            unit->count = 0;
+            unit->clip = clip;
+            unit->key = nk_murmur_hash(&clip, (int)sizeof(clip), config_hash);
+        }
+        unit->count++;
+        unit->key = nk_command_hash(cmd, unit->key);
+        if (cmd->type == NK_COMMAND_SCISSOR) {
             const struct nk_command_scissor *s = (const struct nk_command_scissor*)cmd;
-            nk_draw_list_add_clip(&ctx->draw_list, nk_rect(s->x, s->y, s->w, s->h));
-        } break;
-        case NK_COMMAND_LINE: {
-            const struct nk_command_line *l = (const struct nk_command_line*)cmd;
-            nk_draw_list_stroke_line(&ctx->draw_list, nk_vec2(l->begin.x, l->begin.y),
-                nk_vec2(l->end.x, l->end.y), l->color, l->line_thickness);
-        } break;
-        case NK_COMMAND_CURVE: {
-            const struct nk_command_curve *q = (const struct nk_command_curve*)cmd;
-            nk_draw_list_stroke_curve(&ctx->draw_list, nk_vec2(q->begin.x, q->begin.y),
-                nk_vec2(q->ctrl[0].x, q->ctrl[0].y), nk_vec2(q->ctrl[1].x,
-                q->ctrl[1].y), nk_vec2(q->end.x, q->end.y), q->color,
-                config->curve_segment_count, q->line_thickness);
-        } break;
-        case NK_COMMAND_RECT: {
-            const struct nk_command_rect *r = (const struct nk_command_rect*)cmd;
-            nk_draw_list_stroke_rect(&ctx->draw_list, nk_rect(r->x, r->y, r->w, r->h),
-                r->color, (float)r->rounding, r->line_thickness);
-        } break;
-        case NK_COMMAND_RECT_FILLED: {
-            const struct nk_command_rect_filled *r = (const struct nk_command_rect_filled*)cmd;
-            nk_draw_list_fill_rect(&ctx->draw_list, nk_rect(r->x, r->y, r->w, r->h),
-                r->color, (float)r->rounding);
-        } break;
-        case NK_COMMAND_RECT_MULTI_COLOR: {
-            const struct nk_command_rect_multi_color *r = (const struct nk_command_rect_multi_color*)cmd;
-            nk_draw_list_fill_rect_multi_color(&ctx->draw_list, nk_rect(r->x, r->y, r->w, r->h),
-                r->left, r->top, r->right, r->bottom);
-        } break;
-        case NK_COMMAND_CIRCLE: {
-            const struct nk_command_circle *c = (const struct nk_command_circle*)cmd;
-            nk_draw_list_stroke_circle(&ctx->draw_list, nk_vec2((float)c->x + (float)c->w/2,
-                (float)c->y + (float)c->h/2), (float)c->w/2, c->color,
-                config->circle_segment_count, c->line_thickness);
-        } break;
-        case NK_COMMAND_CIRCLE_FILLED: {
-            const struct nk_command_circle_filled *c = (const struct nk_command_circle_filled *)cmd;
-            nk_draw_list_fill_circle(&ctx->draw_list, nk_vec2((float)c->x + (float)c->w/2,
-                (float)c->y + (float)c->h/2), (float)c->w/2, c->color,
-                config->circle_segment_count);
-        } break;
-        case NK_COMMAND_ARC: {
-            const struct nk_command_arc *c = (const struct nk_command_arc*)cmd;
-            nk_draw_list_path_line_to(&ctx->draw_list, nk_vec2(c->cx, c->cy));
-            nk_draw_list_path_arc_to(&ctx->draw_list, nk_vec2(c->cx, c->cy), c->r,
-                c->a[0], c->a[1], config->arc_segment_count);
-            nk_draw_list_path_stroke(&ctx->draw_list, c->color, NK_STROKE_CLOSED, c->line_thickness);
-        } break;
-        case NK_COMMAND_ARC_FILLED: {
-            const struct nk_command_arc_filled *c = (const struct nk_command_arc_filled*)cmd;
-            nk_draw_list_path_line_to(&ctx->draw_list, nk_vec2(c->cx, c->cy));
-            nk_draw_list_path_arc_to(&ctx->draw_list, nk_vec2(c->cx, c->cy), c->r,
-                c->a[0], c->a[1], config->arc_segment_count);
-            nk_draw_list_path_fill(&ctx->draw_list, c->color);
-        } break;
-        case NK_COMMAND_TRIANGLE: {
-            const struct nk_command_triangle *t = (const struct nk_command_triangle*)cmd;
-            nk_draw_list_stroke_triangle(&ctx->draw_list, nk_vec2(t->a.x, t->a.y),
-                nk_vec2(t->b.x, t->b.y), nk_vec2(t->c.x, t->c.y), t->color,
-                t->line_thickness);
-        } break;
-        case NK_COMMAND_TRIANGLE_FILLED: {
-            const struct nk_command_triangle_filled *t = (const struct nk_command_triangle_filled*)cmd;
-            nk_draw_list_fill_triangle(&ctx->draw_list, nk_vec2(t->a.x, t->a.y),
-                nk_vec2(t->b.x, t->b.y), nk_vec2(t->c.x, t->c.y), t->color);
-        } break;
-        case NK_COMMAND_POLYGON: {
-            int i;
-            const struct nk_command_polygon*p = (const struct nk_command_polygon*)cmd;
-            for (i = 0; i < p->point_count; ++i) {
-                struct nk_vec2 pnt = nk_vec2((float)p->points[i].x, (float)p->points[i].y);
-                nk_draw_list_path_line_to(&ctx->draw_list, pnt);
-            }
-            nk_draw_list_path_stroke(&ctx->draw_list, p->color, NK_STROKE_CLOSED, p->line_thickness);
-        } break;
-        case NK_COMMAND_POLYGON_FILLED: {
-            int i;
-            const struct nk_command_polygon_filled *p = (const struct nk_command_polygon_filled*)cmd;
-            for (i = 0; i < p->point_count; ++i) {
-                struct nk_vec2 pnt = nk_vec2((float)p->points[i].x, (float)p->points[i].y);
-                nk_draw_list_path_line_to(&ctx->draw_list, pnt);
-            }
-            nk_draw_list_path_fill(&ctx->draw_list, p->color);
-        } break;
-        case NK_COMMAND_POLYLINE: {
-            int i;
-            const struct nk_command_polyline *p = (const struct nk_command_polyline*)cmd;
-            for (i = 0; i < p->point_count; ++i) {
-                struct nk_vec2 pnt = nk_vec2((float)p->points[i].x, (float)p->points[i].y);
-                nk_draw_list_path_line_to(&ctx->draw_list, pnt);
+            clip = nk_rect(s->x, s->y, s->w, s->h);
+        }
+    }
+
+    /* reuse the output of units that did not change since they were converted */
+    state->units_reused = 0;
+    for (i = 0; i < state->unit_count; ++i) {
+        nk_convert_state_match_unit(state, i);
+        state->units_reused += state->units[i].reuse;
+    }
+
+    /* convert every other unit into its private buffers */
+    work.ctx = ctx;
+    work.state = state;
+    work.config = config;
+    if (state->dispatch)
+        state->dispatch(state->scheduler, state->unit_count, nk_convert_unit_job, &work);
+    else for (i = 0; i < state->unit_count; ++i)
+        nk_convert_unit_job(&work, i, 0);
+
+    /* concatenate in queue order */
+    nk_draw_list_setup(&ctx->draw_list, config, cmds, vertices, elements,
+        config->line_AA, config->shape_AA);
+    for (i = 0; i < state->unit_count; ++i)
+        nk_convert_append_unit(&ctx->draw_list, &state->units[i]);
+
+    res |= (cmds->needed > cmds->allocated + (cmds->memory.size - cmds->size)) ? NK_CONVERT_COMMAND_BUFFER_FULL: 0;
+    res |= (vertices->needed > vertices->allocated) ? NK_CONVERT_VERTEX_BUFFER_FULL: 0;
+    res |= (elements->needed > elements->allocated) ? NK_CONVERT_ELEMENT_BUFFER_FULL: 0;
+    return res;
+}
+struct nk_draw_merge_command {
+    struct nk_draw_command cmd;
+    struct nk_rect region; /* part of the screen the command can change */
+    int clipped; /* the clip rect cuts into the geometry */
+    nk_size element; /* first element in the converted element buffer */
+    unsigned int reach; /* vertices addressed past vertex_offset, 0 until needed */
+    int next; /* next command of the same group */
+};
+struct nk_draw_merge_group {
+    int first, last;
+    struct nk_rect scissor; /* clip rect if clipped, otherwise the bounds of all commands */
+    struct nk_rect region;
+    int clipped;
+    int same_clip; /* all commands share the clip rect of the first */
+    unsigned int begin, end; /* vertices addressed by the commands */
+    unsigned int top; /* highest vertex offset of the commands */
+    int exact; /* end is known, for elements it takes a scan */
+    unsigned int elem_count;
+};
+NK_API void
+nk_draw_merge_init(struct nk_draw_merge *merge, const struct nk_allocator *alloc)
+{
+    NK_ASSERT(merge);
+    NK_ASSERT(alloc);
+    if (!merge || !alloc) return;
+    nk_zero(merge, sizeof(*merge));
+    nk_buffer_init(&merge->scratch, alloc, NK_BUFFER_DEFAULT_INITIAL_SIZE);
+}
+#ifdef NK_INCLUDE_DEFAULT_ALLOCATOR
+NK_API void
+nk_draw_merge_init_default(struct nk_draw_merge *merge)
+{
+    struct nk_allocator alloc;
+    alloc.userdata.ptr = 0;
+    alloc.alloc = nk_malloc;
+    alloc.free = nk_mfree;
+    nk_draw_merge_init(merge, &alloc);
+}
+#endif
+NK_API void
+nk_draw_merge_free(struct nk_draw_merge *merge)
+{
+    NK_ASSERT(merge);
+    if (!merge) return;
+    nk_buffer_free(&merge->scratch);
+}
+NK_INTERN int
+nk_draw_merge_inside(struct nk_rect a, struct nk_rect b)
+{
+    return a.x >= b.x && a.y >= b.y && a.x + a.w <= b.x + b.w && a.y + a.h <= b.y + b.h;
+}
+NK_INTERN int
+nk_draw_merge_overlap(struct nk_rect a, struct nk_rect b)
+{
+    return a.w > 0 && a.h > 0 && b.w > 0 && b.h > 0 &&
+        a.x < b.x + b.w && b.x < a.x + a.w && a.y < b.y + b.h && b.y < a.y + a.h;
+}
+NK_INTERN struct nk_rect
+nk_draw_merge_intersect(struct nk_rect a, struct nk_rect b)
+{
+    float x0 = NK_MAX(a.x, b.x), y0 = NK_MAX(a.y, b.y);
+    float x1 = NK_MIN(a.x + a.w, b.x + b.w), y1 = NK_MIN(a.y + a.h, b.y + b.h);
+    if (x1 <= x0 || y1 <= y0) return nk_rect(0,0,0,0);
+    return nk_rect(x0, y0, x1 - x0, y1 - y0);
+}
+/* Backends round clip rects to whole pixels. Integral clip rects are assumed to
+ * end up exactly on pixel edges, others may lose up to two pixels on either side
+ * so only what lies further inside is known to be kept. */
+NK_INTERN struct nk_rect
+nk_draw_merge_kept(struct nk_rect clip)
+{
+    if (clip.x == (float)(int)clip.x && clip.y == (float)(int)clip.y &&
+        clip.w == (float)(int)clip.w && clip.h == (float)(int)clip.h)
+        return clip;
+    return nk_rect(clip.x + 2, clip.y + 2, clip.w - 4, clip.h - 4);
+}
+NK_INTERN unsigned int
+nk_draw_merge_reach(struct nk_draw_merge_command *c, const nk_draw_index *src)
+{
+    if (!c->reach) {
+        nk_draw_index top = 0;
+        unsigned int i;
+        for (i = 0; i < c->cmd.elem_count; ++i)
+            top = NK_MAX(top, src[c->element + i]);
+        c->reach = (unsigned int)top + 1;
+    }
+    return c->reach;
+}
+NK_INTERN int
+nk_draw_merge_fits(const struct nk_draw_list *list, struct nk_draw_merge_group *g,
+    struct nk_draw_merge_command *cmds, struct nk_draw_merge_command *c,
+    const nk_draw_index *src)
+{
+    const struct nk_draw_command *a = &cmds[g->first].cmd, *b = &c->cmd;
+    if (a->texture.id != b->texture.id || a->quads != b->quads || a->instances != b->instances)
+        return nk_false;
+#ifdef NK_INCLUDE_COMMAND_USERDATA
+    if (a->userdata.id != b->userdata.id) return nk_false;
+#endif
+    /* vertices */
+    if (b->instances) {
+        if (b->vertex_offset != g->end) return nk_false;
+    } else if (b->quads) {
+        if (b->vertex_offset != g->end ||
+            (g->elem_count + b->elem_count) / 6 > (unsigned int)list->config.quad_batch)
+            return nk_false;
+    } else if (sizeof(nk_draw_index) == 2 && (b->vertex_offset != g->begin || g->top != g->begin)) {
+        /* elements of commands sharing a vertex offset always stay addressable,
+         * otherwise the elements have to be looked at */
+        unsigned int begin, end;
+        int k;
+        if (!g->exact) {
+            for (k = g->first; k >= 0; k = cmds[k].next)
+                g->end = NK_MAX(g->end, cmds[k].cmd.vertex_offset + nk_draw_merge_reach(&cmds[k], src));
+            g->exact = nk_true;
+        }
+        begin = NK_MIN(g->begin, b->vertex_offset);
+        end = NK_MAX(g->end, b->vertex_offset + nk_draw_merge_reach(c, src));
+        if (end - begin > NK_USHORT_MAX + 1) return nk_false;
+    }
+    /* scissor */
+    if (g->clipped && c->clipped)
+        return g->scissor.x == b->clip_rect.x && g->scissor.y == b->clip_rect.y &&
+            g->scissor.w == b->clip_rect.w && g->scissor.h == b->clip_rect.h;
+    if (g->clipped)
+        return nk_draw_merge_inside(b->bounds, nk_draw_merge_kept(g->scissor));
+    if (c->clipped)
+        return nk_draw_merge_inside(g->scissor, nk_draw_merge_kept(b->clip_rect));
+    return nk_true;
+}
+NK_INTERN void
+nk_draw_merge_join(const struct nk_draw_list *list, struct nk_draw_merge_group *g,
+    struct nk_draw_merge_command *cmds, int index, const nk_draw_index *src)
+{
+    struct nk_draw_merge_command *c = &cmds[index];
+    const struct nk_draw_command *first = &cmds[g->first].cmd;
+    if (c->clipped && !g->clipped) {
+        g->scissor = c->cmd.clip_rect;
+        g->clipped = nk_true;
+    } else if (!g->clipped) g->scissor = nk_damage_union(g->scissor, c->cmd.bounds);
+    g->same_clip = g->same_clip &&
+        first->clip_rect.x == c->cmd.clip_rect.x && first->clip_rect.y == c->cmd.clip_rect.y &&
+        first->clip_rect.w == c->cmd.clip_rect.w && first->clip_rect.h == c->cmd.clip_rect.h;
+    g->region = nk_damage_union(g->region, c->region);
+    if (c->cmd.instances)
+        g->end += c->cmd.elem_count / 6 * (unsigned int)NK_DRAW_QUAD_INSTANCE_SLOTS(list->config.vertex_size);
+    else if (c->cmd.quads)
+        g->end += c->cmd.elem_count / 6 * 4;
+    else {
+        g->begin = NK_MIN(g->begin, c->cmd.vertex_offset);
+        g->top = NK_MAX(g->top, c->cmd.vertex_offset);
+        if (g->exact)
+            g->end = NK_MAX(g->end, c->cmd.vertex_offset + nk_draw_merge_reach(c, src));
+    }
+    g->elem_count += c->cmd.elem_count;
+    cmds[g->last].next = index;
+    g->last = index;
+}
+NK_API nk_flags
+nk_draw_merge(struct nk_draw_merge *merge, struct nk_context *ctx, struct nk_buffer *elements)
+{
+    struct nk_draw_list *list;
+    struct nk_draw_merge_command *cmds;
+    struct nk_draw_merge_group *groups;
+    struct nk_draw_command *out;
+    const struct nk_draw_command *cmd;
+    const nk_draw_index *src;
+    nk_draw_index *dst;
+    nk_size element = 0;
+    unsigned int element_count = 0;
+    int count = 0, group_count = 0, target, i, j;
+
+    NK_ASSERT(merge);
+    NK_ASSERT(ctx);
+    NK_ASSERT(elements);
+    NK_ASSERT(elements != ctx->draw_list.elements);
+    if (!merge || !ctx || !elements || elements == ctx->draw_list.elements || !ctx->draw_list.buffer)
+        return NK_CONVERT_INVALID_PARAM;
+    list = &ctx->draw_list;
+    src = (const nk_draw_index*)nk_buffer_memory_const(list->elements);
+    dst = (nk_draw_index*)nk_buffer_alloc(elements, NK_BUFFER_FRONT,
+        sizeof(nk_draw_index) * list->element_count, NK_ALIGNOF(nk_draw_index));
+    if (list->element_count && !dst) return NK_CONVERT_ELEMENT_BUFFER_FULL;
+
+    /* one allocation since growing the buffer moves its memory */
+    nk_buffer_clear(&merge->scratch);
+    cmds = (struct nk_draw_merge_command*)nk_buffer_alloc(&merge->scratch, NK_BUFFER_FRONT,
+        (sizeof(struct nk_draw_merge_command) + sizeof(struct nk_draw_merge_group)) * list->cmd_count,
+        NK_ALIGNOF(struct nk_draw_merge_command));
+    groups = cmds ? (struct nk_draw_merge_group*)(void*)(cmds + list->cmd_count) : 0;
+    merge->draws_before = merge->draws_after = 0;
+    nk_draw_list_foreach(cmd, list, list->buffer)
+        merge->draws_before += cmd->elem_count != 0;
+    if (list->cmd_count && !cmds) {
+        /* leave the commands as they are */
+        if (list->element_count)
+            NK_MEMCPY(dst, src, sizeof(nk_draw_index) * list->element_count);
+        list->elements = elements;
+        merge->draws_after = merge->draws_before;
+        return NK_CONVERT_COMMAND_BUFFER_FULL;
+    }
+
+    nk_draw_list_foreach(cmd, list, list->buffer) {
+        struct nk_draw_merge_command *c = &cmds[count];
+        struct nk_rect bounds = cmd->bounds, visible;
+        if (!cmd->elem_count) continue;
+        c->cmd = *cmd;
+        c->element = element;
+        c->reach = 0;
+        c->next = -1;
+        if (!cmd->quads && !cmd->instances)
+            element += cmd->elem_count;
+        if (bounds.w <= 0 || bounds.h <= 0) {
+            /* nothing known about the geometry */
+            bounds = cmd->clip_rect;
+            c->clipped = nk_true;
+        } else c->clipped = !nk_draw_merge_inside(bounds, nk_draw_merge_kept(cmd->clip_rect));
+        c->cmd.bounds = bounds;
+        /* scissor rects may reach a pixel past the clip rect */
+        visible = nk_rect(cmd->clip_rect.x - 1, cmd->clip_rect.y - 1,
+            cmd->clip_rect.w + 2, cmd->clip_rect.h + 2);
+        c->region = c->clipped ? nk_draw_merge_intersect(bounds, visible) : bounds;
+        if (c->region.w <= 0 || c->region.h <= 0) continue; /* clipped away completely */
+
+        /* look for an earlier group to join, the command moves in front of
+         * every group it passes so stop at the first one it overlaps */
+        target = -1;
+        for (j = group_count - 1; j >= 0 && j >= group_count - NK_DRAW_MERGE_WINDOW; --j) {
+            if (nk_draw_merge_fits(list, &groups[j], cmds, c, src)) {
+                target = j;
+                break;
             }
-            nk_draw_list_path_stroke(&ctx->draw_list, p->color, NK_STROKE_OPEN, p->line_thickness);
-        } break;
-        case NK_COMMAND_TEXT: {
-            const struct nk_command_text *t = (const struct nk_command_text*)cmd;
-            nk_draw_list_add_text(&ctx->draw_list, t->font, nk_rect(t->x, t->y, t->w, t->h),
-                t->string, t->length, t->height, t->foreground);
-        } break;
-        case NK_COMMAND_IMAGE: {
-            const struct nk_command_image *i = (const struct nk_command_image*)cmd;
-            nk_draw_list_add_image(&ctx->draw_list, i->img, nk_rect(i->x, i->y, i->w, i->h), i->col);
-        } break;
-        case NK_COMMAND_CUSTOM: {
-            const struct nk_command_custom *c = (const struct nk_command_custom*)cmd;
-            c->callback(&ctx->draw_list, c->x, c->y, c->w, c->h, c->callback_data);
-        } break;
-        default: break;
+            if (nk_draw_merge_overlap(groups[j].region, c->region)) break;
+        }
+        if (target >= 0) {
+            nk_draw_merge_join(list, &groups[target], cmds, count, src);
+        } else {
+            struct nk_draw_merge_group *g = &groups[group_count++];
+            g->first = g->last = count;
+            g->scissor = c->clipped ? cmd->clip_rect : bounds;
+            g->region = c->region;
+            g->clipped = c->clipped;
+            g->same_clip = nk_true;
+            g->elem_count = cmd->elem_count;
+            g->begin = g->top = cmd->vertex_offset;
+            g->exact = nk_true;
+            if (cmd->instances)
+                g->end = g->begin + cmd->elem_count / 6 *
+                    (unsigned int)NK_DRAW_QUAD_INSTANCE_SLOTS(list->config.vertex_size);
+            else if (cmd->quads)
+                g->end = g->begin + cmd->elem_count / 6 * 4;
+            else {
+                g->end = 0;
+                g->exact = nk_false;
+            }
+        }
+        count++;
+    }
+
+    /* write the elements group by group and the groups over the commands */
+    out = (struct nk_draw_command*)nk__draw_list_begin(list, list->buffer);
+    for (i = 0; i < group_count; ++i) {
+        const struct nk_draw_merge_group *g = &groups[i];
+        struct nk_draw_command *o = out - i;
+        *o = cmds[g->first].cmd;
+        o->elem_count = g->elem_count;
+        if (g->clipped) o->clip_rect = g->scissor;
+        else if (!g->same_clip) {
+            /* whole pixels so no backend cuts into the geometry */
+            float x0 = (float)nk_ifloorf(g->scissor.x), y0 = (float)nk_ifloorf(g->scissor.y);
+            float x1 = (float)nk_iceilf(g->scissor.x + g->scissor.w);
+            float y1 = (float)nk_iceilf(g->scissor.y + g->scissor.h);
+            o->clip_rect = nk_rect(x0, y0, x1 - x0, y1 - y0);
+        }
+        if (o->quads || o->instances) {
+            for (j = g->first; j >= 0; j = cmds[j].next)
+                o->bounds = nk_damage_union(o->bounds, cmds[j].cmd.bounds);
+            continue;
+        }
+        o->vertex_offset = g->begin;
+        for (j = g->first; j >= 0; j = cmds[j].next) {
+            const struct nk_draw_merge_command *c = &cmds[j];
+            unsigned int shift = c->cmd.vertex_offset - g->begin, k;
+            if (shift) {
+                for (k = 0; k < c->cmd.elem_count; ++k)
+                    dst[element_count + k] = (nk_draw_index)(src[c->element + k] + shift);
+            } else NK_MEMCPY(dst + element_count, src + c->element, sizeof(nk_draw_index) * c->cmd.elem_count);
+            element_count += c->cmd.elem_count;
+            o->bounds = nk_damage_union(o->bounds, c->cmd.bounds);
         }
     }
-    res |= (cmds->needed > cmds->allocated + (cmds->memory.size - cmds->size)) ? NK_CONVERT_COMMAND_BUFFER_FULL: 0;
-    res |= (vertices->needed > vertices->allocated) ? NK_CONVERT_VERTEX_BUFFER_FULL: 0;
-    res |= (elements->needed > elements->allocated) ? NK_CONVERT_ELEMENT_BUFFER_FULL: 0;
-    return res;
+    list->cmd_count = (unsigned int)group_count;
+    list->elements = elements;
+    list->element_count = element_count;
+    merge->draws_after = group_count;
+    return NK_CONVERT_SUCCESS;
 }
 NK_API const struct nk_draw_command*
 nk__draw_begin(const struct nk_context *ctx,
@@ -12247,7 +14581,10 @@ nk_tt__h_prefilter(unsigned char *pixels, int w, int h, int stride_in_bytes,
     {
         int i;
         unsigned int total;
-        NK_MEMSET(buffer, 0, (nk_size)kernel_width);
+        /* the whole buffer: only the first kernel_width bytes are read before
+         * being written, but a constant size keeps -O2 from warning about
+         * kernel_width overflowing it */
+        NK_MEMSET(buffer, 0, sizeof(buffer));
 
         total = 0;
 
@@ -12310,7 +14647,7 @@ nk_tt__v_prefilter(unsigned char *pixels, int w, int h, int stride_in_bytes,
     {
         int i;
         unsigned int total;
-        NK_MEMSET(buffer, 0, (nk_size)kernel_width);
+        NK_MEMSET(buffer, 0, sizeof(buffer)); /* see nk_tt__h_prefilter */
 
         total = 0;
 
@@ -12404,87 +14741,85 @@ nk_tt_PackFontRangesGatherRects(struct nk_tt_pack_context *spc,
     }
     return k;
 }
+/* renders character j of a range into its packed rect, only reads the pack context so
+ * characters with disjoint rects can be rendered concurrently */
+NK_INTERN int
+nk_tt_PackFontRangeRenderChar(const struct nk_tt_pack_context *spc,
+    const struct nk_tt_fontinfo *info, struct nk_tt_pack_range *range, int j,
+    struct nk_rp_rect *r, struct nk_allocator *alloc)
+{
+    float fh = range->font_size;
+    float scale = fh > 0 ? nk_tt_ScaleForPixelHeight(info, fh):
+        nk_tt_ScaleForMappingEmToPixels(info, -fh);
+    unsigned int h_oversample = range->h_oversample;
+    unsigned int v_oversample = range->v_oversample;
+    float recip_h = 1.0f / (float)h_oversample;
+    float recip_v = 1.0f / (float)v_oversample;
+    float sub_x = nk_tt__oversample_shift((int)h_oversample);
+    float sub_y = nk_tt__oversample_shift((int)v_oversample);
+
+    struct nk_tt_packedchar *bc = &range->chardata_for_range[j];
+    int advance, lsb, x0,y0,x1,y1;
+    int codepoint = range->first_unicode_codepoint_in_range ?
+        range->first_unicode_codepoint_in_range + j :
+        range->array_of_unicode_codepoints[j];
+    int glyph;
+    nk_rp_coord pad = (nk_rp_coord) spc->padding;
+
+    if (!r->was_packed)
+        return 0;
+    glyph = nk_tt_FindGlyphIndex(info, codepoint);
+
+    /* pad on left and top */
+    r->x = (nk_rp_coord)((int)r->x + (int)pad);
+    r->y = (nk_rp_coord)((int)r->y + (int)pad);
+    r->w = (nk_rp_coord)((int)r->w - (int)pad);
+    r->h = (nk_rp_coord)((int)r->h - (int)pad);
+
+    nk_tt_GetGlyphHMetrics(info, glyph, &advance, &lsb);
+    nk_tt_GetGlyphBitmapBox(info, glyph, scale * (float)h_oversample,
+            (scale * (float)v_oversample), &x0,&y0,&x1,&y1);
+    nk_tt_MakeGlyphBitmapSubpixel(info, spc->pixels + r->x + r->y*spc->stride_in_bytes,
+        (int)(r->w - h_oversample+1), (int)(r->h - v_oversample+1),
+        spc->stride_in_bytes, scale * (float)h_oversample,
+        scale * (float)v_oversample, 0,0, glyph, alloc);
+
+    if (h_oversample > 1)
+       nk_tt__h_prefilter(spc->pixels + r->x + r->y*spc->stride_in_bytes,
+            r->w, r->h, spc->stride_in_bytes, (int)h_oversample);
+
+    if (v_oversample > 1)
+       nk_tt__v_prefilter(spc->pixels + r->x + r->y*spc->stride_in_bytes,
+            r->w, r->h, spc->stride_in_bytes, (int)v_oversample);
+
+    bc->x0       = (nk_ushort)  r->x;
+    bc->y0       = (nk_ushort)  r->y;
+    bc->x1       = (nk_ushort) (r->x + r->w);
+    bc->y1       = (nk_ushort) (r->y + r->h);
+    bc->xadvance = scale * (float)advance;
+    bc->xoff     = (float)  x0 * recip_h + sub_x;
+    bc->yoff     = (float)  y0 * recip_v + sub_y;
+    bc->xoff2    = ((float)x0 + r->w) * recip_h + sub_x;
+    bc->yoff2    = ((float)y0 + r->h) * recip_v + sub_y;
+    return 1;
+}
 NK_INTERN int
 nk_tt_PackFontRangesRenderIntoRects(struct nk_tt_pack_context *spc,
     struct nk_tt_fontinfo *info, struct nk_tt_pack_range *ranges,
     int num_ranges, struct nk_rp_rect *rects, struct nk_allocator *alloc)
 {
     int i,j,k, return_value = 1;
-    /* save current values */
-    int old_h_over = (int)spc->h_oversample;
-    int old_v_over = (int)spc->v_oversample;
     /* rects array must be big enough to accommodate all characters in the given ranges */
 
     k = 0;
-    for (i=0; i < num_ranges; ++i)
-    {
-        float fh = ranges[i].font_size;
-        float recip_h,recip_v,sub_x,sub_y;
-        float scale = fh > 0 ? nk_tt_ScaleForPixelHeight(info, fh):
-            nk_tt_ScaleForMappingEmToPixels(info, -fh);
-
-        spc->h_oversample = ranges[i].h_oversample;
-        spc->v_oversample = ranges[i].v_oversample;
-
-        recip_h = 1.0f / (float)spc->h_oversample;
-        recip_v = 1.0f / (float)spc->v_oversample;
-
-        sub_x = nk_tt__oversample_shift((int)spc->h_oversample);
-        sub_y = nk_tt__oversample_shift((int)spc->v_oversample);
-
-        for (j=0; j < ranges[i].num_chars; ++j)
-        {
-            struct nk_rp_rect *r = &rects[k];
-            if (r->was_packed)
-            {
-                struct nk_tt_packedchar *bc = &ranges[i].chardata_for_range[j];
-                int advance, lsb, x0,y0,x1,y1;
-                int codepoint = ranges[i].first_unicode_codepoint_in_range ?
-                    ranges[i].first_unicode_codepoint_in_range + j :
-                    ranges[i].array_of_unicode_codepoints[j];
-                int glyph = nk_tt_FindGlyphIndex(info, codepoint);
-                nk_rp_coord pad = (nk_rp_coord) spc->padding;
-
-                /* pad on left and top */
-                r->x = (nk_rp_coord)((int)r->x + (int)pad);
-                r->y = (nk_rp_coord)((int)r->y + (int)pad);
-                r->w = (nk_rp_coord)((int)r->w - (int)pad);
-                r->h = (nk_rp_coord)((int)r->h - (int)pad);
-
-                nk_tt_GetGlyphHMetrics(info, glyph, &advance, &lsb);
-                nk_tt_GetGlyphBitmapBox(info, glyph, scale * (float)spc->h_oversample,
-                        (scale * (float)spc->v_oversample), &x0,&y0,&x1,&y1);
-                nk_tt_MakeGlyphBitmapSubpixel(info, spc->pixels + r->x + r->y*spc->stride_in_bytes,
-                    (int)(r->w - spc->h_oversample+1), (int)(r->h - spc->v_oversample+1),
-                    spc->stride_in_bytes, scale * (float)spc->h_oversample,
-                    scale * (float)spc->v_oversample, 0,0, glyph, alloc);
-
-                if (spc->h_oversample > 1)
-                   nk_tt__h_prefilter(spc->pixels + r->x + r->y*spc->stride_in_bytes,
-                        r->w, r->h, spc->stride_in_bytes, (int)spc->h_oversample);
-
-                if (spc->v_oversample > 1)
-                   nk_tt__v_prefilter(spc->pixels + r->x + r->y*spc->stride_in_bytes,
-                        r->w, r->h, spc->stride_in_bytes, (int)spc->v_oversample);
-
-                bc->x0       = (nk_ushort)  r->x;
-                bc->y0       = (nk_ushort)  r->y;
-                bc->x1       = (nk_ushort) (r->x + r->w);
-                bc->y1       = (nk_ushort) (r->y + r->h);
-                bc->xadvance = scale * (float)advance;
-                bc->xoff     = (float)  x0 * recip_h + sub_x;
-                bc->yoff     = (float)  y0 * recip_v + sub_y;
-                bc->xoff2    = ((float)x0 + r->w) * recip_h + sub_x;
-                bc->yoff2    = ((float)y0 + r->h) * recip_v + sub_y;
-            } else {
-                return_value = 0; /* if any fail, report failure */
-            }
+    for (i=0; i < num_ranges; ++i) {
+        for (j=0; j < ranges[i].num_chars; ++j) {
+            /* if any fail, report failure */
+            if (!nk_tt_PackFontRangeRenderChar(spc, info, &ranges[i], j, &rects[k], alloc))
+                return_value = 0;
             ++k;
         }
     }
-    /* restore original values */
-    spc->h_oversample = (unsigned int)old_h_over;
-    spc->v_oversample = (unsigned int)old_v_over;
     return return_value;
 }
 NK_INTERN void
@@ -12772,9 +15107,79 @@ nk_font_bake_pack(struct nk_font_baker *baker,
     return nk_true;
 }
 NK_INTERN void
+nk_font_bake_glyph(struct nk_font_glyph *glyph, struct nk_tt_packedchar *pc,
+    nk_rune codepoint, const struct nk_font_config *cfg, float ascent, int width, int height)
+{
+    float dummy_x = 0, dummy_y = 0;
+    struct nk_tt_aligned_quad q;
+
+    /* query glyph bounds from stb_truetype */
+    nk_tt_GetPackedQuad(pc, (int)width, (int)height, 0, &dummy_x, &dummy_y, &q, 0);
+
+    /* fill own glyph type with data */
+    glyph->codepoint = codepoint;
+    glyph->x0 = q.x0; glyph->y0 = q.y0;
+    glyph->x1 = q.x1; glyph->y1 = q.y1;
+    glyph->y0 += (ascent + 0.5f);
+    glyph->y1 += (ascent + 0.5f);
+    glyph->w = glyph->x1 - glyph->x0 + 0.5f;
+    glyph->h = glyph->y1 - glyph->y0;
+
+    if (cfg->coord_type == NK_COORD_PIXEL) {
+        glyph->u0 = q.s0 * (float)width;
+        glyph->v0 = q.t0 * (float)height;
+        glyph->u1 = q.s1 * (float)width;
+        glyph->v1 = q.t1 * (float)height;
+    } else {
+        glyph->u0 = q.s0;
+        glyph->v0 = q.t0;
+        glyph->u1 = q.s1;
+        glyph->v1 = q.t1;
+    }
+    glyph->xadvance = (pc->xadvance + cfg->spacing.x);
+    if (cfg->pixel_snap)
+        glyph->xadvance = (float)(int)(glyph->xadvance + 0.5f);
+}
+#define NK_FONT_BAKE_JOB_GLYPHS 64
+struct nk_font_bake_jobs {
+    struct nk_font_baker *baker;
+    int build_count;
+    int glyph_count;
+};
+NK_INTERN void
+nk_font_bake_job_render(void *data, int index, int worker)
+{
+    struct nk_font_bake_jobs *jobs = (struct nk_font_bake_jobs*)data;
+    struct nk_font_baker *baker = jobs->baker;
+    int begin = index * NK_FONT_BAKE_JOB_GLYPHS;
+    int end = NK_MIN(begin + NK_FONT_BAKE_JOB_GLYPHS, jobs->glyph_count);
+    int b = 0, r = 0, j = 0, k;
+    NK_UNUSED(worker);
+
+    /* rects are stored in build and range order, find the character at `begin` */
+    while (b+1 < jobs->build_count && baker->build[b+1].rects - baker->rects <= begin)
+        b++;
+    k = (int)(baker->build[b].rects - baker->rects);
+    while (r < (int)baker->build[b].range_count &&
+        k + baker->build[b].ranges[r].num_chars <= begin)
+        k += baker->build[b].ranges[r++].num_chars;
+    j = begin - k;
+    for (k = begin; k < end; ++k) {
+        struct nk_font_bake_data *tmp = &baker->build[b];
+        while (r >= (int)tmp->range_count || j >= tmp->ranges[r].num_chars) {
+            if (r < (int)tmp->range_count) {r++; j = 0; continue;}
+            tmp = &baker->build[++b]; r = 0; j = 0;
+        }
+        nk_tt_PackFontRangeRenderChar(&baker->spc, &tmp->info, &tmp->ranges[r], j,
+            &baker->rects[k], &baker->alloc);
+        j++;
+    }
+}
+NK_INTERN void
 nk_font_bake(struct nk_font_baker *baker, void *image_memory, int width, int height,
     struct nk_font_glyph *glyphs, int glyphs_count,
-    const struct nk_font_config *config_list, int font_count)
+    const struct nk_font_config *config_list, int font_count,
+    nk_font_bake_dispatch dispatch, nk_handle scheduler)
 {
     int input_i = 0;
     nk_rune glyph_n = 0;
@@ -12796,7 +15201,15 @@ nk_font_bake(struct nk_font_baker *baker, void *image_memory, int width, int hei
     nk_zero(image_memory, (nk_size)((nk_size)width * (nk_size)height));
     baker->spc.pixels = (unsigned char*)image_memory;
     baker->spc.height = (int)height;
-    for (input_i = 0, config_iter = config_list; input_i < font_count && config_iter;
+    if (dispatch) {
+        /* packed rects are disjoint so glyphs can be rendered in any order */
+        struct nk_font_bake_jobs jobs;
+        jobs.baker = baker;
+        jobs.build_count = font_count;
+        jobs.glyph_count = glyphs_count;
+        dispatch(scheduler, (glyphs_count + NK_FONT_BAKE_JOB_GLYPHS-1) / NK_FONT_BAKE_JOB_GLYPHS,
+            nk_font_bake_job_render, &jobs);
+    } else for (input_i = 0, config_iter = config_list; input_i < font_count && config_iter;
         config_iter = config_iter->next) {
         it = config_iter;
         do {const struct nk_font_config *cfg = it;
@@ -12837,42 +15250,11 @@ nk_font_bake(struct nk_font_baker *baker, void *image_memory, int width, int hei
                 struct nk_tt_pack_range *range = &tmp->ranges[i];
                 for (char_idx = 0; char_idx < range->num_chars; char_idx++)
                 {
-                    nk_rune codepoint = 0;
-                    float dummy_x = 0, dummy_y = 0;
-                    struct nk_tt_aligned_quad q;
-                    struct nk_font_glyph *glyph;
-
-                    /* query glyph bounds from stb_truetype */
-                    const struct nk_tt_packedchar *pc = &range->chardata_for_range[char_idx];
+                    struct nk_tt_packedchar *pc = &range->chardata_for_range[char_idx];
                     if (!pc->x0 && !pc->x1 && !pc->y0 && !pc->y1) continue;
-                    codepoint = (nk_rune)(range->first_unicode_codepoint_in_range + char_idx);
-                    nk_tt_GetPackedQuad(range->chardata_for_range, (int)width,
-                        (int)height, char_idx, &dummy_x, &dummy_y, &q, 0);
-
-                    /* fill own glyph type with data */
-                    glyph = &glyphs[dst_font->glyph_offset + dst_font->glyph_count + (unsigned int)glyph_count];
-                    glyph->codepoint = codepoint;
-                    glyph->x0 = q.x0; glyph->y0 = q.y0;
-                    glyph->x1 = q.x1; glyph->y1 = q.y1;
-                    glyph->y0 += (dst_font->ascent + 0.5f);
-                    glyph->y1 += (dst_font->ascent + 0.5f);
-                    glyph->w = glyph->x1 - glyph->x0 + 0.5f;
-                    glyph->h = glyph->y1 - glyph->y0;
-
-                    if (cfg->coord_type == NK_COORD_PIXEL) {
-                        glyph->u0 = q.s0 * (float)width;
-                        glyph->v0 = q.t0 * (float)height;
-                        glyph->u1 = q.s1 * (float)width;
-                        glyph->v1 = q.t1 * (float)height;
-                    } else {
-                        glyph->u0 = q.s0;
-                        glyph->v0 = q.t0;
-                        glyph->u1 = q.s1;
-                        glyph->v1 = q.t1;
-                    }
-                    glyph->xadvance = (pc->xadvance + cfg->spacing.x);
-                    if (cfg->pixel_snap)
-                        glyph->xadvance = (float)(int)(glyph->xadvance + 0.5f);
+                    nk_font_bake_glyph(&glyphs[dst_font->glyph_offset + dst_font->glyph_count + (unsigned int)glyph_count],
+                        pc, (nk_rune)(range->first_unicode_codepoint_in_range + char_idx),
+                        cfg, dst_font->ascent, width, height);
                     glyph_count++;
                 }
             }
@@ -12928,6 +15310,82 @@ nk_font_bake_convert(void *out_memory, int img_width, int img_height,
     for (n = (int)(img_width * img_height); n > 0; n--)
         *dst++ = ((nk_rune)(*src++) << 24) | 0x00FFFFFF;
 }
+/* state of an atlas baked by nk_font_atlas_bake_dynamic */
+struct nk_font_atlas_dynamic {
+    struct nk_tt_pack_context spc; /* packs glyphs into the free space left */
+    struct nk_allocator temporary;
+    struct nk_tt_fontinfo *info; /* one per font config, in atlas order */
+    const struct nk_font_config **configs;
+    int config_count;
+    struct nk_font_glyph *glyphs;
+    nk_byte *ready; /* per glyph: 0 not rasterized yet, 1 in the atlas, 2 did not fit */
+    nk_byte *alpha; /* rasterized glyphs, the atlas image itself unless it is RGBA32 */
+    nk_rune *rgba;
+    int width, height;
+    struct nk_recti dirty; /* changed since the last nk_font_atlas_dirty, empty if w is 0 */
+};
+NK_INTERN void
+nk_font_dynamic_load(struct nk_font *font, const struct nk_font_glyph *glyph)
+{
+    struct nk_font_atlas_dynamic *dyn = font->dynamic;
+    struct nk_font_glyph *dst = (struct nk_font_glyph*)glyph;
+    nk_byte *ready = &dyn->ready[glyph - dyn->glyphs];
+    const struct nk_font_config *cfg = font->config;
+    struct nk_tt_pack_range range;
+    struct nk_tt_packedchar pc;
+    struct nk_rp_rect rect;
+    int i, x, y;
+
+    if (*ready) return;
+    /* the first range holding the codepoint decides which font config it came from */
+    do {const nk_rune *r;
+        for (r = cfg->range; r[0] && r[1]; r += 2)
+            if (glyph->codepoint >= r[0] && glyph->codepoint <= r[1]) break;
+        if (r[0] && r[1]) break;
+    } while ((cfg = cfg->n) != font->config);
+    for (i = 0; i < dyn->config_count && dyn->configs[i] != cfg; ++i);
+    if (i == dyn->config_count) return;
+
+    nk_zero(&range, sizeof(range));
+    nk_zero(&rect, sizeof(rect));
+    nk_zero(&pc, sizeof(pc));
+    range.font_size = cfg->size;
+    range.first_unicode_codepoint_in_range = (int)glyph->codepoint;
+    range.num_chars = 1;
+    range.chardata_for_range = &pc;
+    nk_tt_PackSetOversampling(&dyn->spc, cfg->oversample_h, cfg->oversample_v);
+    nk_tt_PackFontRangesGatherRects(&dyn->spc, &dyn->info[i], &range, 1, &rect);
+    nk_rp_pack_rects((struct nk_rp_context*)dyn->spc.pack_info, &rect, 1);
+    if (!rect.was_packed) {
+        /* atlas is full: keep the advance but draw nothing */
+        dst->x1 = dst->x0; dst->y1 = dst->y0;
+        dst->w = dst->h = 0;
+        dst->u0 = dst->u1 = dst->v0 = dst->v1 = 0;
+        *ready = 2;
+        return;
+    }
+    nk_tt_PackFontRangesRenderIntoRects(&dyn->spc, &dyn->info[i], &range, 1, &rect, &dyn->temporary);
+    nk_font_bake_glyph(dst, &pc, glyph->codepoint, cfg, cfg->font->ascent, dyn->width, dyn->height);
+    if (dyn->rgba) {
+        for (y = rect.y; y < rect.y + rect.h; ++y)
+            for (x = rect.x; x < rect.x + rect.w; ++x)
+                dyn->rgba[y * dyn->width + x] = ((nk_rune)dyn->alpha[y * dyn->width + x] << 24) | 0x00FFFFFF;
+    }
+    if (!dyn->dirty.w) {
+        dyn->dirty.x = (short)rect.x;
+        dyn->dirty.y = (short)rect.y;
+        dyn->dirty.w = (short)rect.w;
+        dyn->dirty.h = (short)rect.h;
+    } else {
+        int x1 = NK_MAX(dyn->dirty.x + dyn->dirty.w, rect.x + rect.w);
+        int y1 = NK_MAX(dyn->dirty.y + dyn->dirty.h, rect.y + rect.h);
+        dyn->dirty.x = (short)NK_MIN(dyn->dirty.x, rect.x);
+        dyn->dirty.y = (short)NK_MIN(dyn->dirty.y, rect.y);
+        dyn->dirty.w = (short)(x1 - dyn->dirty.x);
+        dyn->dirty.h = (short)(y1 - dyn->dirty.y);
+    }
+    *ready = 1;
+}
 
 /* -------------------------------------------------------------
  *
@@ -12986,6 +15444,7 @@ nk_font_query_font_glyph(nk_handle handle, float height,
 
     scale = height/font->info.height;
     g = nk_font_find_glyph(font, codepoint);
+    if (font->dynamic) nk_font_dynamic_load(font, g);
     glyph->width = (g->x1 - g->x0) * scale;
     glyph->height = (g->y1 - g->y0) * scale;
     glyph->offset = nk_vec2(g->x0 * scale, g->y0 * scale);
@@ -13008,6 +15467,14 @@ nk_font_find_glyph(struct nk_font *font, nk_rune unicode)
     NK_ASSERT(font->info.ranges);
     if (!font || !font->glyphs) return 0;
 
+    if (font->lookup) {
+        nk_uint page, index;
+        if (unicode >= font->lookup_end) return font->fallback;
+        page = font->lookup[unicode >> 8];
+        if (!page) return font->fallback;
+        index = font->lookup[page + (unicode & 0xFF)];
+        return (index) ? &font->glyphs[index - 1] : font->fallback;
+    }
     glyph = font->fallback;
     iter = font->config;
     do {count = nk_range_count(iter->range);
@@ -13023,6 +15490,71 @@ nk_font_find_glyph(struct nk_font *font, nk_rune unicode)
     return glyph;
 }
 NK_INTERN void
+nk_font_build_lookup(struct nk_font *font, struct nk_allocator *permanent,
+    struct nk_allocator *temporary)
+{
+    int i, count, pages = 1;
+    nk_uint total_glyphs = 0, top, offset, *used, *lookup;
+    nk_rune last = 0;
+    const struct nk_font_config *iter;
+
+    /* the highest codepoint decides how many pages the first level needs */
+    iter = font->config;
+    do {count = nk_range_count(iter->range);
+        for (i = 0; i < count; ++i)
+            last = NK_MAX(last, iter->range[(i*2)+1]);
+    } while ((iter = iter->n) != font->config);
+    if (last > 0x10FFFF) return;
+    top = (last >> 8) + 1;
+
+    /* collect the pages that glyphs fall into */
+    used = (nk_uint*)temporary->alloc(temporary->userdata, 0, sizeof(nk_uint) * top);
+    if (!used) return;
+    nk_zero(used, sizeof(nk_uint) * top);
+    used[0] = 1;
+    iter = font->config;
+    do {count = nk_range_count(iter->range);
+        for (i = 0; i < count; ++i) {
+            nk_rune p = iter->range[(i*2)+0] >> 8;
+            for (; p <= (iter->range[(i*2)+1] >> 8); ++p) {
+                pages += !used[p];
+                used[p] = 1;
+            }
+        }
+    } while ((iter = iter->n) != font->config);
+
+    lookup = (nk_uint*)permanent->alloc(permanent->userdata, 0,
+        sizeof(nk_uint) * (top + (nk_size)pages * 256));
+    if (!lookup) {
+        temporary->free(temporary->userdata, used);
+        return;
+    }
+    nk_zero(lookup, sizeof(nk_uint) * (top + (nk_size)pages * 256));
+    for (offset = top, i = 0; i < (int)top; ++i) {
+        if (!used[i]) continue;
+        lookup[i] = offset;
+        offset += 256;
+    }
+    temporary->free(temporary->userdata, used);
+
+    /* same walk as the linear search so overlapping ranges keep resolving to the first one */
+    iter = font->config;
+    do {count = nk_range_count(iter->range);
+        for (i = 0; i < count; ++i) {
+            nk_rune f = iter->range[(i*2)+0];
+            nk_rune t = iter->range[(i*2)+1];
+            nk_rune r;
+            for (r = f; r <= t; ++r) {
+                nk_uint *entry = &lookup[lookup[r >> 8] + (r & 0xFF)];
+                if (!*entry) *entry = total_glyphs + (r - f) + 1;
+            }
+            total_glyphs += (t - f) + 1;
+        }
+    } while ((iter = iter->n) != font->config);
+    font->lookup = lookup;
+    font->lookup_end = top << 8;
+}
+NK_INTERN void
 nk_font_init(struct nk_font *font, float pixel_height,
     nk_rune fallback_codepoint, struct nk_font_glyph *glyphs,
     const struct nk_baked_font *baked_font, nk_handle atlas)
@@ -13639,11 +16171,36 @@ nk_font_atlas_add_default(struct nk_font_atlas *atlas,
         nk_proggy_clean_ttf_compressed_data_base85, pixel_height, config);
 }
 #endif
+NK_INTERN void
+nk_font_atlas_init_cursors(struct nk_font_atlas *atlas, int width, int height)
+{
+    NK_STORAGE const struct nk_vec2 nk_cursor_data[NK_CURSOR_COUNT][3] = {
+        /* Pos      Size        Offset */
+        {{ 0, 3},   {12,19},    { 0, 0}},
+        {{13, 0},   { 7,16},    { 4, 8}},
+        {{31, 0},   {23,23},    {11,11}},
+        {{21, 0},   { 9, 23},   { 5,11}},
+        {{55,18},   {23, 9},    {11, 5}},
+        {{73, 0},   {17,17},    { 9, 9}},
+        {{55, 0},   {17,17},    { 9, 9}}
+    };
+    int i;
+    for (i = 0; i < NK_CURSOR_COUNT; ++i) {
+        struct nk_cursor *cursor = &atlas->cursors[i];
+        cursor->img.w = (unsigned short)width;
+        cursor->img.h = (unsigned short)height;
+        cursor->img.region[0] = (unsigned short)(atlas->custom.x + nk_cursor_data[i][0].x);
+        cursor->img.region[1] = (unsigned short)(atlas->custom.y + nk_cursor_data[i][0].y);
+        cursor->img.region[2] = (unsigned short)nk_cursor_data[i][1].x;
+        cursor->img.region[3] = (unsigned short)nk_cursor_data[i][1].y;
+        cursor->size = nk_cursor_data[i][1];
+        cursor->offset = nk_cursor_data[i][2];
+    }
+}
 NK_API const void*
 nk_font_atlas_bake(struct nk_font_atlas *atlas, int *width, int *height,
     enum nk_font_atlas_format fmt)
 {
-    int i = 0;
     void *tmp = 0;
     nk_size tmp_size, img_size;
     struct nk_font *font_iter;
@@ -13699,7 +16256,8 @@ nk_font_atlas_bake(struct nk_font_atlas *atlas, int *width, int *height,
 
     /* bake glyphs and custom white pixel into image */
     nk_font_bake(baker, atlas->pixel, *width, *height,
-        atlas->glyphs, atlas->glyph_count, atlas->config, atlas->font_num);
+        atlas->glyphs, atlas->glyph_count, atlas->config, atlas->font_num,
+        atlas->dispatch, atlas->scheduler);
     nk_font_bake_custom_data(atlas->pixel, *width, *height, atlas->custom,
             nk_custom_cursor_data, NK_CURSOR_DATA_W, NK_CURSOR_DATA_H, '.', 'X');
 
@@ -13722,30 +16280,10 @@ nk_font_atlas_bake(struct nk_font_atlas *atlas, int *width, int *height,
         struct nk_font_config *config = font->config;
         nk_font_init(font, config->size, config->fallback_glyph, atlas->glyphs,
             config->font, nk_handle_ptr(0));
+        nk_font_build_lookup(font, &atlas->permanent, &atlas->temporary);
     }
 
-    /* initialize each cursor */
-    {NK_STORAGE const struct nk_vec2 nk_cursor_data[NK_CURSOR_COUNT][3] = {
-        /* Pos      Size        Offset */
-        {{ 0, 3},   {12,19},    { 0, 0}},
-        {{13, 0},   { 7,16},    { 4, 8}},
-        {{31, 0},   {23,23},    {11,11}},
-        {{21, 0},   { 9, 23},   { 5,11}},
-        {{55,18},   {23, 9},    {11, 5}},
-        {{73, 0},   {17,17},    { 9, 9}},
-        {{55, 0},   {17,17},    { 9, 9}}
-    };
-    for (i = 0; i < NK_CURSOR_COUNT; ++i) {
-        struct nk_cursor *cursor = &atlas->cursors[i];
-        cursor->img.w = (unsigned short)*width;
-        cursor->img.h = (unsigned short)*height;
-        cursor->img.region[0] = (unsigned short)(atlas->custom.x + nk_cursor_data[i][0].x);
-        cursor->img.region[1] = (unsigned short)(atlas->custom.y + nk_cursor_data[i][0].y);
-        cursor->img.region[2] = (unsigned short)nk_cursor_data[i][1].x;
-        cursor->img.region[3] = (unsigned short)nk_cursor_data[i][1].y;
-        cursor->size = nk_cursor_data[i][1];
-        cursor->offset = nk_cursor_data[i][2];
-    }}
+    nk_font_atlas_init_cursors(atlas, *width, *height);
     /* free temporary memory */
     atlas->temporary.free(atlas->temporary.userdata, tmp);
     return atlas->pixel;
@@ -13763,6 +16301,372 @@ failed:
     }
     return 0;
 }
+/* baked atlas cache: header, one entry per font, glyphs and image, all 4 byte aligned */
+#define NK_FONT_ATLAS_CACHE_MAGIC 0x4146454Eu /* "NEFA" */
+#define NK_FONT_ATLAS_CACHE_VERSION 1
+struct nk_font_atlas_cache_header {
+    nk_uint magic;
+    nk_uint version;
+    nk_hash key;
+    nk_uint glyph_size;
+    int width, height;
+    struct nk_recti custom;
+    int glyph_count;
+    int font_count;
+};
+struct nk_font_atlas_cache_font {
+    float height, ascent, descent;
+    nk_rune glyph_offset;
+    nk_rune glyph_count;
+};
+NK_INTERN nk_hash
+nk_font_atlas_cache_key(const struct nk_font_atlas *atlas, enum nk_font_atlas_format fmt)
+{
+    const struct nk_font_config *config_iter, *it;
+    nk_hash h = nk_murmur_hash(&fmt, (int)sizeof(fmt), NK_FONT_ATLAS_CACHE_VERSION);
+    h = nk_murmur_hash(&atlas->font_num, (int)sizeof(atlas->font_num), h);
+    for (config_iter = atlas->config; config_iter; config_iter = config_iter->next) {
+        it = config_iter;
+        do {const nk_rune *r = it->range;
+            int coord_type = (int)it->coord_type;
+            h = nk_murmur_hash(it->ttf_blob, (int)it->ttf_size, h);
+            h = nk_murmur_hash(&it->merge_mode, 1, h);
+            h = nk_murmur_hash(&it->pixel_snap, 1, h);
+            h = nk_murmur_hash(&it->oversample_v, 1, h);
+            h = nk_murmur_hash(&it->oversample_h, 1, h);
+            h = nk_murmur_hash(&it->size, (int)sizeof(it->size), h);
+            h = nk_murmur_hash(&coord_type, (int)sizeof(coord_type), h);
+            h = nk_murmur_hash(&it->spacing, (int)sizeof(it->spacing), h);
+            h = nk_murmur_hash(&it->fallback_glyph, (int)sizeof(it->fallback_glyph), h);
+            while (r && *r) r++;
+            if (it->range)
+                h = nk_murmur_hash(it->range, (int)((nk_size)(r - it->range) * sizeof(nk_rune)), h);
+        } while ((it = it->n) != config_iter);
+    }
+    return h;
+}
+NK_INTERN nk_size
+nk_font_atlas_cache_size(int width, int height, int glyph_count, int font_count,
+    enum nk_font_atlas_format fmt)
+{
+    return sizeof(struct nk_font_atlas_cache_header) +
+        sizeof(struct nk_font_atlas_cache_font) * (nk_size)font_count +
+        sizeof(struct nk_font_glyph) * (nk_size)glyph_count +
+        (nk_size)width * (nk_size)height * (fmt == NK_FONT_ATLAS_RGBA32 ? 4u: 1u);
+}
+NK_API nk_size
+nk_font_atlas_save(struct nk_font_atlas *atlas, enum nk_font_atlas_format fmt,
+    void *memory, nk_size size)
+{
+    struct nk_font_atlas_cache_header header;
+    struct nk_font_atlas_cache_font *dst_font;
+    struct nk_font *font_iter;
+    nk_size needed, glyphs_size;
+    nk_byte *dst;
+
+    NK_ASSERT(atlas);
+    if (!atlas || !atlas->pixel || !atlas->glyphs || atlas->dynamic)
+        return 0;
+
+    nk_zero_struct(header);
+    header.magic = NK_FONT_ATLAS_CACHE_MAGIC;
+    header.version = NK_FONT_ATLAS_CACHE_VERSION;
+    header.key = nk_font_atlas_cache_key(atlas, fmt);
+    header.glyph_size = (nk_uint)sizeof(struct nk_font_glyph);
+    header.width = atlas->tex_width;
+    header.height = atlas->tex_height;
+    header.custom = atlas->custom;
+    header.glyph_count = atlas->glyph_count;
+    for (font_iter = atlas->fonts; font_iter; font_iter = font_iter->next)
+        header.font_count++;
+
+    needed = nk_font_atlas_cache_size(header.width, header.height,
+        header.glyph_count, header.font_count, fmt);
+    if (!memory || size < needed)
+        return needed;
+
+    dst = (nk_byte*)memory;
+    NK_MEMCPY(dst, &header, sizeof(header));
+    dst_font = (struct nk_font_atlas_cache_font*)(void*)(dst + sizeof(header));
+    for (font_iter = atlas->fonts; font_iter; font_iter = font_iter->next, ++dst_font) {
+        dst_font->height = font_iter->info.height;
+        dst_font->ascent = font_iter->info.ascent;
+        dst_font->descent = font_iter->info.descent;
+        dst_font->glyph_offset = font_iter->info.glyph_offset;
+        dst_font->glyph_count = font_iter->info.glyph_count;
+    }
+    dst = (nk_byte*)dst_font;
+    glyphs_size = sizeof(struct nk_font_glyph) * (nk_size)atlas->glyph_count;
+    NK_MEMCPY(dst, atlas->glyphs, glyphs_size);
+    NK_MEMCPY(dst + glyphs_size, atlas->pixel, (nk_size)atlas->tex_width *
+        (nk_size)atlas->tex_height * (fmt == NK_FONT_ATLAS_RGBA32 ? 4u: 1u));
+    return needed;
+}
+NK_API const void*
+nk_font_atlas_load(struct nk_font_atlas *atlas, const void *memory, nk_size size,
+    int *width, int *height, enum nk_font_atlas_format fmt)
+{
+    struct nk_font_atlas_cache_header header;
+    const struct nk_font_atlas_cache_font *src_font;
+    struct nk_font *font_iter;
+    nk_size glyphs_size;
+    const nk_byte *src;
+    int font_count = 0;
+
+    NK_ASSERT(atlas);
+    NK_ASSERT(atlas->permanent.alloc);
+    NK_ASSERT(atlas->permanent.free);
+    NK_ASSERT(width);
+    NK_ASSERT(height);
+    if (!atlas || !width || !height || !memory || size < sizeof(header) ||
+        !atlas->permanent.alloc || !atlas->permanent.free || atlas->glyphs)
+        return 0;
+
+#ifdef NK_INCLUDE_DEFAULT_FONT
+    /* same fonts as nk_font_atlas_bake would add */
+    if (!atlas->font_num)
+        atlas->default_font = nk_font_atlas_add_default(atlas, 13.0f, 0);
+#endif
+    if (!atlas->font_num) return 0;
+    for (font_iter = atlas->fonts; font_iter; font_iter = font_iter->next)
+        font_count++;
+
+    /* reject files of other versions, fonts, configurations or sizes */
+    NK_MEMCPY(&header, memory, sizeof(header));
+    if (header.magic != NK_FONT_ATLAS_CACHE_MAGIC ||
+        header.version != NK_FONT_ATLAS_CACHE_VERSION ||
+        header.glyph_size != sizeof(struct nk_font_glyph) ||
+        header.font_count != font_count ||
+        header.width <= 0 || header.height <= 0 || header.glyph_count <= 0 ||
+        header.key != nk_font_atlas_cache_key(atlas, fmt) ||
+        size < nk_font_atlas_cache_size(header.width, header.height,
+            header.glyph_count, header.font_count, fmt))
+        return 0;
+    src_font = (const struct nk_font_atlas_cache_font*)
+        (const void*)((const nk_byte*)memory + sizeof(header));
+    for (font_count = 0; font_count < header.font_count; ++font_count) {
+        if (src_font[font_count].glyph_offset > (nk_rune)header.glyph_count ||
+            src_font[font_count].glyph_count > (nk_rune)header.glyph_count -
+                src_font[font_count].glyph_offset)
+            return 0;
+    }
+
+    glyphs_size = sizeof(struct nk_font_glyph) * (nk_size)header.glyph_count;
+    atlas->glyphs = (struct nk_font_glyph*)atlas->permanent.alloc(
+        atlas->permanent.userdata,0, glyphs_size);
+    NK_ASSERT(atlas->glyphs);
+    if (!atlas->glyphs) return 0;
+    src = (const nk_byte*)(src_font + header.font_count);
+    NK_MEMCPY(atlas->glyphs, src, glyphs_size);
+    atlas->glyph_count = header.glyph_count;
+    atlas->custom = header.custom;
+    atlas->tex_width = *width = header.width;
+    atlas->tex_height = *height = header.height;
+
+    /* initialize each font from the stored metrics */
+    for (font_iter = atlas->fonts; font_iter; font_iter = font_iter->next, ++src_font) {
+        struct nk_font *font = font_iter;
+        struct nk_font_config *config = font->config;
+        struct nk_baked_font *baked = config->font;
+        baked->ranges = config->range;
+        baked->height = src_font->height;
+        baked->ascent = src_font->ascent;
+        baked->descent = src_font->descent;
+        baked->glyph_offset = src_font->glyph_offset;
+        baked->glyph_count = src_font->glyph_count;
+        nk_font_init(font, config->size, config->fallback_glyph, atlas->glyphs,
+            baked, nk_handle_ptr(0));
+        nk_font_build_lookup(font, &atlas->permanent, &atlas->temporary);
+    }
+    nk_font_atlas_init_cursors(atlas, *width, *height);
+    return src + glyphs_size;
+}
+NK_API const void*
+nk_font_atlas_bake_dynamic(struct nk_font_atlas *atlas, int width, int height,
+    enum nk_font_atlas_format fmt)
+{
+    struct nk_font_atlas_dynamic *dyn;
+    struct nk_font_config *config_iter, *it;
+    struct nk_font *font_iter;
+    nk_size size, pixels;
+    nk_rune glyph_n = 0;
+    int configs = 0, glyph_count = 0, i;
+    struct nk_rp_rect custom_space;
+
+    NK_ASSERT(atlas);
+    NK_ASSERT(atlas->temporary.alloc);
+    NK_ASSERT(atlas->temporary.free);
+    NK_ASSERT(atlas->permanent.alloc);
+    NK_ASSERT(atlas->permanent.free);
+    NK_ASSERT(width > 0 && height > 0);
+    if (!atlas || width <= 0 || height <= 0 ||
+        !atlas->temporary.alloc || !atlas->temporary.free ||
+        !atlas->permanent.alloc || !atlas->permanent.free)
+        return 0;
+
+#ifdef NK_INCLUDE_DEFAULT_FONT
+    /* no font added so just use default font */
+    if (!atlas->font_num)
+        atlas->default_font = nk_font_atlas_add_default(atlas, 13.0f, 0);
+#endif
+    NK_ASSERT(atlas->font_num);
+    if (!atlas->font_num) return 0;
+
+    /* one permanent block: state, font infos, config table, glyph flags and the alpha image */
+    nk_font_baker_memory(&size, &glyph_count, atlas->config, atlas->font_num);
+    for (config_iter = atlas->config; config_iter; config_iter = config_iter->next) {
+        it = config_iter;
+        do ++configs; while ((it = it->n) != config_iter);
+    }
+    pixels = (nk_size)width * (nk_size)height;
+    size = sizeof(struct nk_font_atlas_dynamic) + NK_ALIGNOF(struct nk_tt_fontinfo);
+    size += sizeof(struct nk_tt_fontinfo) * (nk_size)configs;
+    size += sizeof(struct nk_font_config*) * (nk_size)configs;
+    size += (nk_size)glyph_count + pixels;
+    dyn = (struct nk_font_atlas_dynamic*)atlas->permanent.alloc(atlas->permanent.userdata, 0, size);
+    NK_ASSERT(dyn);
+    if (!dyn) return 0;
+    nk_zero(dyn, size);
+    dyn->info = (struct nk_tt_fontinfo*)NK_ALIGN_PTR(dyn + 1, NK_ALIGNOF(struct nk_tt_fontinfo));
+    dyn->configs = (const struct nk_font_config**)(void*)(dyn->info + configs);
+    dyn->ready = (nk_byte*)(void*)(dyn->configs + configs);
+    dyn->alpha = dyn->ready + glyph_count;
+    dyn->config_count = configs;
+    dyn->temporary = atlas->temporary;
+    dyn->width = width;
+    dyn->height = height;
+
+    atlas->glyph_count = glyph_count;
+    atlas->glyphs = (struct nk_font_glyph*)atlas->permanent.alloc(
+        atlas->permanent.userdata,0, sizeof(struct nk_font_glyph)*(nk_size)glyph_count);
+    if (fmt == NK_FONT_ATLAS_RGBA32)
+        dyn->rgba = (nk_rune*)atlas->permanent.alloc(atlas->permanent.userdata, 0, pixels * 4);
+    if (!atlas->glyphs || (fmt == NK_FONT_ATLAS_RGBA32 && !dyn->rgba) ||
+        !nk_tt_PackBegin(&dyn->spc, dyn->alpha, width, height, 0, 1, &atlas->permanent))
+        goto failed;
+    nk_zero(atlas->glyphs, sizeof(struct nk_font_glyph)*(nk_size)glyph_count);
+    dyn->glyphs = atlas->glyphs;
+
+    /* cursors and the white pixel go into the upper left corner */
+    nk_zero(&custom_space, sizeof(custom_space));
+    custom_space.w = (nk_rp_coord)((NK_CURSOR_DATA_W*2)+1);
+    custom_space.h = (nk_rp_coord)(NK_CURSOR_DATA_H + 1);
+    nk_rp_pack_rects((struct nk_rp_context*)dyn->spc.pack_info, &custom_space, 1);
+    if (!custom_space.was_packed) goto failed;
+    atlas->custom.x = (short)custom_space.x;
+    atlas->custom.y = (short)custom_space.y;
+    atlas->custom.w = (short)custom_space.w;
+    atlas->custom.h = (short)custom_space.h;
+    nk_font_bake_custom_data(dyn->alpha, width, height, atlas->custom,
+            nk_custom_cursor_data, NK_CURSOR_DATA_W, NK_CURSOR_DATA_H, '.', 'X');
+
+    /* fill baked fonts and glyph advances, everything else waits until a glyph is drawn */
+    i = 0;
+    for (config_iter = atlas->config; config_iter; config_iter = config_iter->next) {
+        it = config_iter;
+        do {const struct nk_font_config *cfg = it;
+            struct nk_tt_fontinfo *info = &dyn->info[i];
+            struct nk_baked_font *dst_font = cfg->font;
+            const nk_rune *range;
+            float font_scale;
+            int unscaled_ascent, unscaled_descent, unscaled_line_gap;
+
+            dyn->configs[i++] = cfg;
+            if (!nk_tt_InitFont(info, (const unsigned char*)cfg->ttf_blob, 0))
+                goto failed;
+            font_scale = nk_tt_ScaleForPixelHeight(info, cfg->size);
+            nk_tt_GetFontVMetrics(info, &unscaled_ascent, &unscaled_descent, &unscaled_line_gap);
+            if (!cfg->merge_mode) {
+                dst_font->ranges = cfg->range;
+                dst_font->height = cfg->size;
+                dst_font->ascent = ((float)unscaled_ascent * font_scale);
+                dst_font->descent = ((float)unscaled_descent * font_scale);
+                dst_font->glyph_offset = glyph_n;
+            }
+            for (range = cfg->range; range[0] && range[1]; range += 2) {
+                nk_rune codepoint;
+                for (codepoint = range[0]; codepoint <= range[1]; ++codepoint) {
+                    struct nk_font_glyph *glyph = &atlas->glyphs[dst_font->glyph_offset + dst_font->glyph_count++];
+                    int advance, lsb;
+                    nk_tt_GetGlyphHMetrics(info, nk_tt_FindGlyphIndex(info, (int)codepoint), &advance, &lsb);
+                    glyph->codepoint = codepoint;
+                    glyph->xadvance = font_scale * (float)advance + cfg->spacing.x;
+                    if (cfg->pixel_snap)
+                        glyph->xadvance = (float)(int)(glyph->xadvance + 0.5f);
+                    glyph_n++;
+                }
+            }
+        } while ((it = it->n) != config_iter);
+    }
+    if (dyn->rgba)
+        nk_font_bake_convert(dyn->rgba, width, height, dyn->alpha);
+    atlas->dynamic = dyn;
+    atlas->pixel = (dyn->rgba) ? (void*)dyn->rgba : (void*)dyn->alpha;
+    atlas->tex_width = width;
+    atlas->tex_height = height;
+
+    for (font_iter = atlas->fonts; font_iter; font_iter = font_iter->next) {
+        struct nk_font *font = font_iter;
+        struct nk_font_config *config = font->config;
+        nk_font_init(font, config->size, config->fallback_glyph, atlas->glyphs,
+            config->font, nk_handle_ptr(0));
+        nk_font_build_lookup(font, &atlas->permanent, &atlas->temporary);
+        font->dynamic = dyn;
+    }
+    nk_font_atlas_init_cursors(atlas, width, height);
+    return atlas->pixel;
+
+failed:
+    if (dyn->spc.pack_info)
+        nk_tt_PackEnd(&dyn->spc, &atlas->permanent);
+    if (dyn->rgba)
+        atlas->permanent.free(atlas->permanent.userdata, dyn->rgba);
+    if (atlas->glyphs) {
+        atlas->permanent.free(atlas->permanent.userdata, atlas->glyphs);
+        atlas->glyphs = 0;
+    }
+    atlas->permanent.free(atlas->permanent.userdata, dyn);
+    return 0;
+}
+NK_API void
+nk_font_atlas_prepare(struct nk_font_atlas *atlas, struct nk_context *ctx)
+{
+    const struct nk_command *cmd;
+    NK_ASSERT(atlas);
+    NK_ASSERT(ctx);
+    if (!atlas || !ctx || !atlas->dynamic) return;
+    nk_foreach(cmd, ctx) {
+        const struct nk_command_text *t;
+        const struct nk_user_font *handle;
+        struct nk_font *font;
+        nk_rune unicode;
+        int len = 0, glyph_len;
+
+        if (cmd->type != NK_COMMAND_TEXT) continue;
+        t = (const struct nk_command_text*)cmd;
+        handle = t->font;
+        while (handle->width == nk_cached_font_text_width)
+            handle = ((const struct nk_cached_font*)handle->userdata.ptr)->font;
+        for (font = atlas->fonts; font && &font->handle != handle; font = font->next);
+        if (!font) continue;
+        while (len < t->length && (glyph_len = nk_utf_decode(t->string + len, &unicode, t->length - len))) {
+            if (unicode == NK_UTF_INVALID) break;
+            nk_font_dynamic_load(font, nk_font_find_glyph(font, unicode));
+            len += glyph_len;
+        }
+    }
+}
+NK_API int
+nk_font_atlas_dirty(struct nk_font_atlas *atlas, struct nk_recti *rect)
+{
+    NK_ASSERT(atlas);
+    NK_ASSERT(rect);
+    if (!atlas || !rect || !atlas->dynamic || !atlas->dynamic->dirty.w)
+        return nk_false;
+    *rect = atlas->dynamic->dirty;
+    nk_zero_struct(atlas->dynamic->dirty);
+    return nk_true;
+}
 NK_API void
 nk_font_atlas_end(struct nk_font_atlas *atlas, nk_handle texture,
     struct nk_draw_null_texture *null)
@@ -13789,7 +16693,10 @@ nk_font_atlas_end(struct nk_font_atlas *atlas, nk_handle texture,
     for (i = 0; i < NK_CURSOR_COUNT; ++i)
         atlas->cursors[i].img.handle = texture;
 
-    atlas->temporary.free(atlas->temporary.userdata, atlas->pixel);
+    /* a dynamic atlas keeps its image to rasterize glyphs into */
+    if (atlas->dynamic) return;
+    if (atlas->pixel)
+        atlas->temporary.free(atlas->temporary.userdata, atlas->pixel);
     atlas->pixel = 0;
     atlas->tex_width = 0;
     atlas->tex_height = 0;
@@ -13807,6 +16714,8 @@ nk_font_atlas_cleanup(struct nk_font_atlas *atlas)
     NK_ASSERT(atlas->permanent.alloc);
     NK_ASSERT(atlas->permanent.free);
     if (!atlas || !atlas->permanent.alloc || !atlas->permanent.free) return;
+    /* glyphs of a dynamic atlas are still rasterized from the blobs */
+    if (atlas->dynamic) return;
     if (atlas->config) {
         struct nk_font_config *iter;
         for (iter = atlas->config; iter; iter = iter->next) {
@@ -13851,12 +16760,20 @@ nk_font_atlas_clear(struct nk_font_atlas *atlas)
         struct nk_font *iter, *next;
         for (iter = atlas->fonts; iter; iter = next) {
             next = iter->next;
+            if (iter->lookup)
+                atlas->permanent.free(atlas->permanent.userdata, iter->lookup);
             atlas->permanent.free(atlas->permanent.userdata, iter);
         }
         atlas->fonts = 0;
     }
     if (atlas->glyphs)
         atlas->permanent.free(atlas->permanent.userdata, atlas->glyphs);
+    if (atlas->dynamic) {
+        nk_tt_PackEnd(&atlas->dynamic->spc, &atlas->permanent);
+        if (atlas->dynamic->rgba)
+            atlas->permanent.free(atlas->permanent.userdata, atlas->dynamic->rgba);
+        atlas->permanent.free(atlas->permanent.userdata, atlas->dynamic);
+    }
     nk_zero_struct(*atlas);
 }
 #endif
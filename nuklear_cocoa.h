@@ -15,6 +15,10 @@
 
 #include "apple_cocoa.h"
 
+#ifdef NK_COCOA_SOFTWARE
+#include "nuklear_raster.h"
+#endif
+
 enum nk_cocoa_init_state
 {
   NK_COCOA_DEFAULT,
@@ -26,8 +30,41 @@ NK_API void nk_cocoa_shutdown(void);
 NK_API void nk_cocoa_font_stash_begin(struct nk_font_atlas **atlas);
 NK_API void nk_cocoa_font_stash_end(void);
 NK_API void nk_cocoa_new_frame(void);
+/* max_vertex_buffer and max_element_buffer are the initial sizes in bytes of the vertex and
+ * element buffers. A frame that does not fit grows them geometrically and is converted again,
+ * they never shrink below the largest frame so far. */
 NK_API void nk_cocoa_render(enum nk_anti_aliasing, int max_vertex_buffer, int max_element_buffer);
 
+/* Call once the UI of a frame is complete. Returns nk_false when the command queue and the
+ * framebuffer size are identical to the last frame passed to nk_cocoa_render: the frame is then
+ * dropped and counted as elided, skip nk_cocoa_render and COCOA_SwapBuffers for it. */
+NK_API int nk_cocoa_frame_changed(void);
+struct nk_cocoa_frame_stats
+{
+  unsigned int rendered;
+  unsigned int elided;
+  nk_size redrawn_pixels; /* framebuffer pixels drawn by all rendered frames */
+  nk_size vertex_buffer;  /* current size of the vertex buffer in bytes */
+  nk_size element_buffer; /* current size of the element buffer in bytes */
+  nk_size vertex_peak;    /* most vertex buffer bytes a single frame needed */
+  nk_size element_peak;   /* most element buffer bytes a single frame needed */
+  unsigned int reconverted; /* frames converted twice because the buffers had to grow */
+  double stall_time;      /* seconds spent waiting for vertex and element buffer memory */
+  int stream_regions;     /* frame regions of the streamed GL buffers, 0 while orphaning them */
+  unsigned long gl_calls;         /* state changing GL calls made */
+  unsigned long gl_calls_skipped; /* state changing GL calls dropped since the state was set */
+  unsigned long draw_commands;    /* draw commands converted, before merging */
+  unsigned long draw_calls;       /* draw commands left to draw after merging */
+  unsigned long commands[NK_COMMAND_TYPE_COUNT];         /* commands seen by nk_optimize_commands, by type */
+  unsigned long commands_removed[NK_COMMAND_TYPE_COUNT]; /* of those dropped by nk_optimize_commands */
+  unsigned long commands_occluded[NK_COMMAND_TYPE_COUNT]; /* of those dropped being covered by a window */
+  nk_uint text_width_hits;   /* text widths answered by the NK_COCOA_TEXT_WIDTH_CACHE cache */
+  nk_uint text_width_misses; /* text widths the font had to measure */
+};
+NK_API struct nk_cocoa_frame_stats nk_cocoa_get_frame_stats(void);
+/* prints the frame stats gathered so far to stdout */
+NK_API void nk_cocoa_print_frame_stats(void);
+
 NK_API void nk_cocoa_device_destroy(void);
 NK_API void nk_cocoa_device_create(void);
 
@@ -35,6 +72,51 @@ NK_API void nk_cocoa_char_callback(COCOAwindow *win, unsigned int codepoint);
 NK_API void nk_cocoa_scroll_callback(COCOAwindow *win, double xoff, double yoff);
 NK_API void nk_cocoa_mouse_button_callback(COCOAwindow *win, int button, int action, int mods);
 
+#ifdef NK_COCOA_SOFTWARE
+/* NK_COCOA_SOFTWARE renders on the CPU into an RGBA8 buffer instead of the current GL context,
+ * using NK_COCOA_RASTER_THREADS threads (0 = one per core). With NK_COCOA_RASTER_DIRECT the
+ * command queue is rasterized directly instead of going through nk_convert. The buffer is kept
+ * between frames and only the area damaged since the last frame is drawn again. */
+NK_API const void *nk_cocoa_framebuffer(int *width, int *height);
+#endif
+
+/* NK_COCOA_PARTIAL_REDRAW makes the OpenGL renderer keep the UI in an offscreen framebuffer
+ * and redraw only the area damaged since the last frame, scissored to it, before copying it to
+ * the bound framebuffer. Whatever was drawn there before nk_cocoa_render is overwritten, the
+ * background comes from nk_cocoa_set_clear_color. */
+#if defined(NK_COCOA_SOFTWARE) || defined(NK_COCOA_PARTIAL_REDRAW)
+#define NK_COCOA_RETAINED
+NK_API void nk_cocoa_set_clear_color(struct nk_colorf color);
+#endif
+
+#ifndef NK_COCOA_SOFTWARE
+/* State changing GL calls of nk_cocoa_render (capabilities, blending, viewport, scissor, program,
+ * vertex array, buffer and texture bindings) go through a cache that drops calls setting what is
+ * already set. The cache starts over every frame since the application owns the GL state in
+ * between. The calls are made through these functions, nk_cocoa_set_gl_functions replaces them,
+ * for example with stubs recording them, 0 goes back to GL. */
+struct nk_cocoa_gl_functions
+{
+  void (*Enable)(GLenum cap);
+  void (*Disable)(GLenum cap);
+  void (*BlendEquation)(GLenum mode);
+  void (*BlendFunc)(GLenum sfactor, GLenum dfactor);
+  void (*ActiveTexture)(GLenum texture);
+  void (*BindTexture)(GLenum target, GLuint texture);
+  void (*Viewport)(GLint x, GLint y, GLsizei width, GLsizei height);
+  void (*Scissor)(GLint x, GLint y, GLsizei width, GLsizei height);
+  void (*UseProgram)(GLuint program);
+  void (*BindVertexArray)(GLuint array);
+  void (*BindBuffer)(GLenum target, GLuint buffer);
+};
+NK_API void nk_cocoa_set_gl_functions(const struct nk_cocoa_gl_functions *gl);
+#endif
+
+/* Vertices are generated window by window with nk_convert_windows, windows that did not change
+ * since the last frame reuse their previous output. Defining NK_COCOA_CONVERT_THREADS (0 = one
+ * per core) converts them on worker threads, the software renderer shares its raster threads.
+ * Fonts are baked on the same threads. */
+
 #endif
 /*
  * ==============================================================
@@ -54,12 +136,104 @@ NK_API void nk_cocoa_mouse_button_callback(COCOAwindow *win, int button, int act
 #ifndef NK_COCOA_DOUBLE_CLICK_HI
 #define NK_COCOA_DOUBLE_CLICK_HI 0.2
 #endif
+/* frame regions of the streamed OpenGL buffers, each mapped unsynchronized and guarded by a
+ * fence. 1, or a driver that cannot map unsynchronized, orphans the buffers every frame */
+#ifndef NK_COCOA_STREAM_REGIONS
+#define NK_COCOA_STREAM_REGIONS 3
+#endif
+/* quads covered by the static element buffer that runs of quads (text, images) are drawn with,
+ * 16384 is the most 16 bit indices can address */
+#ifndef NK_COCOA_QUAD_BATCH
+#define NK_COCOA_QUAD_BATCH 16384
+#endif
+/* draw runs of single colored quads instanced, from one 36 byte record per quad instead of four
+ * vertices */
+#ifndef NK_COCOA_QUAD_INSTANCES
+#define NK_COCOA_QUAD_INSTANCES 1
+#endif
+/* convert elements into client memory and join draw commands across windows and clip rects
+ * with nk_draw_merge while copying them to the OpenGL buffer */
+#ifndef NK_COCOA_MERGE_COMMANDS
+#define NK_COCOA_MERGE_COMMANDS 1
+#endif
+/* both renderers pass the command queue through nk_optimize_commands before drawing it */
+#ifndef NK_COCOA_OPTIMIZE_COMMANDS
+#define NK_COCOA_OPTIMIZE_COMMANDS 1
+#endif
+/* framebuffer pixels circles, arcs and curves may be off the real shape, they use only as many
+ * of their 22 segments as that allows. 0 always uses all of them */
+#ifndef NK_COCOA_SEGMENT_ERROR
+#define NK_COCOA_SEGMENT_ERROR 0.25f
+#endif
+/* entries of a nk_text_width_cache in front of the font set by nk_cocoa_font_stash_end, 0 for
+ * none. It only pays off for long or repeated text, strings shorter than
+ * NK_TEXT_WIDTH_CACHE_MIN_LEN are measured directly */
+#ifndef NK_COCOA_TEXT_WIDTH_CACHE
+#define NK_COCOA_TEXT_WIDTH_CACHE 0
+#endif
+/* texture size to bake the font atlas into with nk_font_atlas_bake_dynamic, glyphs are then
+ * rasterized when first drawn and only the changed part of the texture is uploaded. 0 bakes
+ * every glyph up front */
+#ifndef NK_COCOA_DYNAMIC_ATLAS
+#define NK_COCOA_DYNAMIC_ATLAS 0
+#endif
+/* NK_COCOA_ATLAS_CACHE, a file path, stores the baked atlas there with nk_font_atlas_save. Later
+ * runs with the same fonts map the file and load the atlas from it instead of baking. Ignored with a dynamic atlas */
+
+#include <stdio.h>
+#include <time.h>
+#if defined(NK_COCOA_ATLAS_CACHE) && !NK_COCOA_DYNAMIC_ATLAS
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
 
+#ifdef NK_COCOA_SOFTWARE
+#ifndef NK_COCOA_RASTER_THREADS
+#define NK_COCOA_RASTER_THREADS 0
+#endif
+
+#define NK_JOBS_IMPLEMENTATION
+#include "nuklear_jobs.h"
+#define NK_RASTER_IMPLEMENTATION
+#include "nuklear_raster.h"
+#elif defined(NK_COCOA_CONVERT_THREADS)
+#define NK_JOBS_IMPLEMENTATION
+#include "nuklear_jobs.h"
+#endif
+
+#ifdef NK_COCOA_SOFTWARE
+
+struct nk_cocoa_device
+{
+  struct nk_buffer cmds;
+  struct nk_draw_null_texture null;
+  struct nk_raster_texture font_tex;
+  nk_byte *font_pixels;
+  struct nk_raster_target target;
+  struct nk_raster_tiler tiler;
+  struct nk_job_pool *pool;
+  struct nk_color clear_color;
+  void *vertices;
+  void *elements;
+  nk_size vertices_size;
+  nk_size elements_size;
+  struct nk_convert_state convert;
+  struct nk_damage damage;
+};
+#else
 struct nk_cocoa_device
 {
   struct nk_buffer cmds;
   struct nk_draw_null_texture null;
   GLuint vbo, vao, ebo;
+  GLuint quad_ebo; /* elements of NK_COCOA_QUAD_BATCH quads, shared by all runs of quads */
+  nk_size vbo_size, ebo_size; /* bytes of one frame region */
+  nk_size stream_vbo_size, stream_ebo_size;
+  GLsync fences[NK_COCOA_STREAM_REGIONS];
+  int stream_region;
+  int streaming;
   GLuint prog;
   GLuint vert_shdr;
   GLuint frag_shdr;
@@ -68,7 +242,44 @@ struct nk_cocoa_device
   GLint attrib_col;
   GLint uniform_tex;
   GLint uniform_proj;
+  /* program and vertex array expanding nk_draw_quad_instance records */
+  GLuint inst_prog, inst_vao;
+  GLuint inst_vert_shdr;
+  GLint attrib_rect;
+  GLint attrib_uv_rect;
+  GLint attrib_inst_col;
+  GLint inst_uniform_tex;
+  GLint inst_uniform_proj;
   GLuint font_tex;
+  struct nk_cocoa_gl_functions gl;
+  struct nk_cocoa_gl_state
+  {
+    /* ~0 for unknown, the element buffer binding belongs to the bound vertex array */
+    GLuint enabled[4]; /* blend, cull face, depth test, scissor test */
+    GLenum blend_equation, blend_src, blend_dst;
+    GLenum active_texture;
+    GLuint texture;
+    GLint viewport[4];
+    GLint scissor[4];
+    GLuint program;
+    GLuint vertex_array;
+    GLuint array_buffer;
+    GLuint element_buffer;
+  } gl_state;
+#ifdef NK_COCOA_CONVERT_THREADS
+  struct nk_job_pool *pool;
+#endif
+  struct nk_convert_state convert;
+#if NK_COCOA_MERGE_COMMANDS
+  struct nk_draw_merge merge;
+  struct nk_buffer converted_elements; /* elements before nk_draw_merge */
+#endif
+#ifdef NK_COCOA_PARTIAL_REDRAW
+  GLuint fbo, color_rb;
+  int fbo_width, fbo_height;
+  struct nk_colorf clear_color;
+  struct nk_damage damage;
+#endif
 };
 
 struct nk_cocoa_vertex
@@ -77,6 +288,7 @@ struct nk_cocoa_vertex
   float uv[2];
   nk_byte col[4];
 };
+#endif
 
 static struct nk_cocoa
 {
@@ -86,6 +298,8 @@ static struct nk_cocoa
   struct nk_cocoa_device ogl;
   struct nk_context ctx;
   struct nk_font_atlas atlas;
+  struct nk_text_width_cache text_widths;
+  struct nk_cached_font cached_font;
   struct nk_vec2 fb_scale;
   unsigned int text[NK_COCOA_TEXT_MAX];
   int text_len;
@@ -93,14 +307,603 @@ static struct nk_cocoa
   double last_button_click;
   int is_double_click_down;
   struct nk_vec2 double_click_pos;
+
+  /* idle frame elision */
+  nk_hash frame_digest;
+  int frame_digest_valid;
+  nk_hash next_digest;
+  int next_digest_valid;
+  struct nk_cocoa_frame_stats frame_stats;
 } nk_cocoa;
 
+NK_INTERN nk_hash nk_cocoa_frame_digest(void)
+{
+  struct nk_context *ctx = &nk_cocoa.ctx;
+  const struct nk_command *cmd;
+  int size[4];
+  nk_hash h;
+
+  size[0] = nk_cocoa.width;
+  size[1] = nk_cocoa.height;
+  size[2] = nk_cocoa.display_width;
+  size[3] = nk_cocoa.display_height;
+  h = nk_murmur_hash(size, (int)sizeof(size), 0);
+#ifdef NK_COCOA_SOFTWARE
+  h = nk_murmur_hash(&nk_cocoa.ogl.clear_color, (int)sizeof(nk_cocoa.ogl.clear_color), h);
+#endif
+  /* in draw order and without the padding inside commands, which is left uninitialized
+   * unless NK_ZERO_COMMAND_MEMORY is defined */
+  nk_foreach(cmd, ctx)
+    h = nk_command_hash(cmd, h);
+  return h;
+}
+
+/* remembers what nk_cocoa_render draws so the next frames can be compared against it */
+NK_INTERN void nk_cocoa_frame_rendered(void)
+{
+  nk_cocoa.frame_digest = nk_cocoa.next_digest_valid ? nk_cocoa.next_digest : nk_cocoa_frame_digest();
+  nk_cocoa.frame_digest_valid = nk_true;
+  nk_cocoa.next_digest_valid = nk_false;
+  nk_cocoa.frame_stats.rendered++;
+#ifndef NK_COCOA_RETAINED
+  nk_cocoa.frame_stats.redrawn_pixels += (nk_size)nk_cocoa.display_width * (nk_size)nk_cocoa.display_height;
+#endif
+}
+
+/* drops commands not changing the frame, after the digest of the unchanged queue was taken */
+NK_INTERN void nk_cocoa_optimize(void)
+{
+#if NK_COCOA_OPTIMIZE_COMMANDS
+  struct nk_optimize_stats stats;
+  int i;
+  nk_optimize_commands(&nk_cocoa.ctx, &stats);
+  for(i = 0; i < NK_COMMAND_TYPE_COUNT; ++i)
+  {
+    nk_cocoa.frame_stats.commands[i] += (unsigned long)stats.commands[i];
+    nk_cocoa.frame_stats.commands_removed[i] += (unsigned long)stats.removed[i];
+    nk_cocoa.frame_stats.commands_occluded[i] += (unsigned long)stats.occluded[i];
+  }
+#endif
+}
+
+#ifdef NK_COCOA_RETAINED
+/* part of the window that differs from what the retained framebuffer holds */
+NK_INTERN struct nk_rect nk_cocoa_damage(void)
+{
+  struct nk_rect damage = nk_damage_update(&nk_cocoa.ogl.damage, &nk_cocoa.ctx,
+                                           nk_rect(0, 0, (float)nk_cocoa.width, (float)nk_cocoa.height));
+  nk_cocoa.frame_stats.redrawn_pixels +=
+      (nk_size)(damage.w * nk_cocoa.fb_scale.x) * (nk_size)(damage.h * nk_cocoa.fb_scale.y);
+  return damage;
+}
+#endif
+
+NK_API int nk_cocoa_frame_changed(void)
+{
+  nk_cocoa.next_digest = nk_cocoa_frame_digest();
+  nk_cocoa.next_digest_valid = nk_true;
+  if(nk_cocoa.frame_digest_valid && nk_cocoa.next_digest == nk_cocoa.frame_digest)
+  {
+    nk_cocoa.next_digest_valid = nk_false;
+    nk_cocoa.frame_stats.elided++;
+    nk_clear(&nk_cocoa.ctx);
+    return nk_false;
+  }
+  return nk_true;
+}
+
+NK_API struct nk_cocoa_frame_stats nk_cocoa_get_frame_stats(void)
+{
+  nk_cocoa.frame_stats.text_width_hits = nk_cocoa.text_widths.hits;
+  nk_cocoa.frame_stats.text_width_misses = nk_cocoa.text_widths.misses;
+  return nk_cocoa.frame_stats;
+}
+
+NK_API void nk_cocoa_print_frame_stats(void)
+{
+  struct nk_cocoa_frame_stats stats = nk_cocoa_get_frame_stats();
+  fprintf(stdout, "%u frames rendered, %u idle frames elided, %.1f Mpixels redrawn\n",
+          stats.rendered, stats.elided, (double)stats.redrawn_pixels / 1e6);
+  fprintf(stdout, "vertex buffer %lu KB (peak %lu KB), element buffer %lu KB (peak %lu KB), "
+          "%u frames converted twice\n",
+          (unsigned long)(stats.vertex_buffer / 1024), (unsigned long)(stats.vertex_peak / 1024),
+          (unsigned long)(stats.element_buffer / 1024), (unsigned long)(stats.element_peak / 1024),
+          stats.reconverted);
+#ifndef NK_COCOA_SOFTWARE
+  if(stats.rendered)
+  {
+    fprintf(stdout, "%.3f ms per frame waiting for buffer memory (%d stream regions)\n",
+            stats.stall_time * 1e3 / stats.rendered, stats.stream_regions);
+    fprintf(stdout, "%.1f GL state calls per frame, %.1f redundant ones skipped\n",
+            (double)stats.gl_calls / stats.rendered, (double)stats.gl_calls_skipped / stats.rendered);
+    fprintf(stdout, "%.1f draw calls per frame, %.1f before merging\n",
+            (double)stats.draw_calls / stats.rendered, (double)stats.draw_commands / stats.rendered);
+  }
+#endif
+  if(stats.rendered)
+  {
+    unsigned long total = 0, removed = 0, occluded = 0;
+    int i;
+    for(i = 0; i < NK_COMMAND_TYPE_COUNT; ++i)
+    {
+      total += stats.commands[i];
+      removed += stats.commands_removed[i];
+      occluded += stats.commands_occluded[i];
+    }
+    fprintf(stdout, "%.1f commands per frame, %.1f optimized away (%.1f hidden by windows)",
+            (double)total / stats.rendered, (double)removed / stats.rendered,
+            (double)occluded / stats.rendered);
+    for(i = 0; i < NK_COMMAND_TYPE_COUNT; ++i)
+      if(stats.commands_removed[i])
+        fprintf(stdout, ", %s %lu/%lu", nk_command_type_name((enum nk_command_type)i),
+                stats.commands_removed[i], stats.commands[i]);
+    fprintf(stdout, "\n");
+  }
+  if(stats.text_width_hits + stats.text_width_misses)
+    fprintf(stdout, "%u text widths cached, %u measured (%.1f%% hit rate)\n", stats.text_width_hits,
+            stats.text_width_misses,
+            100.0 * stats.text_width_hits / (stats.text_width_hits + stats.text_width_misses));
+}
+
+#ifndef NK_COCOA_SOFTWARE
+NK_INTERN double nk_cocoa_seconds(void)
+{
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (double)ts.tv_sec + (double)ts.tv_nsec * 1e-9;
+}
+#endif
+
+#if defined(NK_COCOA_SOFTWARE) || defined(NK_COCOA_CONVERT_THREADS)
+NK_INTERN void nk_cocoa_dispatch(nk_handle pool, int count, nk_convert_job job, void *data)
+{
+  nk_job_pool_run((struct nk_job_pool *)pool.ptr, count, job, data);
+}
+#endif
+
+NK_INTERN void nk_cocoa_convert_init(struct nk_cocoa_device *dev)
+{
+  nk_convert_state_init_default(&dev->convert);
+#ifdef NK_COCOA_CONVERT_THREADS
+  dev->convert.dispatch = nk_cocoa_dispatch;
+  dev->convert.scheduler = nk_handle_ptr(dev->pool);
+#endif
+}
+
+/* the direct software renderer rasterizes the command queue without converting it */
+#if !defined(NK_COCOA_SOFTWARE) || !defined(NK_COCOA_RASTER_DIRECT)
+NK_INTERN nk_flags nk_cocoa_convert(struct nk_buffer *vbuf, struct nk_buffer *ebuf,
+                                    const struct nk_convert_config *config)
+{
+  struct nk_cocoa_device *dev = &nk_cocoa.ogl;
+  nk_flags res;
+  nk_buffer_clear(&dev->cmds);
+#if !defined(NK_COCOA_SOFTWARE) && NK_COCOA_MERGE_COMMANDS
+  /* the element buffer is write only, merging reads the elements back */
+  nk_buffer_clear(&dev->converted_elements);
+  res = nk_convert_windows(&nk_cocoa.ctx, &dev->convert, &dev->cmds, vbuf,
+                           &dev->converted_elements, config);
+  if(dev->converted_elements.needed > ebuf->memory.size)
+  {
+    /* the elements of what did not fit count as well */
+    ebuf->needed = dev->converted_elements.needed;
+    res |= NK_CONVERT_ELEMENT_BUFFER_FULL;
+  }
+  else
+    res |= nk_draw_merge(&dev->merge, &nk_cocoa.ctx, ebuf);
+#else
+  res = nk_convert_windows(&nk_cocoa.ctx, &dev->convert, &dev->cmds, vbuf, ebuf, config);
+#endif
+  nk_cocoa.frame_stats.vertex_peak = NK_MAX(nk_cocoa.frame_stats.vertex_peak, vbuf->needed);
+  nk_cocoa.frame_stats.element_peak = NK_MAX(nk_cocoa.frame_stats.element_peak, ebuf->needed);
+  return res;
+}
+
+NK_INTERN nk_size nk_cocoa_buffer_grow(nk_size size, nk_size needed)
+{
+  do
+    size = size ? size * 2 : 4096;
+  while(size < needed);
+  return size;
+}
+
+/* Grows the buffer sizes to what the last conversion needed. Returns nk_false when it fit. */
+NK_INTERN int nk_cocoa_buffers_full(nk_flags res, const struct nk_buffer *vbuf,
+                                    const struct nk_buffer *ebuf, nk_size *vertex_size,
+                                    nk_size *element_size)
+{
+  if(!(res & (NK_CONVERT_VERTEX_BUFFER_FULL | NK_CONVERT_ELEMENT_BUFFER_FULL)))
+    return nk_false;
+  if(res & NK_CONVERT_VERTEX_BUFFER_FULL)
+    *vertex_size = nk_cocoa_buffer_grow(*vertex_size, vbuf->needed);
+  if(res & NK_CONVERT_ELEMENT_BUFFER_FULL)
+    *element_size = nk_cocoa_buffer_grow(*element_size, ebuf->needed);
+  nk_cocoa.frame_stats.reconverted++;
+  return nk_true;
+}
+
+/* parts of the frame did not fit even after growing the buffers, so neither elide the next
+ * frame against it nor keep it as retained content */
+NK_INTERN void nk_cocoa_frame_incomplete(void)
+{
+  nk_cocoa.frame_digest_valid = nk_false;
+#ifdef NK_COCOA_RETAINED
+  nk_damage_invalidate(&nk_cocoa.ogl.damage);
+#endif
+}
+#endif
+
+#ifdef NK_COCOA_SOFTWARE
+NK_API void nk_cocoa_device_create(void)
+{
+  struct nk_cocoa_device *dev = &nk_cocoa.ogl;
+  nk_buffer_init_default(&dev->cmds);
+  dev->pool = nk_job_pool_create(NK_COCOA_RASTER_THREADS);
+  nk_raster_tiler_init(&dev->tiler, dev->pool);
+  nk_cocoa_convert_init(dev);
+  nk_damage_init_default(&dev->damage);
+  dev->clear_color = nk_rgb(0, 0, 0);
+}
+
+NK_INTERN void nk_cocoa_device_upload_atlas(const void *image, int width, int height)
+{
+  struct nk_cocoa_device *dev = &nk_cocoa.ogl;
+  size_t size = (size_t)width * (size_t)height * 4;
+  /* stashing fonts again replaces the previous atlas */
+  free(dev->font_pixels);
+  dev->font_pixels = (nk_byte *)malloc(size);
+  memcpy(dev->font_pixels, image, size);
+  dev->font_tex.pixels = dev->font_pixels;
+  dev->font_tex.width = width;
+  dev->font_tex.height = height;
+}
+
+/* rasterizes the glyphs of this frame into a dynamic atlas and copies over what changed */
+NK_INTERN void nk_cocoa_device_update_atlas(void)
+{
+  struct nk_cocoa_device *dev = &nk_cocoa.ogl;
+  const nk_byte *image = (const nk_byte *)nk_cocoa.atlas.pixel;
+  struct nk_recti dirty;
+  int y;
+  nk_font_atlas_prepare(&nk_cocoa.atlas, &nk_cocoa.ctx);
+  if(!nk_font_atlas_dirty(&nk_cocoa.atlas, &dirty))
+    return;
+  for(y = dirty.y; y < dirty.y + dirty.h; ++y)
+  {
+    size_t offset = ((size_t)y * (size_t)dev->font_tex.width + (size_t)dirty.x) * 4;
+    memcpy(dev->font_pixels + offset, image + offset, (size_t)dirty.w * 4);
+  }
+}
+
+NK_API void nk_cocoa_device_destroy(void)
+{
+  struct nk_cocoa_device *dev = &nk_cocoa.ogl;
+  free(dev->font_pixels);
+  dev->font_pixels = 0;
+  free(dev->target.pixels);
+  free(dev->vertices);
+  free(dev->elements);
+  nk_raster_tiler_free(&dev->tiler);
+  nk_convert_state_free(&dev->convert);
+  nk_damage_free(&dev->damage);
+  nk_job_pool_destroy(dev->pool);
+  nk_buffer_free(&dev->cmds);
+}
+
+NK_API void nk_cocoa_set_clear_color(struct nk_colorf color)
+{
+  struct nk_cocoa_device *dev = &nk_cocoa.ogl;
+  struct nk_color c = nk_rgba_cf(color);
+  if(c.r != dev->clear_color.r || c.g != dev->clear_color.g || c.b != dev->clear_color.b ||
+     c.a != dev->clear_color.a)
+    nk_damage_invalidate(&dev->damage);
+  dev->clear_color = c;
+}
+
+NK_API const void *nk_cocoa_framebuffer(int *width, int *height)
+{
+  struct nk_cocoa_device *dev = &nk_cocoa.ogl;
+  if(width)
+    *width = dev->target.width;
+  if(height)
+    *height = dev->target.height;
+  return dev->target.pixels;
+}
+
+NK_API void nk_cocoa_render(enum nk_anti_aliasing AA, int max_vertex_buffer, int max_element_buffer)
+{
+  struct nk_cocoa_device *dev = &nk_cocoa.ogl;
+  struct nk_raster_target *target = &dev->target;
+  struct nk_buffer vbuf, ebuf;
+  struct nk_rect damage;
+
+  if(target->width != nk_cocoa.display_width || target->height != nk_cocoa.display_height)
+  {
+    free(target->pixels);
+    target->width = nk_cocoa.display_width;
+    target->height = nk_cocoa.display_height;
+    target->pitch = target->width * 4;
+    target->pixels = (nk_byte *)malloc((size_t)target->pitch * (size_t)target->height);
+    nk_damage_invalidate(&dev->damage);
+  }
+  nk_cocoa_frame_rendered();
+  nk_cocoa_optimize();
+  nk_cocoa_device_update_atlas();
+  damage = nk_cocoa_damage();
+  if(damage.w <= 0 || damage.h <= 0)
+  {
+    /* the framebuffer already shows this frame */
+    nk_clear(&nk_cocoa.ctx);
+    return;
+  }
+#ifdef NK_COCOA_RASTER_DIRECT
+  /* rasterize the command queue as is, no vertices are generated */
+  (void)vbuf;
+  (void)ebuf;
+  (void)max_vertex_buffer;
+  (void)max_element_buffer;
+  nk_raster_commands_tiled(&dev->tiler, target, dev->clear_color, &nk_cocoa.ctx,
+                           nk_cocoa.fb_scale, AA, &damage);
+  nk_clear(&nk_cocoa.ctx);
+#else
+  {
+    /* convert from command queue into draw list and rasterize into the framebuffer */
+    nk_size vertex_size = NK_MAX(dev->vertices_size, (nk_size)max_vertex_buffer);
+    nk_size element_size = NK_MAX(dev->elements_size, (nk_size)max_element_buffer);
+    int attempt;
+    for(attempt = 0; attempt < 2; ++attempt)
+    {
+      /* fill convert configuration */
+      struct nk_convert_config config;
+      nk_flags res;
+      static const struct nk_draw_vertex_layout_element vertex_layout[] = {
+          {NK_VERTEX_POSITION, NK_FORMAT_FLOAT, NK_OFFSETOF(struct nk_raster_vertex, position)},
+          {NK_VERTEX_TEXCOORD, NK_FORMAT_FLOAT, NK_OFFSETOF(struct nk_raster_vertex, uv)},
+          {NK_VERTEX_COLOR, NK_FORMAT_R8G8B8A8, NK_OFFSETOF(struct nk_raster_vertex, col)},
+          {NK_VERTEX_LAYOUT_END}};
+      NK_MEMSET(&config, 0, sizeof(config));
+      config.vertex_layout = vertex_layout;
+      config.vertex_size = sizeof(struct nk_raster_vertex);
+      config.vertex_alignment = NK_ALIGNOF(struct nk_raster_vertex);
+      config.null = dev->null;
+      config.circle_segment_count = 22;
+      config.curve_segment_count = 22;
+      config.arc_segment_count = 22;
+      config.segment_error = NK_COCOA_SEGMENT_ERROR;
+      config.pixel_scale = NK_MAX(nk_cocoa.fb_scale.x, nk_cocoa.fb_scale.y);
+      config.global_alpha = 1.0f;
+      config.shape_AA = AA;
+      config.line_AA = AA;
+
+      /* setup buffers to load vertices and elements */
+      if(dev->vertices_size != vertex_size)
+      {
+        free(dev->vertices);
+        dev->vertices = malloc(vertex_size);
+        dev->vertices_size = vertex_size;
+      }
+      if(dev->elements_size != element_size)
+      {
+        free(dev->elements);
+        dev->elements = malloc(element_size);
+        dev->elements_size = element_size;
+      }
+      nk_buffer_init_fixed(&vbuf, dev->vertices, vertex_size);
+      nk_buffer_init_fixed(&ebuf, dev->elements, element_size);
+      res = nk_cocoa_convert(&vbuf, &ebuf, &config);
+      if(!nk_cocoa_buffers_full(res, &vbuf, &ebuf, &vertex_size, &element_size))
+        break;
+    }
+    if(attempt == 2)
+      nk_cocoa_frame_incomplete();
+    nk_cocoa.frame_stats.vertex_buffer = dev->vertices_size;
+    nk_cocoa.frame_stats.element_buffer = dev->elements_size;
+
+    /* bin every draw command into screen tiles and rasterize the damaged ones in parallel */
+    nk_raster_draw_tiled(&dev->tiler, target, dev->clear_color, &nk_cocoa.ctx, &dev->cmds,
+                         (const struct nk_raster_vertex *)dev->vertices,
+                         (const nk_draw_index *)dev->elements, nk_cocoa.fb_scale, &damage);
+    nk_clear(&nk_cocoa.ctx);
+  }
+#endif
+}
+#else
 #ifdef __APPLE__
 #define NK_SHADER_VERSION "#version 150\n"
 #else
 #define NK_SHADER_VERSION "#version 300 es\n"
 #endif
 
+#ifdef NK_UINT_DRAW_INDEX
+#define NK_COCOA_INDEX_TYPE GL_UNSIGNED_INT
+#else
+#define NK_COCOA_INDEX_TYPE GL_UNSIGNED_SHORT
+#endif
+
+NK_API void nk_cocoa_set_gl_functions(const struct nk_cocoa_gl_functions *gl)
+{
+  struct nk_cocoa_device *dev = &nk_cocoa.ogl;
+  if(gl)
+    dev->gl = *gl;
+  else
+  {
+    dev->gl.Enable = glEnable;
+    dev->gl.Disable = glDisable;
+    dev->gl.BlendEquation = glBlendEquation;
+    dev->gl.BlendFunc = glBlendFunc;
+    dev->gl.ActiveTexture = glActiveTexture;
+    dev->gl.BindTexture = glBindTexture;
+    dev->gl.Viewport = glViewport;
+    dev->gl.Scissor = glScissor;
+    dev->gl.UseProgram = glUseProgram;
+    dev->gl.BindVertexArray = glBindVertexArray;
+    dev->gl.BindBuffer = glBindBuffer;
+  }
+  NK_MEMSET(&dev->gl_state, 0xff, sizeof(dev->gl_state));
+}
+
+/* Cached GL state changes. Each returns after counting the call as skipped when the state is
+ * already set. */
+NK_INTERN int nk_cocoa_gl_changed(int changed)
+{
+  if(changed)
+    nk_cocoa.frame_stats.gl_calls++;
+  else
+    nk_cocoa.frame_stats.gl_calls_skipped++;
+  return changed;
+}
+
+NK_INTERN void nk_cocoa_gl_enable(GLenum cap, int enable)
+{
+  struct nk_cocoa_device *dev = &nk_cocoa.ogl;
+  GLuint *state;
+  switch(cap)
+  {
+  case GL_BLEND:
+    state = &dev->gl_state.enabled[0];
+    break;
+  case GL_CULL_FACE:
+    state = &dev->gl_state.enabled[1];
+    break;
+  case GL_DEPTH_TEST:
+    state = &dev->gl_state.enabled[2];
+    break;
+  default:
+    state = &dev->gl_state.enabled[3];
+    assert(cap == GL_SCISSOR_TEST);
+    break;
+  }
+  if(!nk_cocoa_gl_changed(*state != (GLuint)enable))
+    return;
+  *state = (GLuint)enable;
+  if(enable)
+    dev->gl.Enable(cap);
+  else
+    dev->gl.Disable(cap);
+}
+
+NK_INTERN void nk_cocoa_gl_blend(GLenum equation, GLenum src, GLenum dst)
+{
+  struct nk_cocoa_device *dev = &nk_cocoa.ogl;
+  if(nk_cocoa_gl_changed(dev->gl_state.blend_equation != equation))
+  {
+    dev->gl_state.blend_equation = equation;
+    dev->gl.BlendEquation(equation);
+  }
+  if(nk_cocoa_gl_changed(dev->gl_state.blend_src != src || dev->gl_state.blend_dst != dst))
+  {
+    dev->gl_state.blend_src = src;
+    dev->gl_state.blend_dst = dst;
+    dev->gl.BlendFunc(src, dst);
+  }
+}
+
+NK_INTERN void nk_cocoa_gl_active_texture(GLenum unit)
+{
+  struct nk_cocoa_device *dev = &nk_cocoa.ogl;
+  if(!nk_cocoa_gl_changed(dev->gl_state.active_texture != unit))
+    return;
+  dev->gl_state.active_texture = unit;
+  dev->gl_state.texture = ~(GLuint)0;
+  dev->gl.ActiveTexture(unit);
+}
+
+NK_INTERN void nk_cocoa_gl_bind_texture(GLuint texture)
+{
+  struct nk_cocoa_device *dev = &nk_cocoa.ogl;
+  if(!nk_cocoa_gl_changed(dev->gl_state.texture != texture))
+    return;
+  dev->gl_state.texture = texture;
+  dev->gl.BindTexture(GL_TEXTURE_2D, texture);
+}
+
+NK_INTERN void nk_cocoa_gl_viewport(GLint x, GLint y, GLsizei width, GLsizei height)
+{
+  struct nk_cocoa_device *dev = &nk_cocoa.ogl;
+  GLint *v = dev->gl_state.viewport;
+  if(!nk_cocoa_gl_changed(v[0] != x || v[1] != y || v[2] != width || v[3] != height))
+    return;
+  v[0] = x;
+  v[1] = y;
+  v[2] = width;
+  v[3] = height;
+  dev->gl.Viewport(x, y, width, height);
+}
+
+NK_INTERN void nk_cocoa_gl_scissor(GLint x, GLint y, GLsizei width, GLsizei height)
+{
+  struct nk_cocoa_device *dev = &nk_cocoa.ogl;
+  GLint *s = dev->gl_state.scissor;
+  if(!nk_cocoa_gl_changed(s[0] != x || s[1] != y || s[2] != width || s[3] != height))
+    return;
+  s[0] = x;
+  s[1] = y;
+  s[2] = width;
+  s[3] = height;
+  dev->gl.Scissor(x, y, width, height);
+}
+
+NK_INTERN void nk_cocoa_gl_use_program(GLuint program)
+{
+  struct nk_cocoa_device *dev = &nk_cocoa.ogl;
+  if(!nk_cocoa_gl_changed(dev->gl_state.program != program))
+    return;
+  dev->gl_state.program = program;
+  dev->gl.UseProgram(program);
+}
+
+NK_INTERN void nk_cocoa_gl_bind_vertex_array(GLuint array)
+{
+  struct nk_cocoa_device *dev = &nk_cocoa.ogl;
+  if(!nk_cocoa_gl_changed(dev->gl_state.vertex_array != array))
+    return;
+  dev->gl_state.vertex_array = array;
+  dev->gl_state.element_buffer = ~(GLuint)0;
+  dev->gl.BindVertexArray(array);
+}
+
+NK_INTERN void nk_cocoa_gl_bind_buffer(GLenum target, GLuint buffer)
+{
+  struct nk_cocoa_device *dev = &nk_cocoa.ogl;
+  GLuint *state = target == GL_ARRAY_BUFFER ? &dev->gl_state.array_buffer
+                                            : &dev->gl_state.element_buffer;
+  if(!nk_cocoa_gl_changed(*state != buffer))
+    return;
+  *state = buffer;
+  dev->gl.BindBuffer(target, buffer);
+}
+
+/* points the vertex attributes of the bound vertex array at the vertices starting `offset` bytes
+ * into the vertex buffer: the frame region in use plus, for draw commands split for 16 bit
+ * indices, the start of their vertex range */
+NK_INTERN void nk_cocoa_device_bind_vertices(size_t offset)
+{
+  struct nk_cocoa_device *dev = &nk_cocoa.ogl;
+  GLsizei vs = sizeof(struct nk_cocoa_vertex);
+  size_t vp = offsetof(struct nk_cocoa_vertex, position) + offset;
+  size_t vt = offsetof(struct nk_cocoa_vertex, uv) + offset;
+  size_t vc = offsetof(struct nk_cocoa_vertex, col) + offset;
+  glVertexAttribPointer((GLuint)dev->attrib_pos, 2, GL_FLOAT, GL_FALSE, vs, (void *)vp);
+  glVertexAttribPointer((GLuint)dev->attrib_uv, 2, GL_FLOAT, GL_FALSE, vs, (void *)vt);
+  glVertexAttribPointer((GLuint)dev->attrib_col, 4, GL_UNSIGNED_BYTE, GL_TRUE, vs, (void *)vc);
+}
+
+/* points the instance attributes of the bound instance vertex array at the quad instances starting
+ * `offset` bytes into the vertex buffer */
+NK_INTERN void nk_cocoa_device_bind_instances(size_t offset)
+{
+  struct nk_cocoa_device *dev = &nk_cocoa.ogl;
+  GLsizei stride = (GLsizei)(NK_DRAW_QUAD_INSTANCE_SLOTS(sizeof(struct nk_cocoa_vertex)) *
+                             sizeof(struct nk_cocoa_vertex));
+  size_t rect = offsetof(struct nk_draw_quad_instance, a) + offset;
+  size_t uv = offsetof(struct nk_draw_quad_instance, uva) + offset;
+  size_t col = offsetof(struct nk_draw_quad_instance, col) + offset;
+  glVertexAttribPointer((GLuint)dev->attrib_rect, 4, GL_FLOAT, GL_FALSE, stride, (void *)rect);
+  glVertexAttribPointer((GLuint)dev->attrib_uv_rect, 4, GL_FLOAT, GL_FALSE, stride, (void *)uv);
+  glVertexAttribPointer((GLuint)dev->attrib_inst_col, 4, GL_UNSIGNED_BYTE, GL_TRUE, stride,
+                        (void *)col);
+}
+
 NK_API void nk_cocoa_device_create(void)
 {
   GLint status;
@@ -116,6 +919,21 @@ NK_API void nk_cocoa_device_create(void)
       "   Frag_Color = Color;\n"
       "   gl_Position = ProjMtx * vec4(Position.xy, 0, 1);\n"
       "}\n";
+  /* six vertices per instance, the corners 0-1-2 0-2-3 of the quad a-b-c-d */
+  static const GLchar *instance_shader = NK_SHADER_VERSION
+      "uniform mat4 ProjMtx;\n"
+      "in vec4 Rect;\n"
+      "in vec4 UVRect;\n"
+      "in vec4 Color;\n"
+      "out vec2 Frag_UV;\n"
+      "out vec4 Frag_Color;\n"
+      "void main() {\n"
+      "   int corner = gl_VertexID < 3 ? gl_VertexID : gl_VertexID == 3 ? 0 : gl_VertexID - 2;\n"
+      "   bvec2 far = bvec2(corner == 1 || corner == 2, corner >= 2);\n"
+      "   Frag_UV = mix(UVRect.xy, UVRect.zw, far);\n"
+      "   Frag_Color = Color;\n"
+      "   gl_Position = ProjMtx * vec4(mix(Rect.xy, Rect.zw, far), 0, 1);\n"
+      "}\n";
   static const GLchar *fragment_shader = NK_SHADER_VERSION
       "precision mediump float;\n"
       "uniform sampler2D Texture;\n"
@@ -128,6 +946,16 @@ NK_API void nk_cocoa_device_create(void)
 
   struct nk_cocoa_device *dev = &nk_cocoa.ogl;
   nk_buffer_init_default(&dev->cmds);
+#ifdef NK_COCOA_CONVERT_THREADS
+  dev->pool = nk_job_pool_create(NK_COCOA_CONVERT_THREADS);
+#endif
+  nk_cocoa_convert_init(dev);
+#if NK_COCOA_MERGE_COMMANDS
+  nk_draw_merge_init_default(&dev->merge);
+  nk_buffer_init_default(&dev->converted_elements);
+#endif
+  if(!dev->gl.Enable)
+    nk_cocoa_set_gl_functions(0);
   dev->prog = glCreateProgram();
   dev->vert_shdr = glCreateShader(GL_VERTEX_SHADER);
   dev->frag_shdr = glCreateShader(GL_FRAGMENT_SHADER);
@@ -151,13 +979,26 @@ NK_API void nk_cocoa_device_create(void)
   dev->attrib_uv = glGetAttribLocation(dev->prog, "TexCoord");
   dev->attrib_col = glGetAttribLocation(dev->prog, "Color");
 
+  dev->inst_prog = glCreateProgram();
+  dev->inst_vert_shdr = glCreateShader(GL_VERTEX_SHADER);
+  glShaderSource(dev->inst_vert_shdr, 1, &instance_shader, 0);
+  glCompileShader(dev->inst_vert_shdr);
+  glGetShaderiv(dev->inst_vert_shdr, GL_COMPILE_STATUS, &status);
+  assert(status == GL_TRUE);
+  glAttachShader(dev->inst_prog, dev->inst_vert_shdr);
+  glAttachShader(dev->inst_prog, dev->frag_shdr);
+  glLinkProgram(dev->inst_prog);
+  glGetProgramiv(dev->inst_prog, GL_LINK_STATUS, &status);
+  assert(status == GL_TRUE);
+
+  dev->inst_uniform_tex = glGetUniformLocation(dev->inst_prog, "Texture");
+  dev->inst_uniform_proj = glGetUniformLocation(dev->inst_prog, "ProjMtx");
+  dev->attrib_rect = glGetAttribLocation(dev->inst_prog, "Rect");
+  dev->attrib_uv_rect = glGetAttribLocation(dev->inst_prog, "UVRect");
+  dev->attrib_inst_col = glGetAttribLocation(dev->inst_prog, "Color");
+
   {
     /* buffer setup */
-    GLsizei vs = sizeof(struct nk_cocoa_vertex);
-    size_t vp = offsetof(struct nk_cocoa_vertex, position);
-    size_t vt = offsetof(struct nk_cocoa_vertex, uv);
-    size_t vc = offsetof(struct nk_cocoa_vertex, col);
-
     glGenBuffers(1, &dev->vbo);
     glGenBuffers(1, &dev->ebo);
     glGenVertexArrays(1, &dev->vao);
@@ -169,21 +1010,59 @@ NK_API void nk_cocoa_device_create(void)
     glEnableVertexAttribArray((GLuint)dev->attrib_pos);
     glEnableVertexAttribArray((GLuint)dev->attrib_uv);
     glEnableVertexAttribArray((GLuint)dev->attrib_col);
+    nk_cocoa_device_bind_vertices(0);
+    dev->streaming = NK_COCOA_STREAM_REGIONS > 1;
 
-    glVertexAttribPointer((GLuint)dev->attrib_pos, 2, GL_FLOAT, GL_FALSE, vs, (void *)vp);
-    glVertexAttribPointer((GLuint)dev->attrib_uv, 2, GL_FLOAT, GL_FALSE, vs, (void *)vt);
-    glVertexAttribPointer((GLuint)dev->attrib_col, 4, GL_UNSIGNED_BYTE, GL_TRUE, vs, (void *)vc);
+    glGenVertexArrays(1, &dev->inst_vao);
+    glBindVertexArray(dev->inst_vao);
+    glEnableVertexAttribArray((GLuint)dev->attrib_rect);
+    glEnableVertexAttribArray((GLuint)dev->attrib_uv_rect);
+    glEnableVertexAttribArray((GLuint)dev->attrib_inst_col);
+    glVertexAttribDivisor((GLuint)dev->attrib_rect, 1);
+    glVertexAttribDivisor((GLuint)dev->attrib_uv_rect, 1);
+    glVertexAttribDivisor((GLuint)dev->attrib_inst_col, 1);
+    nk_cocoa_device_bind_instances(0);
+    glBindVertexArray(dev->vao);
+  }
+  {
+    /* every quad is drawn as 0-1-2 0-2-3 relative to its first vertex */
+    nk_draw_index *quad = (nk_draw_index *)malloc(NK_COCOA_QUAD_BATCH * 6 * sizeof(nk_draw_index));
+    unsigned int i;
+    for(i = 0; i < NK_COCOA_QUAD_BATCH; ++i)
+    {
+      quad[i * 6 + 0] = (nk_draw_index)(i * 4 + 0);
+      quad[i * 6 + 1] = (nk_draw_index)(i * 4 + 1);
+      quad[i * 6 + 2] = (nk_draw_index)(i * 4 + 2);
+      quad[i * 6 + 3] = (nk_draw_index)(i * 4 + 0);
+      quad[i * 6 + 4] = (nk_draw_index)(i * 4 + 2);
+      quad[i * 6 + 5] = (nk_draw_index)(i * 4 + 3);
+    }
+    glGenBuffers(1, &dev->quad_ebo);
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, dev->quad_ebo);
+    glBufferData(GL_ELEMENT_ARRAY_BUFFER, NK_COCOA_QUAD_BATCH * 6 * sizeof(nk_draw_index), quad,
+                 GL_STATIC_DRAW);
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, dev->ebo);
+    free(quad);
   }
 
   glBindTexture(GL_TEXTURE_2D, 0);
   glBindBuffer(GL_ARRAY_BUFFER, 0);
   glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
   glBindVertexArray(0);
+#ifdef NK_COCOA_PARTIAL_REDRAW
+  nk_damage_init_default(&dev->damage);
+#endif
 }
 
 NK_INTERN void nk_cocoa_device_upload_atlas(const void *image, int width, int height)
 {
   struct nk_cocoa_device *dev = &nk_cocoa.ogl;
+  /* stashing fonts again replaces the previous atlas, the name may come back for the new one */
+  if(dev->font_tex)
+  {
+    glDeleteTextures(1, &dev->font_tex);
+    NK_MEMSET(&dev->gl_state.texture, 0xff, sizeof(dev->gl_state.texture));
+  }
   glGenTextures(1, &dev->font_tex);
   glBindTexture(GL_TEXTURE_2D, dev->font_tex);
   glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
@@ -192,24 +1071,191 @@ NK_INTERN void nk_cocoa_device_upload_atlas(const void *image, int width, int he
                GL_UNSIGNED_BYTE, image);
 }
 
+/* rasterizes the glyphs of this frame into a dynamic atlas and uploads what changed */
+NK_INTERN void nk_cocoa_device_update_atlas(void)
+{
+  struct nk_cocoa_device *dev = &nk_cocoa.ogl;
+  const nk_byte *image = (const nk_byte *)nk_cocoa.atlas.pixel;
+  struct nk_recti dirty;
+  nk_font_atlas_prepare(&nk_cocoa.atlas, &nk_cocoa.ctx);
+  if(!nk_font_atlas_dirty(&nk_cocoa.atlas, &dirty))
+    return;
+  nk_cocoa_gl_active_texture(GL_TEXTURE0);
+  nk_cocoa_gl_bind_texture(dev->font_tex);
+  glPixelStorei(GL_UNPACK_ROW_LENGTH, nk_cocoa.atlas.tex_width);
+  glTexSubImage2D(GL_TEXTURE_2D, 0, dirty.x, dirty.y, dirty.w, dirty.h, GL_RGBA, GL_UNSIGNED_BYTE,
+                  image + ((size_t)dirty.y * (size_t)nk_cocoa.atlas.tex_width + (size_t)dirty.x) * 4);
+  glPixelStorei(GL_UNPACK_ROW_LENGTH, 0);
+}
+
+NK_INTERN void nk_cocoa_stream_reset(void)
+{
+  struct nk_cocoa_device *dev = &nk_cocoa.ogl;
+  int i;
+  for(i = 0; i < NK_COCOA_STREAM_REGIONS; ++i)
+  {
+    if(dev->fences[i])
+      glDeleteSync(dev->fences[i]);
+    dev->fences[i] = 0;
+  }
+  dev->stream_region = 0;
+  dev->stream_vbo_size = 0;
+  dev->stream_ebo_size = 0;
+}
+
+/* Maps a frame region of the bound vertex and element buffers and returns the byte offsets it
+ * starts at. While streaming, the region's previous contents are released by waiting on the
+ * fence set after they were drawn, otherwise both buffers are orphaned. */
+NK_INTERN void nk_cocoa_map_buffers(void **vertices, void **elements, size_t *vertex_offset,
+                                    size_t *element_offset)
+{
+  struct nk_cocoa_device *dev = &nk_cocoa.ogl;
+  double start = nk_cocoa_seconds();
+  if(dev->streaming)
+  {
+    GLsync fence;
+    if(dev->stream_vbo_size != dev->vbo_size || dev->stream_ebo_size != dev->ebo_size)
+    {
+      nk_cocoa_stream_reset();
+      glBufferData(GL_ARRAY_BUFFER, (GLsizeiptr)(dev->vbo_size * NK_COCOA_STREAM_REGIONS), NULL,
+                   GL_STREAM_DRAW);
+      glBufferData(GL_ELEMENT_ARRAY_BUFFER, (GLsizeiptr)(dev->ebo_size * NK_COCOA_STREAM_REGIONS),
+                   NULL, GL_STREAM_DRAW);
+      dev->stream_vbo_size = dev->vbo_size;
+      dev->stream_ebo_size = dev->ebo_size;
+    }
+    fence = dev->fences[dev->stream_region];
+    if(fence)
+    {
+      while(glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, 1000000000) == GL_TIMEOUT_EXPIRED)
+        ;
+      glDeleteSync(fence);
+      dev->fences[dev->stream_region] = 0;
+    }
+    *vertex_offset = (size_t)dev->stream_region * dev->vbo_size;
+    *element_offset = (size_t)dev->stream_region * dev->ebo_size;
+    *vertices = glMapBufferRange(GL_ARRAY_BUFFER, (GLintptr)*vertex_offset,
+                                 (GLsizeiptr)dev->vbo_size,
+                                 GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_RANGE_BIT |
+                                     GL_MAP_UNSYNCHRONIZED_BIT);
+    *elements = glMapBufferRange(GL_ELEMENT_ARRAY_BUFFER, (GLintptr)*element_offset,
+                                 (GLsizeiptr)dev->ebo_size,
+                                 GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_RANGE_BIT |
+                                     GL_MAP_UNSYNCHRONIZED_BIT);
+    if(*vertices && *elements)
+    {
+      nk_cocoa.frame_stats.stall_time += nk_cocoa_seconds() - start;
+      nk_cocoa.frame_stats.stream_regions = NK_COCOA_STREAM_REGIONS;
+      return;
+    }
+    if(*vertices)
+      glUnmapBuffer(GL_ARRAY_BUFFER);
+    if(*elements)
+      glUnmapBuffer(GL_ELEMENT_ARRAY_BUFFER);
+    nk_cocoa_stream_reset();
+    dev->streaming = nk_false;
+  }
+
+  glBufferData(GL_ARRAY_BUFFER, (GLsizeiptr)dev->vbo_size, NULL, GL_STREAM_DRAW);
+  glBufferData(GL_ELEMENT_ARRAY_BUFFER, (GLsizeiptr)dev->ebo_size, NULL, GL_STREAM_DRAW);
+  *vertex_offset = 0;
+  *element_offset = 0;
+  *vertices = glMapBufferRange(GL_ARRAY_BUFFER, 0, (GLsizeiptr)dev->vbo_size,
+                               GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT);
+  *elements = glMapBufferRange(GL_ELEMENT_ARRAY_BUFFER, 0, (GLsizeiptr)dev->ebo_size,
+                               GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT);
+  nk_cocoa.frame_stats.stall_time += nk_cocoa_seconds() - start;
+  nk_cocoa.frame_stats.stream_regions = 0;
+}
+
+/* fences the frame region just drawn from and moves on to the next one */
+NK_INTERN void nk_cocoa_fence_buffers(void)
+{
+  struct nk_cocoa_device *dev = &nk_cocoa.ogl;
+  if(!dev->streaming)
+    return;
+  dev->fences[dev->stream_region] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+  dev->stream_region = (dev->stream_region + 1) % NK_COCOA_STREAM_REGIONS;
+}
+
 NK_API void nk_cocoa_device_destroy(void)
 {
   struct nk_cocoa_device *dev = &nk_cocoa.ogl;
   glDetachShader(dev->prog, dev->vert_shdr);
   glDetachShader(dev->prog, dev->frag_shdr);
   glDeleteShader(dev->vert_shdr);
-  glDeleteShader(dev->frag_shdr);
   glDeleteProgram(dev->prog);
+  glDetachShader(dev->inst_prog, dev->inst_vert_shdr);
+  glDetachShader(dev->inst_prog, dev->frag_shdr);
+  glDeleteShader(dev->inst_vert_shdr);
+  glDeleteProgram(dev->inst_prog);
+  glDeleteShader(dev->frag_shdr);
+  glDeleteVertexArrays(1, &dev->inst_vao);
   glDeleteTextures(1, &dev->font_tex);
+  dev->font_tex = 0;
+  nk_cocoa_stream_reset();
   glDeleteBuffers(1, &dev->vbo);
   glDeleteBuffers(1, &dev->ebo);
+  glDeleteBuffers(1, &dev->quad_ebo);
+#ifdef NK_COCOA_PARTIAL_REDRAW
+  glDeleteFramebuffers(1, &dev->fbo);
+  glDeleteRenderbuffers(1, &dev->color_rb);
+  nk_damage_free(&dev->damage);
+#endif
+  nk_convert_state_free(&dev->convert);
+#if NK_COCOA_MERGE_COMMANDS
+  nk_draw_merge_free(&dev->merge);
+  nk_buffer_free(&dev->converted_elements);
+#endif
+#ifdef NK_COCOA_CONVERT_THREADS
+  nk_job_pool_destroy(dev->pool);
+#endif
   nk_buffer_free(&dev->cmds);
 }
 
+#ifdef NK_COCOA_PARTIAL_REDRAW
+NK_API void nk_cocoa_set_clear_color(struct nk_colorf color)
+{
+  struct nk_cocoa_device *dev = &nk_cocoa.ogl;
+  if(color.r != dev->clear_color.r || color.g != dev->clear_color.g ||
+     color.b != dev->clear_color.b || color.a != dev->clear_color.a)
+    nk_damage_invalidate(&dev->damage);
+  dev->clear_color = color;
+}
+
+/* (re)creates the offscreen framebuffer the UI is retained in */
+NK_INTERN void nk_cocoa_retain_framebuffer(void)
+{
+  struct nk_cocoa_device *dev = &nk_cocoa.ogl;
+  if(dev->fbo && dev->fbo_width == nk_cocoa.display_width &&
+     dev->fbo_height == nk_cocoa.display_height)
+    return;
+  if(!dev->fbo)
+  {
+    glGenFramebuffers(1, &dev->fbo);
+    glGenRenderbuffers(1, &dev->color_rb);
+  }
+  glBindRenderbuffer(GL_RENDERBUFFER, dev->color_rb);
+  glRenderbufferStorage(GL_RENDERBUFFER, GL_RGBA8, (GLsizei)nk_cocoa.display_width,
+                        (GLsizei)nk_cocoa.display_height);
+  glBindRenderbuffer(GL_RENDERBUFFER, 0);
+  glBindFramebuffer(GL_FRAMEBUFFER, dev->fbo);
+  glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, dev->color_rb);
+  dev->fbo_width = nk_cocoa.display_width;
+  dev->fbo_height = nk_cocoa.display_height;
+  nk_damage_invalidate(&dev->damage);
+}
+#endif
+
 NK_API void nk_cocoa_render(enum nk_anti_aliasing AA, int max_vertex_buffer, int max_element_buffer)
 {
   struct nk_cocoa_device *dev = &nk_cocoa.ogl;
   struct nk_buffer vbuf, ebuf;
+  GLint region[4]; /* framebuffer area to draw, x0 y0 x1 y1 bottom-up */
+#ifdef NK_COCOA_PARTIAL_REDRAW
+  GLint window_fbo = 0;
+  struct nk_rect damage;
+#endif
   GLfloat ortho[4][4] = {
       {2.0f, 0.0f, 0.0f, 0.0f},
       {0.0f, -2.0f, 0.0f, 0.0f},
@@ -218,41 +1264,67 @@ NK_API void nk_cocoa_render(enum nk_anti_aliasing AA, int max_vertex_buffer, int
   };
   ortho[0][0] /= (GLfloat)nk_cocoa.width;
   ortho[1][1] /= (GLfloat)nk_cocoa.height;
+  nk_cocoa_frame_rendered();
+  nk_cocoa_optimize();
+  /* the application may have changed any state since the last frame */
+  NK_MEMSET(&dev->gl_state, 0xff, sizeof(dev->gl_state));
+  nk_cocoa_device_update_atlas();
+
+  region[0] = 0;
+  region[1] = 0;
+  region[2] = nk_cocoa.display_width;
+  region[3] = nk_cocoa.display_height;
+#ifdef NK_COCOA_PARTIAL_REDRAW
+  /* draw into the retained framebuffer, only where this frame differs from it */
+  glGetIntegerv(GL_DRAW_FRAMEBUFFER_BINDING, &window_fbo);
+  nk_cocoa_retain_framebuffer();
+  glBindFramebuffer(GL_FRAMEBUFFER, dev->fbo);
+  damage = nk_cocoa_damage();
+  region[0] = NK_MAX(region[0], (GLint)floorf(damage.x * nk_cocoa.fb_scale.x));
+  region[1] = NK_MAX(region[1], nk_cocoa.display_height -
+                                    (GLint)ceilf((damage.y + damage.h) * nk_cocoa.fb_scale.y));
+  region[2] = NK_MIN(region[2], (GLint)ceilf((damage.x + damage.w) * nk_cocoa.fb_scale.x));
+  region[3] = NK_MIN(region[3], nk_cocoa.display_height -
+                                    (GLint)floorf(damage.y * nk_cocoa.fb_scale.y));
+#endif
 
   /* setup global state */
-  glEnable(GL_BLEND);
-  glBlendEquation(GL_FUNC_ADD);
-  glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
-  glDisable(GL_CULL_FACE);
-  glDisable(GL_DEPTH_TEST);
-  glEnable(GL_SCISSOR_TEST);
-  glActiveTexture(GL_TEXTURE0);
-
-  /* setup program */
-  glUseProgram(dev->prog);
+  nk_cocoa_gl_enable(GL_BLEND, nk_true);
+  nk_cocoa_gl_blend(GL_FUNC_ADD, GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+  nk_cocoa_gl_enable(GL_CULL_FACE, nk_false);
+  nk_cocoa_gl_enable(GL_DEPTH_TEST, nk_false);
+  nk_cocoa_gl_enable(GL_SCISSOR_TEST, nk_true);
+  nk_cocoa_gl_active_texture(GL_TEXTURE0);
+
+  /* setup programs */
+  nk_cocoa_gl_use_program(dev->inst_prog);
+  glUniform1i(dev->inst_uniform_tex, 0);
+  glUniformMatrix4fv(dev->inst_uniform_proj, 1, GL_FALSE, &ortho[0][0]);
+  nk_cocoa_gl_use_program(dev->prog);
   glUniform1i(dev->uniform_tex, 0);
   glUniformMatrix4fv(dev->uniform_proj, 1, GL_FALSE, &ortho[0][0]);
-  glViewport(0, 0, (GLsizei)nk_cocoa.display_width, (GLsizei)nk_cocoa.display_height);
+  nk_cocoa_gl_viewport(0, 0, (GLsizei)nk_cocoa.display_width, (GLsizei)nk_cocoa.display_height);
+  if(region[0] < region[2] && region[1] < region[3])
   {
     /* convert from command queue into draw list and draw to screen */
     const struct nk_draw_command *cmd;
     void *vertices, *elements;
-    const nk_draw_index *offset = NULL;
-
-    /* allocate vertex and element buffer */
-    glBindVertexArray(dev->vao);
-    glBindBuffer(GL_ARRAY_BUFFER, dev->vbo);
-    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, dev->ebo);
-
-    glBufferData(GL_ARRAY_BUFFER, max_vertex_buffer, NULL, GL_STREAM_DRAW);
-    glBufferData(GL_ELEMENT_ARRAY_BUFFER, max_element_buffer, NULL, GL_STREAM_DRAW);
+    const nk_draw_index *offset;
+    size_t vertex_offset, element_offset, bound = 0;
+    unsigned long draws = 0;
+    int attempt;
 
-    /* load draw vertices & elements directly into vertex + element buffer */
-    vertices = glMapBuffer(GL_ARRAY_BUFFER, GL_WRITE_ONLY);
-    elements = glMapBuffer(GL_ELEMENT_ARRAY_BUFFER, GL_WRITE_ONLY);
+    /* region sizes stay multiples of 256 so every region starts aligned */
+    dev->vbo_size = NK_MAX(dev->vbo_size, ((nk_size)max_vertex_buffer + 255) & ~(nk_size)255);
+    dev->ebo_size = NK_MAX(dev->ebo_size, ((nk_size)max_element_buffer + 255) & ~(nk_size)255);
+    nk_cocoa_gl_bind_vertex_array(dev->vao);
+    nk_cocoa_gl_bind_buffer(GL_ARRAY_BUFFER, dev->vbo);
+    nk_cocoa_gl_bind_buffer(GL_ELEMENT_ARRAY_BUFFER, dev->ebo);
+    for(attempt = 0; attempt < 2; ++attempt)
     {
       /* fill convert configuration */
       struct nk_convert_config config;
+      nk_flags res;
       static const struct nk_draw_vertex_layout_element vertex_layout[] = {
           {NK_VERTEX_POSITION, NK_FORMAT_FLOAT, NK_OFFSETOF(struct nk_cocoa_vertex, position)},
           {NK_VERTEX_TEXCOORD, NK_FORMAT_FLOAT, NK_OFFSETOF(struct nk_cocoa_vertex, uv)},
@@ -266,43 +1338,113 @@ NK_API void nk_cocoa_render(enum nk_anti_aliasing AA, int max_vertex_buffer, int
       config.circle_segment_count = 22;
       config.curve_segment_count = 22;
       config.arc_segment_count = 22;
+      config.segment_error = NK_COCOA_SEGMENT_ERROR;
+      config.pixel_scale = NK_MAX(nk_cocoa.fb_scale.x, nk_cocoa.fb_scale.y);
       config.global_alpha = 1.0f;
       config.shape_AA = AA;
       config.line_AA = AA;
+      config.quad_batch = NK_COCOA_QUAD_BATCH;
+      config.quad_instances = NK_COCOA_QUAD_INSTANCES;
 
-      /* setup buffers to load vertices and elements */
-      nk_buffer_init_fixed(&vbuf, vertices, (size_t)max_vertex_buffer);
-      nk_buffer_init_fixed(&ebuf, elements, (size_t)max_element_buffer);
-      nk_convert(&nk_cocoa.ctx, &dev->cmds, &vbuf, &ebuf, &config);
+      /* load draw vertices & elements directly into vertex + element buffer */
+      nk_cocoa_map_buffers(&vertices, &elements, &vertex_offset, &element_offset);
+      nk_buffer_init_fixed(&vbuf, vertices, dev->vbo_size);
+      nk_buffer_init_fixed(&ebuf, elements, dev->ebo_size);
+      res = nk_cocoa_convert(&vbuf, &ebuf, &config);
+      glUnmapBuffer(GL_ARRAY_BUFFER);
+      glUnmapBuffer(GL_ELEMENT_ARRAY_BUFFER);
+      if(!nk_cocoa_buffers_full(res, &vbuf, &ebuf, &dev->vbo_size, &dev->ebo_size))
+        break;
     }
-    glUnmapBuffer(GL_ARRAY_BUFFER);
-    glUnmapBuffer(GL_ELEMENT_ARRAY_BUFFER);
+    if(attempt == 2)
+      nk_cocoa_frame_incomplete();
+    nk_cocoa.frame_stats.vertex_buffer = dev->vbo_size;
+    nk_cocoa.frame_stats.element_buffer = dev->ebo_size;
+
+#ifdef NK_COCOA_PARTIAL_REDRAW
+    nk_cocoa_gl_scissor(region[0], region[1], region[2] - region[0], region[3] - region[1]);
+    glClearColor(dev->clear_color.r, dev->clear_color.g, dev->clear_color.b, dev->clear_color.a);
+    glClear(GL_COLOR_BUFFER_BIT);
+#endif
 
     /* iterate over and execute each draw command */
+    offset = (const nk_draw_index *)element_offset;
     nk_draw_foreach(cmd, &nk_cocoa.ctx, &dev->cmds)
     {
+      GLint x0, y0, x1, y1;
+      size_t base = vertex_offset + cmd->vertex_offset * sizeof(struct nk_cocoa_vertex);
       if(!cmd->elem_count)
         continue;
-      glBindTexture(GL_TEXTURE_2D, (GLuint)cmd->texture.id);
-      glScissor((GLint)(cmd->clip_rect.x * nk_cocoa.fb_scale.x),
-                (GLint)((nk_cocoa.height - (GLint)(cmd->clip_rect.y + cmd->clip_rect.h)) *
-                        nk_cocoa.fb_scale.y),
-                (GLint)(cmd->clip_rect.w * nk_cocoa.fb_scale.x),
-                (GLint)(cmd->clip_rect.h * nk_cocoa.fb_scale.y));
-      glDrawElements(GL_TRIANGLES, (GLsizei)cmd->elem_count, GL_UNSIGNED_SHORT, offset);
-      offset += cmd->elem_count;
+      draws++;
+      nk_cocoa_gl_use_program(cmd->instances ? dev->inst_prog : dev->prog);
+      nk_cocoa_gl_bind_vertex_array(cmd->instances ? dev->inst_vao : dev->vao);
+      if(cmd->instances)
+        nk_cocoa_device_bind_instances(base);
+      else if(base != bound)
+      {
+        bound = base;
+        nk_cocoa_device_bind_vertices(bound);
+      }
+      x0 = (GLint)(cmd->clip_rect.x * nk_cocoa.fb_scale.x);
+      y0 = (GLint)((nk_cocoa.height - (GLint)(cmd->clip_rect.y + cmd->clip_rect.h)) *
+                   nk_cocoa.fb_scale.y);
+      x1 = x0 + (GLint)(cmd->clip_rect.w * nk_cocoa.fb_scale.x);
+      y1 = y0 + (GLint)(cmd->clip_rect.h * nk_cocoa.fb_scale.y);
+      x0 = NK_MAX(x0, region[0]);
+      y0 = NK_MAX(y0, region[1]);
+      x1 = NK_MIN(x1, region[2]);
+      y1 = NK_MIN(y1, region[3]);
+      if(x0 < x1 && y0 < y1)
+      {
+        nk_cocoa_gl_bind_texture((GLuint)cmd->texture.id);
+        nk_cocoa_gl_scissor(x0, y0, x1 - x0, y1 - y0);
+        if(cmd->instances)
+          glDrawArraysInstanced(GL_TRIANGLES, 0, 6, (GLsizei)(cmd->elem_count / 6));
+        else
+        {
+          nk_cocoa_gl_bind_buffer(GL_ELEMENT_ARRAY_BUFFER, cmd->quads ? dev->quad_ebo : dev->ebo);
+          glDrawElements(GL_TRIANGLES, (GLsizei)cmd->elem_count, NK_COCOA_INDEX_TYPE,
+                         cmd->quads ? NULL : offset);
+        }
+      }
+      if(!cmd->quads && !cmd->instances)
+        offset += cmd->elem_count;
+    }
+    nk_cocoa_fence_buffers();
+    nk_cocoa.frame_stats.draw_calls += draws;
+#if NK_COCOA_MERGE_COMMANDS
+    nk_cocoa.frame_stats.draw_commands += (unsigned long)dev->merge.draws_before;
+#else
+    nk_cocoa.frame_stats.draw_commands += draws;
+#endif
+    if(bound)
+    {
+      nk_cocoa_gl_bind_vertex_array(dev->vao);
+      nk_cocoa_device_bind_vertices(0);
     }
-    nk_clear(&nk_cocoa.ctx);
   }
+  nk_clear(&nk_cocoa.ctx);
+
+#ifdef NK_COCOA_PARTIAL_REDRAW
+  /* copy the whole retained UI to the framebuffer that was bound */
+  nk_cocoa_gl_enable(GL_SCISSOR_TEST, nk_false);
+  glBindFramebuffer(GL_READ_FRAMEBUFFER, dev->fbo);
+  glBindFramebuffer(GL_DRAW_FRAMEBUFFER, (GLuint)window_fbo);
+  glBlitFramebuffer(0, 0, nk_cocoa.display_width, nk_cocoa.display_height, 0, 0,
+                    nk_cocoa.display_width, nk_cocoa.display_height, GL_COLOR_BUFFER_BIT,
+                    GL_NEAREST);
+  glBindFramebuffer(GL_FRAMEBUFFER, (GLuint)window_fbo);
+#endif
 
   /* default OpenGL state */
-  glUseProgram(0);
-  glBindBuffer(GL_ARRAY_BUFFER, 0);
-  glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
-  glBindVertexArray(0);
-  glDisable(GL_BLEND);
-  glDisable(GL_SCISSOR_TEST);
+  nk_cocoa_gl_use_program(0);
+  nk_cocoa_gl_bind_buffer(GL_ARRAY_BUFFER, 0);
+  nk_cocoa_gl_bind_buffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+  nk_cocoa_gl_bind_vertex_array(0);
+  nk_cocoa_gl_enable(GL_BLEND, nk_false);
+  nk_cocoa_gl_enable(GL_SCISSOR_TEST, nk_false);
 }
+#endif
 
 NK_API void nk_cocoa_char_callback(COCOAwindow *win, unsigned int codepoint)
 {
@@ -362,19 +1504,120 @@ NK_API struct nk_context *nk_cocoa_init(COCOAwindow *win, enum nk_cocoa_init_sta
 NK_API void nk_cocoa_font_stash_begin(struct nk_font_atlas **atlas)
 {
   nk_font_atlas_init_default(&nk_cocoa.atlas);
+#if defined(NK_COCOA_SOFTWARE) || defined(NK_COCOA_CONVERT_THREADS)
+  nk_cocoa.atlas.dispatch = nk_cocoa_dispatch;
+  nk_cocoa.atlas.scheduler = nk_handle_ptr(nk_cocoa.ogl.pool);
+#endif
   nk_font_atlas_begin(&nk_cocoa.atlas);
   *atlas = &nk_cocoa.atlas;
 }
 
+#if defined(NK_COCOA_ATLAS_CACHE) && !NK_COCOA_DYNAMIC_ATLAS
+/* maps the cache file, the returned image points into the mapping */
+NK_INTERN const void *nk_cocoa_atlas_cache_load(const char *path, int *w, int *h, void **map,
+                                                size_t *map_size)
+{
+  struct stat st;
+  const void *image;
+  int fd = open(path, O_RDONLY);
+  *map = 0;
+  if(fd < 0)
+    return 0;
+  if(fstat(fd, &st) || st.st_size <= 0)
+  {
+    close(fd);
+    return 0;
+  }
+  *map_size = (size_t)st.st_size;
+  *map = mmap(0, *map_size, PROT_READ, MAP_PRIVATE, fd, 0);
+  close(fd);
+  if(*map == MAP_FAILED)
+  {
+    *map = 0;
+    return 0;
+  }
+  image = nk_font_atlas_load(&nk_cocoa.atlas, *map, *map_size, w, h, NK_FONT_ATLAS_RGBA32);
+  if(!image)
+  {
+    munmap(*map, *map_size);
+    *map = 0;
+  }
+  return image;
+}
+
+/* writes the freshly baked atlas next to the cache file and renames it over the old one */
+NK_INTERN void nk_cocoa_atlas_cache_save(const char *path)
+{
+  char tmp[1024];
+  void *map;
+  int fd;
+  nk_size size = nk_font_atlas_save(&nk_cocoa.atlas, NK_FONT_ATLAS_RGBA32, 0, 0);
+  if(!size || snprintf(tmp, sizeof(tmp), "%s.%d", path, (int)getpid()) >= (int)sizeof(tmp))
+    return;
+  fd = open(tmp, O_RDWR | O_CREAT | O_TRUNC, 0644);
+  if(fd < 0)
+    return;
+  if(ftruncate(fd, (off_t)size) ||
+     (map = mmap(0, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0)) == MAP_FAILED)
+  {
+    close(fd);
+    unlink(tmp);
+    return;
+  }
+  nk_font_atlas_save(&nk_cocoa.atlas, NK_FONT_ATLAS_RGBA32, map, size);
+  munmap(map, size);
+  close(fd);
+  if(rename(tmp, path))
+    unlink(tmp);
+}
+#endif
+
 NK_API void nk_cocoa_font_stash_end(void)
 {
   const void *image;
   int w, h;
+#if NK_COCOA_DYNAMIC_ATLAS
+  w = h = NK_COCOA_DYNAMIC_ATLAS;
+  image = nk_font_atlas_bake_dynamic(&nk_cocoa.atlas, w, h, NK_FONT_ATLAS_RGBA32);
+#elif defined(NK_COCOA_ATLAS_CACHE)
+  void *map;
+  size_t map_size;
+  image = nk_cocoa_atlas_cache_load(NK_COCOA_ATLAS_CACHE, &w, &h, &map, &map_size);
+  if(!image)
+  {
+    image = nk_font_atlas_bake(&nk_cocoa.atlas, &w, &h, NK_FONT_ATLAS_RGBA32);
+    if(image)
+      nk_cocoa_atlas_cache_save(NK_COCOA_ATLAS_CACHE);
+  }
+#else
   image = nk_font_atlas_bake(&nk_cocoa.atlas, &w, &h, NK_FONT_ATLAS_RGBA32);
+#endif
   nk_cocoa_device_upload_atlas(image, w, h);
+#if defined(NK_COCOA_ATLAS_CACHE) && !NK_COCOA_DYNAMIC_ATLAS
+  if(map)
+    munmap(map, map_size);
+#endif
+  /* cached vertices and the last frame reference the glyphs of the previous atlas */
+  nk_convert_state_invalidate(&nk_cocoa.ogl.convert);
+  nk_cocoa.frame_digest_valid = nk_false;
+#ifdef NK_COCOA_SOFTWARE
+  nk_font_atlas_end(&nk_cocoa.atlas, nk_handle_ptr(&nk_cocoa.ogl.font_tex), &nk_cocoa.ogl.null);
+#else
   nk_font_atlas_end(&nk_cocoa.atlas, nk_handle_id((int)nk_cocoa.ogl.font_tex), &nk_cocoa.ogl.null);
+#endif
   if(nk_cocoa.atlas.default_font)
+  {
+#if NK_COCOA_TEXT_WIDTH_CACHE
+    if(!nk_cocoa.text_widths.capacity)
+      nk_text_width_cache_init_default(&nk_cocoa.text_widths, NK_COCOA_TEXT_WIDTH_CACHE);
+    nk_text_width_cache_clear(&nk_cocoa.text_widths);
+    nk_cached_font_init(&nk_cocoa.cached_font, &nk_cocoa.atlas.default_font->handle,
+                        &nk_cocoa.text_widths);
+    nk_style_set_font(&nk_cocoa.ctx, &nk_cocoa.cached_font.handle);
+#else
     nk_style_set_font(&nk_cocoa.ctx, &nk_cocoa.atlas.default_font->handle);
+#endif
+  }
 }
 
 NK_API void nk_cocoa_new_frame(void)
@@ -452,6 +1695,7 @@ NK_API
 void nk_cocoa_shutdown(void)
 {
   nk_font_atlas_clear(&nk_cocoa.atlas);
+  nk_text_width_cache_free(&nk_cocoa.text_widths);
   nk_free(&nk_cocoa.ctx);
   nk_cocoa_device_destroy();
   memset(&nk_cocoa, 0, sizeof(nk_cocoa));
@@ -0,0 +1,254 @@
+/*
+ * Nuklear - 1.32.0 - public domain
+ * no warrenty implied; use at your own risk.
+ * authored from 2015-2016 by Micha Mettke
+ */
+/*
+ * ==============================================================
+ *
+ *                              API
+ *
+ * ===============================================================
+ */
+/*
+ * Minimal work-stealing thread pool used by the CPU heavy parts of the backends.
+ *
+ * nk_job_pool_run is a blocking parallel-for: job indices [0, count) are split into one
+ * contiguous range per worker, each worker pops from the front of its own range and, once it
+ * runs dry, steals the back half of the fullest range it can find. The calling thread takes part
+ * as worker 0, so a pool of one thread runs everything inline.
+ */
+#ifndef NK_JOBS_H_
+#define NK_JOBS_H_
+
+struct nk_job_pool;
+typedef void (*nk_job_func)(void *userdata, int index, int worker);
+
+/* thread_count includes the calling thread, 0 picks the number of online cores */
+NK_API struct nk_job_pool *nk_job_pool_create(int thread_count);
+NK_API void nk_job_pool_destroy(struct nk_job_pool *pool);
+NK_API int nk_job_pool_size(const struct nk_job_pool *pool);
+NK_API void nk_job_pool_run(struct nk_job_pool *pool, int count, nk_job_func func, void *userdata);
+
+#endif
+/*
+ * ==============================================================
+ *
+ *                          IMPLEMENTATION
+ *
+ * ===============================================================
+ */
+#if defined(NK_JOBS_IMPLEMENTATION) && !defined(NK_JOBS_IMPLEMENTED)
+#define NK_JOBS_IMPLEMENTED
+
+#include <pthread.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+#ifndef NK_JOBS_MAX_THREADS
+#define NK_JOBS_MAX_THREADS 64
+#endif
+
+/* [begin, end) packed into one word so owner pops and thief splits are a single CAS */
+struct nk_job_range
+{
+  uint64_t packed;
+  char pad[64 - sizeof(uint64_t)];
+};
+
+struct nk_job_pool
+{
+  int thread_count;
+  pthread_t threads[NK_JOBS_MAX_THREADS];
+  struct nk_job_range ranges[NK_JOBS_MAX_THREADS];
+
+  pthread_mutex_t lock;
+  pthread_cond_t wake;
+  pthread_cond_t done;
+  unsigned int generation;
+  int running;
+  int quit;
+
+  nk_job_func func;
+  void *userdata;
+};
+
+struct nk_job_worker
+{
+  struct nk_job_pool *pool;
+  int index;
+};
+
+#define NK_JOB_RANGE(b, e) (((uint64_t)(uint32_t)(b) << 32) | (uint64_t)(uint32_t)(e))
+#define NK_JOB_BEGIN(r) ((int)((r) >> 32))
+#define NK_JOB_END(r) ((int)((r)&0xffffffffu))
+
+NK_INTERN int nk_job_pop(struct nk_job_range *range)
+{
+  uint64_t r = __atomic_load_n(&range->packed, __ATOMIC_ACQUIRE);
+  while(NK_JOB_BEGIN(r) < NK_JOB_END(r))
+  {
+    uint64_t next = NK_JOB_RANGE(NK_JOB_BEGIN(r) + 1, NK_JOB_END(r));
+    if(__atomic_compare_exchange_n(&range->packed, &r, next, 0, __ATOMIC_ACQ_REL,
+                                   __ATOMIC_ACQUIRE))
+      return NK_JOB_BEGIN(r);
+  }
+  return -1;
+}
+
+NK_INTERN int nk_job_steal(struct nk_job_pool *pool, int thief)
+{
+  for(;;)
+  {
+    int victim = -1, best = 0, i;
+    uint64_t r;
+    for(i = 0; i < pool->thread_count; ++i)
+    {
+      uint64_t v = __atomic_load_n(&pool->ranges[i].packed, __ATOMIC_ACQUIRE);
+      int left = NK_JOB_END(v) - NK_JOB_BEGIN(v);
+      if(i != thief && left > best)
+      {
+        best = left;
+        victim = i;
+      }
+    }
+    if(victim < 0)
+      return 0;
+
+    r = __atomic_load_n(&pool->ranges[victim].packed, __ATOMIC_ACQUIRE);
+    if(NK_JOB_BEGIN(r) < NK_JOB_END(r))
+    {
+      int begin = NK_JOB_BEGIN(r), end = NK_JOB_END(r);
+      int mid = begin + (end - begin) / 2;
+      if(__atomic_compare_exchange_n(&pool->ranges[victim].packed, &r, NK_JOB_RANGE(begin, mid),
+                                     0, __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE))
+      {
+        /* our own range is empty so nobody else can be modifying it */
+        __atomic_store_n(&pool->ranges[thief].packed, NK_JOB_RANGE(mid, end), __ATOMIC_RELEASE);
+        return 1;
+      }
+    }
+  }
+}
+
+NK_INTERN void nk_job_work(struct nk_job_pool *pool, int worker)
+{
+  do
+  {
+    int index;
+    while((index = nk_job_pop(&pool->ranges[worker])) >= 0)
+      pool->func(pool->userdata, index, worker);
+  } while(nk_job_steal(pool, worker));
+}
+
+NK_INTERN void *nk_job_thread(void *arg)
+{
+  struct nk_job_worker *self = (struct nk_job_worker *)arg;
+  struct nk_job_pool *pool = self->pool;
+  unsigned int seen = 0;
+
+  pthread_mutex_lock(&pool->lock);
+  for(;;)
+  {
+    while(!pool->quit && pool->generation == seen)
+      pthread_cond_wait(&pool->wake, &pool->lock);
+    if(pool->quit)
+      break;
+    seen = pool->generation;
+    pthread_mutex_unlock(&pool->lock);
+
+    nk_job_work(pool, self->index);
+
+    pthread_mutex_lock(&pool->lock);
+    if(--pool->running == 0)
+      pthread_cond_signal(&pool->done);
+  }
+  pthread_mutex_unlock(&pool->lock);
+  free(self);
+  return 0;
+}
+
+NK_API struct nk_job_pool *nk_job_pool_create(int thread_count)
+{
+  struct nk_job_pool *pool;
+  int i;
+
+  if(thread_count <= 0)
+    thread_count = (int)sysconf(_SC_NPROCESSORS_ONLN);
+  thread_count = NK_CLAMP(1, thread_count, NK_JOBS_MAX_THREADS);
+
+  pool = (struct nk_job_pool *)calloc(1, sizeof(struct nk_job_pool));
+  pool->thread_count = thread_count;
+  pthread_mutex_init(&pool->lock, 0);
+  pthread_cond_init(&pool->wake, 0);
+  pthread_cond_init(&pool->done, 0);
+  for(i = 1; i < thread_count; ++i)
+  {
+    struct nk_job_worker *worker = (struct nk_job_worker *)malloc(sizeof(struct nk_job_worker));
+    worker->pool = pool;
+    worker->index = i;
+    pthread_create(&pool->threads[i], 0, nk_job_thread, worker);
+  }
+  return pool;
+}
+
+NK_API void nk_job_pool_destroy(struct nk_job_pool *pool)
+{
+  int i;
+  if(!pool)
+    return;
+  pthread_mutex_lock(&pool->lock);
+  pool->quit = nk_true;
+  pthread_cond_broadcast(&pool->wake);
+  pthread_mutex_unlock(&pool->lock);
+  for(i = 1; i < pool->thread_count; ++i)
+    pthread_join(pool->threads[i], 0);
+  pthread_cond_destroy(&pool->done);
+  pthread_cond_destroy(&pool->wake);
+  pthread_mutex_destroy(&pool->lock);
+  free(pool);
+}
+
+NK_API int nk_job_pool_size(const struct nk_job_pool *pool)
+{
+  return pool ? pool->thread_count : 1;
+}
+
+NK_API void nk_job_pool_run(struct nk_job_pool *pool, int count, nk_job_func func, void *userdata)
+{
+  int i, workers;
+  if(count <= 0)
+    return;
+  if(!pool || pool->thread_count == 1 || count == 1)
+  {
+    for(i = 0; i < count; ++i)
+      func(userdata, i, 0);
+    return;
+  }
+
+  workers = pool->thread_count;
+  pool->func = func;
+  pool->userdata = userdata;
+  for(i = 0; i < workers; ++i)
+  {
+    int begin = (int)((long long)count * i / workers);
+    int end = (int)((long long)count * (i + 1) / workers);
+    __atomic_store_n(&pool->ranges[i].packed, NK_JOB_RANGE(begin, end), __ATOMIC_RELAXED);
+  }
+
+  pthread_mutex_lock(&pool->lock);
+  pool->running = workers - 1;
+  ++pool->generation;
+  pthread_cond_broadcast(&pool->wake);
+  pthread_mutex_unlock(&pool->lock);
+
+  nk_job_work(pool, 0);
+
+  pthread_mutex_lock(&pool->lock);
+  while(pool->running)
+    pthread_cond_wait(&pool->done, &pool->lock);
+  pthread_mutex_unlock(&pool->lock);
+}
+
+#endif
@@ -0,0 +1,1300 @@
+/*
+ * Nuklear - 1.32.0 - public domain
+ * no warrenty implied; use at your own risk.
+ * authored from 2015-2016 by Micha Mettke
+ */
+/*
+ * ==============================================================
+ *
+ *                              API
+ *
+ * ===============================================================
+ */
+/*
+ * CPU rasterizer for the output of nk_convert: textured, vertex colored, scissored triangles
+ * blended with (SRC_ALPHA, ONE_MINUS_SRC_ALPHA) into a top-down RGBA8 buffer, matching the
+ * OpenGL backend. Textures are sampled nearest. Solid color spans are filled with SSE2 when
+ * available.
+ *
+ * Textures are passed through nk_handle.ptr as `const struct nk_raster_texture *`.
+ *
+ * nk_raster_draw_tiled splits the target into NK_RASTER_TILE_SIZE square tiles, bins every
+ * triangle into the tiles its bounds (clipped to its command's clip_rect) touch and rasterizes the
+ * tiles in parallel on a nuklear_jobs.h pool. Within a tile triangles keep submission order, so
+ * the result is identical to nk_raster_draw.
+ *
+ * nk_raster_commands skips nk_convert altogether and rasterizes the nk_command stream of a
+ * context directly: rects, circles, arcs, lines and polygons are drawn from their signed distance
+ * with the same one pixel anti-aliasing fringe nk_convert generates, text is blitted glyph by glyph
+ * from the font atlas. NK_COMMAND_CUSTOM is skipped since its callback expects a draw list.
+ * nk_raster_commands_tiled does the same on the pool, one band of NK_RASTER_TILE_SIZE rows per
+ * job.
+ *
+ * Both tiled functions take an optional region (in UI units like the clip rects, NULL for the
+ * whole target): pixels outside of it are neither cleared nor drawn, so a retained target only
+ * needs the damaged part of a frame redrawn.
+ */
+#ifndef NK_RASTER_H_
+#define NK_RASTER_H_
+
+struct nk_raster_vertex
+{
+  float position[2];
+  float uv[2];
+  nk_byte col[4];
+};
+
+struct nk_raster_texture
+{
+  const nk_byte *pixels;
+  int width, height;
+};
+
+struct nk_raster_target
+{
+  nk_byte *pixels;
+  int width, height;
+  int pitch;
+};
+
+struct nk_job_pool;
+struct nk_raster_tile_command;
+struct nk_raster_bin_entry;
+
+struct nk_raster_tiler
+{
+  struct nk_job_pool *pool;
+  int tiles_x, tiles_y;
+
+  struct nk_raster_tile_command *commands;
+  int command_count, command_capacity;
+  struct nk_raster_bin_entry *entries;
+  nk_size entry_capacity;
+  unsigned int *bins;
+  unsigned int *bin_cursor;
+  int bin_capacity;
+
+  /* current frame */
+  struct nk_raster_target *target;
+  const struct nk_raster_vertex *vertices;
+  const nk_draw_index *elements;
+  struct nk_vec2 scale;
+  struct nk_color clear;
+  struct nk_context *ctx;
+  enum nk_anti_aliasing AA;
+  int region[4];
+};
+
+NK_API void nk_raster_clear(struct nk_raster_target *target, struct nk_color color);
+NK_API void nk_raster_draw(struct nk_raster_target *target, const struct nk_draw_command *cmd,
+                           const struct nk_raster_vertex *vertices, const nk_draw_index *elements,
+                           struct nk_vec2 scale);
+
+NK_API void nk_raster_tiler_init(struct nk_raster_tiler *tiler, struct nk_job_pool *pool);
+NK_API void nk_raster_tiler_free(struct nk_raster_tiler *tiler);
+NK_API void nk_raster_draw_tiled(struct nk_raster_tiler *tiler, struct nk_raster_target *target,
+                                 struct nk_color clear, const struct nk_context *ctx,
+                                 const struct nk_buffer *cmds,
+                                 const struct nk_raster_vertex *vertices,
+                                 const nk_draw_index *elements, struct nk_vec2 scale,
+                                 const struct nk_rect *region);
+
+NK_API void nk_raster_commands(struct nk_raster_target *target, struct nk_context *ctx,
+                               struct nk_vec2 scale, enum nk_anti_aliasing AA);
+NK_API void nk_raster_commands_tiled(struct nk_raster_tiler *tiler, struct nk_raster_target *target,
+                                     struct nk_color clear, struct nk_context *ctx,
+                                     struct nk_vec2 scale, enum nk_anti_aliasing AA,
+                                     const struct nk_rect *region);
+
+#endif
+/*
+ * ==============================================================
+ *
+ *                          IMPLEMENTATION
+ *
+ * ===============================================================
+ */
+#if defined(NK_RASTER_IMPLEMENTATION) && !defined(NK_RASTER_IMPLEMENTED)
+#define NK_RASTER_IMPLEMENTED
+
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "nuklear_jobs.h"
+
+#ifndef NK_RASTER_TILE_SIZE
+#define NK_RASTER_TILE_SIZE 64
+#endif
+
+#if defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#define NK_RASTER_SSE2
+#endif
+
+struct nk_raster_tile_command
+{
+  int clip[4];
+  unsigned int element_begin, element_end;
+  const struct nk_raster_vertex *vertices; /* offset by the command's vertex_offset */
+  const struct nk_raster_texture *tex;
+};
+
+struct nk_raster_bin_entry
+{
+  unsigned int command;
+  unsigned int element;
+};
+
+struct nk_raster_edge
+{
+  float a, b, c;
+  int owned;
+};
+
+NK_INTERN nk_uint nk_raster_pack(const nk_byte *c)
+{
+  nk_uint packed;
+  NK_MEMCPY(&packed, c, 4);
+  return packed;
+}
+
+/* (a * b) / 255 rounded, exact for all 8 bit inputs */
+NK_INTERN nk_byte nk_raster_mul8(unsigned int a, unsigned int b)
+{
+  unsigned int x = a * b + 128;
+  return (nk_byte)((x + (x >> 8)) >> 8);
+}
+
+NK_INTERN void nk_raster_blend_pixel(nk_byte *dst, const nk_byte *src)
+{
+  unsigned int a = src[3], ia = 255 - a;
+  if(a == 0)
+    return;
+  if(a == 255)
+  {
+    NK_MEMCPY(dst, src, 4);
+    return;
+  }
+  dst[0] = (nk_byte)(nk_raster_mul8(src[0], a) + nk_raster_mul8(dst[0], ia));
+  dst[1] = (nk_byte)(nk_raster_mul8(src[1], a) + nk_raster_mul8(dst[1], ia));
+  dst[2] = (nk_byte)(nk_raster_mul8(src[2], a) + nk_raster_mul8(dst[2], ia));
+  dst[3] = (nk_byte)(nk_raster_mul8(src[3], a) + nk_raster_mul8(dst[3], ia));
+}
+
+NK_INTERN void nk_raster_store_span(nk_byte *dst, int count, nk_uint color)
+{
+  int i = 0;
+#ifdef NK_RASTER_SSE2
+  __m128i c = _mm_set1_epi32((int)color);
+  for(; i + 4 <= count; i += 4)
+    _mm_storeu_si128((__m128i *)(dst + i * 4), c);
+#endif
+  for(; i < count; ++i)
+    NK_MEMCPY(dst + i * 4, &color, 4);
+}
+
+NK_INTERN void nk_raster_fill_span(nk_byte *dst, int count, const nk_byte *src)
+{
+  nk_uint color = nk_raster_pack(src);
+  unsigned int a = src[3];
+  int i = 0;
+
+  if(a == 0 || count <= 0)
+    return;
+  if(a == 255)
+  {
+    nk_raster_store_span(dst, count, color);
+    return;
+  }
+
+#ifdef NK_RASTER_SSE2
+  {
+    /* premultiplied source, destination scaled by (255 - a), both divided by 255 */
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i bias = _mm_set1_epi16(128);
+    const __m128i ia = _mm_set1_epi16((short)(255 - a));
+    __m128i s = _mm_unpacklo_epi8(_mm_set1_epi32((int)color), zero);
+    s = _mm_mullo_epi16(s, _mm_set1_epi16((short)a));
+    s = _mm_add_epi16(s, bias);
+    s = _mm_srli_epi16(_mm_add_epi16(s, _mm_srli_epi16(s, 8)), 8);
+    for(; i + 4 <= count; i += 4)
+    {
+      __m128i d = _mm_loadu_si128((const __m128i *)(dst + i * 4));
+      __m128i lo = _mm_add_epi16(_mm_mullo_epi16(_mm_unpacklo_epi8(d, zero), ia), bias);
+      __m128i hi = _mm_add_epi16(_mm_mullo_epi16(_mm_unpackhi_epi8(d, zero), ia), bias);
+      lo = _mm_srli_epi16(_mm_add_epi16(lo, _mm_srli_epi16(lo, 8)), 8);
+      hi = _mm_srli_epi16(_mm_add_epi16(hi, _mm_srli_epi16(hi, 8)), 8);
+      lo = _mm_add_epi16(lo, s);
+      hi = _mm_add_epi16(hi, s);
+      _mm_storeu_si128((__m128i *)(dst + i * 4), _mm_packus_epi16(lo, hi));
+    }
+  }
+#endif
+  for(; i < count; ++i)
+    nk_raster_blend_pixel(dst + i * 4, src);
+}
+
+NK_INTERN void nk_raster_sample(const struct nk_raster_texture *tex, float u, float v, nk_byte *out)
+{
+  int x, y;
+  if(!tex || !tex->pixels)
+  {
+    out[0] = out[1] = out[2] = out[3] = 255;
+    return;
+  }
+  x = (int)floorf(u * (float)tex->width);
+  y = (int)floorf(v * (float)tex->height);
+  x = NK_CLAMP(0, x, tex->width - 1);
+  y = NK_CLAMP(0, y, tex->height - 1);
+  NK_MEMCPY(out, tex->pixels + ((size_t)y * (size_t)tex->width + (size_t)x) * 4, 4);
+}
+
+/* Edges are always set up from their lower endpoint so triangles sharing an edge compute the
+ * exact same coefficients (up to sign), and the ownership rule assigns every pixel center on a
+ * shared edge to exactly one of them. */
+NK_INTERN void nk_raster_edge_setup(struct nk_raster_edge *e, struct nk_vec2 p, struct nk_vec2 q)
+{
+  float sign = 1.0f;
+  if(p.y > q.y || (p.y == q.y && p.x > q.x))
+  {
+    struct nk_vec2 t = p;
+    p = q;
+    q = t;
+    sign = -1.0f;
+  }
+  e->a = (p.y - q.y) * sign;
+  e->b = (q.x - p.x) * sign;
+  e->c = -((p.y - q.y) * p.x + (q.x - p.x) * p.y) * sign;
+  e->owned = e->a > 0.0f || (e->a == 0.0f && e->b > 0.0f);
+}
+
+/* Clips [*x0, *x1) on the row with center yc to the inside of all three edges. */
+NK_INTERN int nk_raster_edge_span(const struct nk_raster_edge *e, float yc, int *x0, int *x1)
+{
+  int i;
+  for(i = 0; i < 3; ++i)
+  {
+    float r = e[i].b * yc + e[i].c;
+    if(e[i].a == 0.0f)
+    {
+      if(r < 0.0f || (r == 0.0f && !e[i].owned))
+        return 0;
+    }
+    else
+    {
+      float xb = -r / e[i].a - 0.5f;
+      if(e[i].a > 0.0f)
+      {
+        int lo = e[i].owned ? (int)ceilf(xb) : (int)floorf(xb) + 1;
+        *x0 = NK_MAX(*x0, lo);
+      }
+      else
+      {
+        int hi = e[i].owned ? (int)floorf(xb) + 1 : (int)ceilf(xb);
+        *x1 = NK_MIN(*x1, hi);
+      }
+    }
+  }
+  return *x0 < *x1;
+}
+
+NK_INTERN int nk_raster_clip(const struct nk_raster_target *target, struct nk_rect rect,
+                             struct nk_vec2 scale, int *clip)
+{
+  /* same truncation as the glScissor call of the OpenGL backend */
+  clip[0] = (int)(rect.x * scale.x);
+  clip[1] = (int)(rect.y * scale.y);
+  clip[2] = clip[0] + (int)(rect.w * scale.x);
+  clip[3] = clip[1] + (int)(rect.h * scale.y);
+  clip[0] = NK_MAX(clip[0], 0);
+  clip[1] = NK_MAX(clip[1], 0);
+  clip[2] = NK_MIN(clip[2], target->width);
+  clip[3] = NK_MIN(clip[3], target->height);
+  return clip[0] < clip[2] && clip[1] < clip[3];
+}
+
+/* Pixels covered by region, all of the target without one */
+NK_INTERN void nk_raster_region(const struct nk_raster_target *target, const struct nk_rect *region,
+                                struct nk_vec2 scale, int *out)
+{
+  out[0] = 0;
+  out[1] = 0;
+  out[2] = target->width;
+  out[3] = target->height;
+  if(!region)
+    return;
+  out[0] = NK_MAX(out[0], (int)floorf(region->x * scale.x));
+  out[1] = NK_MAX(out[1], (int)floorf(region->y * scale.y));
+  out[2] = NK_MIN(out[2], (int)ceilf((region->x + region->w) * scale.x));
+  out[3] = NK_MIN(out[3], (int)ceilf((region->y + region->h) * scale.y));
+}
+
+NK_INTERN int nk_raster_intersect(int *a, const int *b)
+{
+  a[0] = NK_MAX(a[0], b[0]);
+  a[1] = NK_MAX(a[1], b[1]);
+  a[2] = NK_MIN(a[2], b[2]);
+  a[3] = NK_MIN(a[3], b[3]);
+  return a[0] < a[2] && a[1] < a[3];
+}
+
+/* Pixel bounds of a triangle as used by nk_raster_triangle, false when it covers nothing */
+NK_INTERN int nk_raster_bounds(const struct nk_raster_vertex *v0, const struct nk_raster_vertex *v1,
+                               const struct nk_raster_vertex *v2, struct nk_vec2 scale,
+                               const int *clip, int *bounds)
+{
+  float x0 = v0->position[0] * scale.x, y0 = v0->position[1] * scale.y;
+  float x1 = v1->position[0] * scale.x, y1 = v1->position[1] * scale.y;
+  float x2 = v2->position[0] * scale.x, y2 = v2->position[1] * scale.y;
+  bounds[0] = NK_MAX(clip[0], (int)floorf(NK_MIN(x0, NK_MIN(x1, x2))));
+  bounds[1] = NK_MAX(clip[1], (int)floorf(NK_MIN(y0, NK_MIN(y1, y2))));
+  bounds[2] = NK_MIN(clip[2], (int)ceilf(NK_MAX(x0, NK_MAX(x1, x2))));
+  bounds[3] = NK_MIN(clip[3], (int)ceilf(NK_MAX(y0, NK_MAX(y1, y2))));
+  return bounds[0] < bounds[2] && bounds[1] < bounds[3];
+}
+
+NK_INTERN void nk_raster_triangle(struct nk_raster_target *target,
+                                  const struct nk_raster_texture *tex,
+                                  const struct nk_raster_vertex *v0,
+                                  const struct nk_raster_vertex *v1,
+                                  const struct nk_raster_vertex *v2, struct nk_vec2 scale,
+                                  const int *clip)
+{
+  struct nk_vec2 p0, p1, p2;
+  struct nk_raster_edge e[3];
+  float area, inv_area;
+  int minx, miny, maxx, maxy, y;
+  int solid_color, solid_uv;
+
+  p0 = nk_vec2(v0->position[0] * scale.x, v0->position[1] * scale.y);
+  p1 = nk_vec2(v1->position[0] * scale.x, v1->position[1] * scale.y);
+  p2 = nk_vec2(v2->position[0] * scale.x, v2->position[1] * scale.y);
+
+  area = (p1.x - p0.x) * (p2.y - p0.y) - (p1.y - p0.y) * (p2.x - p0.x);
+  if(area == 0.0f || area != area)
+    return;
+  if(area < 0.0f)
+  {
+    const struct nk_raster_vertex *tv = v1;
+    struct nk_vec2 tp = p1;
+    v1 = v2;
+    v2 = tv;
+    p1 = p2;
+    p2 = tp;
+    area = -area;
+  }
+  inv_area = 1.0f / area;
+
+  {
+    int bounds[4];
+    if(!nk_raster_bounds(v0, v1, v2, scale, clip, bounds))
+      return;
+    minx = bounds[0];
+    miny = bounds[1];
+    maxx = bounds[2];
+    maxy = bounds[3];
+  }
+
+  /* e[i] is the edge opposite to vertex i, so it evaluates to its barycentric weight */
+  nk_raster_edge_setup(&e[0], p1, p2);
+  nk_raster_edge_setup(&e[1], p2, p0);
+  nk_raster_edge_setup(&e[2], p0, p1);
+
+  solid_color = nk_raster_pack(v0->col) == nk_raster_pack(v1->col) &&
+                nk_raster_pack(v0->col) == nk_raster_pack(v2->col);
+  solid_uv = v0->uv[0] == v1->uv[0] && v0->uv[0] == v2->uv[0] && v0->uv[1] == v1->uv[1] &&
+             v0->uv[1] == v2->uv[1];
+
+  if(solid_color && solid_uv)
+  {
+    /* constant fragment: the common case for everything drawn with the null texture */
+    nk_byte texel[4], src[4];
+    nk_raster_sample(tex, v0->uv[0], v0->uv[1], texel);
+    src[0] = nk_raster_mul8(v0->col[0], texel[0]);
+    src[1] = nk_raster_mul8(v0->col[1], texel[1]);
+    src[2] = nk_raster_mul8(v0->col[2], texel[2]);
+    src[3] = nk_raster_mul8(v0->col[3], texel[3]);
+    if(!src[3])
+      return;
+    for(y = miny; y < maxy; ++y)
+    {
+      int x0 = minx, x1 = maxx;
+      if(nk_raster_edge_span(e, (float)y + 0.5f, &x0, &x1))
+        nk_raster_fill_span(target->pixels + (size_t)y * (size_t)target->pitch + (size_t)x0 * 4,
+                            x1 - x0, src);
+    }
+    return;
+  }
+
+  for(y = miny; y < maxy; ++y)
+  {
+    const float yc = (float)y + 0.5f;
+    int x0 = minx, x1 = maxx, x;
+    nk_byte *dst;
+    if(!nk_raster_edge_span(e, yc, &x0, &x1))
+      continue;
+
+    dst = target->pixels + (size_t)y * (size_t)target->pitch + (size_t)x0 * 4;
+    for(x = x0; x < x1; ++x, dst += 4)
+    {
+      const float xc = (float)x + 0.5f;
+      const float w0 = (e[0].a * xc + e[0].b * yc + e[0].c) * inv_area;
+      const float w1 = (e[1].a * xc + e[1].b * yc + e[1].c) * inv_area;
+      const float w2 = 1.0f - w0 - w1;
+      nk_byte texel[4], src[4];
+      int i;
+
+      if(solid_uv)
+        nk_raster_sample(tex, v0->uv[0], v0->uv[1], texel);
+      else
+        nk_raster_sample(tex, w0 * v0->uv[0] + w1 * v1->uv[0] + w2 * v2->uv[0],
+                         w0 * v0->uv[1] + w1 * v1->uv[1] + w2 * v2->uv[1], texel);
+      for(i = 0; i < 4; ++i)
+      {
+        float c = w0 * v0->col[i] + w1 * v1->col[i] + w2 * v2->col[i] + 0.5f;
+        unsigned int ci = c <= 0.0f ? 0u : (c >= 255.0f ? 255u : (unsigned int)c);
+        src[i] = solid_color ? nk_raster_mul8(v0->col[i], texel[i]) : nk_raster_mul8(ci, texel[i]);
+      }
+      nk_raster_blend_pixel(dst, src);
+    }
+  }
+}
+
+NK_API void nk_raster_clear(struct nk_raster_target *target, struct nk_color color)
+{
+  int y;
+  nk_byte src[4];
+  src[0] = color.r;
+  src[1] = color.g;
+  src[2] = color.b;
+  src[3] = color.a;
+  for(y = 0; y < target->height; ++y)
+    nk_raster_store_span(target->pixels + (size_t)y * (size_t)target->pitch, target->width,
+                         nk_raster_pack(src));
+}
+
+NK_API void nk_raster_draw(struct nk_raster_target *target, const struct nk_draw_command *cmd,
+                           const struct nk_raster_vertex *vertices, const nk_draw_index *elements,
+                           struct nk_vec2 scale)
+{
+  const struct nk_raster_texture *tex = (const struct nk_raster_texture *)cmd->texture.ptr;
+  unsigned int i;
+  int clip[4];
+
+  if(!nk_raster_clip(target, cmd->clip_rect, scale, clip))
+    return;
+
+  vertices += cmd->vertex_offset;
+  for(i = 0; i + 2 < cmd->elem_count; i += 3)
+    nk_raster_triangle(target, tex, &vertices[elements[i + 0]], &vertices[elements[i + 1]],
+                       &vertices[elements[i + 2]], scale, clip);
+}
+
+NK_API void nk_raster_tiler_init(struct nk_raster_tiler *tiler, struct nk_job_pool *pool)
+{
+  NK_MEMSET(tiler, 0, sizeof(*tiler));
+  tiler->pool = pool;
+}
+
+NK_API void nk_raster_tiler_free(struct nk_raster_tiler *tiler)
+{
+  free(tiler->commands);
+  free(tiler->entries);
+  free(tiler->bins);
+  free(tiler->bin_cursor);
+  NK_MEMSET(tiler, 0, sizeof(*tiler));
+}
+
+NK_INTERN void nk_raster_tile_job(void *userdata, int tile, int worker)
+{
+  struct nk_raster_tiler *tiler = (struct nk_raster_tiler *)userdata;
+  struct nk_raster_target *target = tiler->target;
+  const struct nk_raster_bin_entry *entry = tiler->entries + tiler->bins[tile];
+  const struct nk_raster_bin_entry *end = tiler->entries + tiler->bins[tile + 1];
+  struct nk_raster_target view;
+  int tile_rect[4];
+  (void)worker;
+
+  tile_rect[0] = (tile % tiler->tiles_x) * NK_RASTER_TILE_SIZE;
+  tile_rect[1] = (tile / tiler->tiles_x) * NK_RASTER_TILE_SIZE;
+  tile_rect[2] = NK_MIN(tile_rect[0] + NK_RASTER_TILE_SIZE, target->width);
+  tile_rect[3] = NK_MIN(tile_rect[1] + NK_RASTER_TILE_SIZE, target->height);
+  if(!nk_raster_intersect(tile_rect, tiler->region))
+    return;
+
+  view.pixels = target->pixels + (size_t)tile_rect[1] * (size_t)target->pitch +
+                (size_t)tile_rect[0] * 4;
+  view.width = tile_rect[2] - tile_rect[0];
+  view.height = tile_rect[3] - tile_rect[1];
+  view.pitch = target->pitch;
+  nk_raster_clear(&view, tiler->clear);
+
+  for(; entry != end; ++entry)
+  {
+    const struct nk_raster_tile_command *cmd = &tiler->commands[entry->command];
+    const nk_draw_index *tri = tiler->elements + entry->element;
+    int clip[4];
+    NK_MEMCPY(clip, cmd->clip, sizeof(clip));
+    nk_raster_intersect(clip, tile_rect);
+    nk_raster_triangle(target, cmd->tex, &cmd->vertices[tri[0]], &cmd->vertices[tri[1]],
+                       &cmd->vertices[tri[2]], tiler->scale, clip);
+  }
+}
+
+/* Visits every tile touched by every visible triangle in submission order, either counting the
+ * triangles per tile or appending them at the bin cursors set up from those counts. */
+NK_INTERN void nk_raster_bin_triangles(struct nk_raster_tiler *tiler, int fill)
+{
+  int c;
+  for(c = 0; c < tiler->command_count; ++c)
+  {
+    const struct nk_raster_tile_command *cmd = &tiler->commands[c];
+    unsigned int e;
+    for(e = cmd->element_begin; e + 2 < cmd->element_end; e += 3)
+    {
+      const nk_draw_index *tri = tiler->elements + e;
+      int bounds[4], tx, ty;
+      if(!nk_raster_bounds(&cmd->vertices[tri[0]], &cmd->vertices[tri[1]],
+                           &cmd->vertices[tri[2]], tiler->scale, cmd->clip, bounds))
+        continue;
+      for(ty = bounds[1] / NK_RASTER_TILE_SIZE; ty <= (bounds[3] - 1) / NK_RASTER_TILE_SIZE; ++ty)
+      {
+        for(tx = bounds[0] / NK_RASTER_TILE_SIZE; tx <= (bounds[2] - 1) / NK_RASTER_TILE_SIZE;
+            ++tx)
+        {
+          const int tile = ty * tiler->tiles_x + tx;
+          if(fill)
+          {
+            struct nk_raster_bin_entry *entry = &tiler->entries[tiler->bin_cursor[tile]++];
+            entry->command = (unsigned int)c;
+            entry->element = e;
+          }
+          else
+            tiler->bin_cursor[tile]++;
+        }
+      }
+    }
+  }
+}
+
+NK_API void nk_raster_draw_tiled(struct nk_raster_tiler *tiler, struct nk_raster_target *target,
+                                 struct nk_color clear, const struct nk_context *ctx,
+                                 const struct nk_buffer *cmds,
+                                 const struct nk_raster_vertex *vertices,
+                                 const nk_draw_index *elements, struct nk_vec2 scale,
+                                 const struct nk_rect *region)
+{
+  const struct nk_draw_command *cmd;
+  unsigned int offset = 0;
+  nk_size total = 0;
+  int tile_count, i;
+
+  tiler->target = target;
+  tiler->vertices = vertices;
+  tiler->elements = elements;
+  tiler->scale = scale;
+  tiler->clear = clear;
+  nk_raster_region(target, region, scale, tiler->region);
+  tiler->tiles_x = (target->width + NK_RASTER_TILE_SIZE - 1) / NK_RASTER_TILE_SIZE;
+  tiler->tiles_y = (target->height + NK_RASTER_TILE_SIZE - 1) / NK_RASTER_TILE_SIZE;
+  tile_count = tiler->tiles_x * tiler->tiles_y;
+  if(!tile_count)
+    return;
+
+  /* gather visible commands */
+  tiler->command_count = 0;
+  nk_draw_foreach(cmd, ctx, cmds)
+  {
+    struct nk_raster_tile_command *out;
+    if(!cmd->elem_count)
+      continue;
+    if(tiler->command_count == tiler->command_capacity)
+    {
+      tiler->command_capacity = tiler->command_capacity ? tiler->command_capacity * 2 : 256;
+      tiler->commands = (struct nk_raster_tile_command *)realloc(
+          tiler->commands, (size_t)tiler->command_capacity * sizeof(*tiler->commands));
+    }
+    out = &tiler->commands[tiler->command_count];
+    out->tex = (const struct nk_raster_texture *)cmd->texture.ptr;
+    out->vertices = vertices + cmd->vertex_offset;
+    out->element_begin = offset;
+    out->element_end = offset + cmd->elem_count;
+    offset += cmd->elem_count;
+    if(nk_raster_clip(target, cmd->clip_rect, scale, out->clip) &&
+       nk_raster_intersect(out->clip, tiler->region))
+      tiler->command_count++;
+  }
+
+  /* count, prefix sum and fill the per tile bins */
+  if(tile_count + 1 > tiler->bin_capacity)
+  {
+    tiler->bin_capacity = tile_count + 1;
+    tiler->bins = (unsigned int *)realloc(tiler->bins, (size_t)tiler->bin_capacity * sizeof(unsigned int));
+    tiler->bin_cursor = (unsigned int *)realloc(tiler->bin_cursor,
+                                                (size_t)tiler->bin_capacity * sizeof(unsigned int));
+  }
+  NK_MEMSET(tiler->bin_cursor, 0, (size_t)tile_count * sizeof(unsigned int));
+  nk_raster_bin_triangles(tiler, nk_false);
+  for(i = 0; i < tile_count; ++i)
+  {
+    tiler->bins[i] = (unsigned int)total;
+    total += tiler->bin_cursor[i];
+    tiler->bin_cursor[i] = tiler->bins[i];
+  }
+  tiler->bins[tile_count] = (unsigned int)total;
+  if(total > tiler->entry_capacity)
+  {
+    tiler->entry_capacity = total + total / 2;
+    tiler->entries = (struct nk_raster_bin_entry *)realloc(
+        tiler->entries, tiler->entry_capacity * sizeof(struct nk_raster_bin_entry));
+  }
+  nk_raster_bin_triangles(tiler, nk_true);
+
+  nk_job_pool_run(tiler->pool, tile_count, nk_raster_tile_job, tiler);
+}
+
+/*
+ * Direct rasterization of the command stream
+ */
+enum nk_raster_shape_type
+{
+  NK_RASTER_SHAPE_RECT,
+  NK_RASTER_SHAPE_CIRCLE,
+  NK_RASTER_SHAPE_PIE,
+  NK_RASTER_SHAPE_CONVEX,
+  NK_RASTER_SHAPE_PATH
+};
+
+/* Everything in pixels. Pixels whose center lies inside `inner` are known to be fully covered
+ * (fills) or not covered at all (strokes) and skip the distance evaluation. */
+struct nk_raster_shape
+{
+  enum nk_raster_shape_type type;
+  struct nk_vec2 center, half;
+  float radius;
+  struct nk_vec2 dir[2];
+  float span;
+  const struct nk_vec2 *points;
+  int count, closed, butt;
+  float winding;
+  float stroke;
+  float bounds[4];
+  float inner[4];
+};
+
+NK_INTERN float nk_raster_segment_distance(struct nk_vec2 p, struct nk_vec2 a, struct nk_vec2 b,
+                                           int butt, float half_width)
+{
+  const float dx = b.x - a.x, dy = b.y - a.y;
+  const float px = p.x - a.x, py = p.y - a.y;
+  const float len2 = dx * dx + dy * dy;
+  float t;
+
+  if(len2 == 0.0f)
+    return sqrtf(px * px + py * py);
+  t = (px * dx + py * dy) / len2;
+  if(butt)
+  {
+    /* distance to the line box, shifted so |d| - half_width stays the box distance */
+    const float len = sqrtf(len2);
+    const float across = fabsf(px * dy - py * dx) / len;
+    const float outside = NK_MAX(-t * len, (t - 1.0f) * len);
+    float ex;
+    if(outside <= 0.0f)
+      return across;
+    ex = NK_MAX(across - half_width, 0.0f);
+    return half_width + sqrtf(outside * outside + ex * ex);
+  }
+  t = NK_CLAMP(0.0f, t, 1.0f);
+  {
+    const float ex = px - t * dx, ey = py - t * dy;
+    return sqrtf(ex * ex + ey * ey);
+  }
+}
+
+/* Signed distance to the outline, negative inside */
+NK_INTERN float nk_raster_shape_distance(const struct nk_raster_shape *s, float x, float y)
+{
+  switch(s->type)
+  {
+  case NK_RASTER_SHAPE_RECT:
+  {
+    const float qx = fabsf(x - s->center.x) - (s->half.x - s->radius);
+    const float qy = fabsf(y - s->center.y) - (s->half.y - s->radius);
+    const float ox = NK_MAX(qx, 0.0f), oy = NK_MAX(qy, 0.0f);
+    return sqrtf(ox * ox + oy * oy) + NK_MIN(NK_MAX(qx, qy), 0.0f) - s->radius;
+  }
+  case NK_RASTER_SHAPE_CIRCLE:
+  {
+    const float dx = x - s->center.x, dy = y - s->center.y;
+    return sqrtf(dx * dx + dy * dy) - s->radius;
+  }
+  case NK_RASTER_SHAPE_PIE:
+  {
+    const float dx = x - s->center.x, dy = y - s->center.y;
+    const float circle = sqrtf(dx * dx + dy * dy) - s->radius;
+    const float d0 = -(s->dir[0].x * dy - s->dir[0].y * dx);
+    const float d1 = s->dir[1].x * dy - s->dir[1].y * dx;
+    if(s->span >= 2.0f * NK_PI)
+      return circle;
+    return NK_MAX(circle, s->span <= NK_PI ? NK_MAX(d0, d1) : NK_MIN(d0, d1));
+  }
+  case NK_RASTER_SHAPE_CONVEX:
+  {
+    float d = -1e30f;
+    int i;
+    for(i = 0; i < s->count; ++i)
+    {
+      const struct nk_vec2 a = s->points[i], b = s->points[(i + 1) % s->count];
+      const float dx = b.x - a.x, dy = b.y - a.y;
+      const float len = sqrtf(dx * dx + dy * dy);
+      if(len > 0.0f)
+        d = NK_MAX(d, -(dx * (y - a.y) - dy * (x - a.x)) * s->winding / len);
+    }
+    return d;
+  }
+  case NK_RASTER_SHAPE_PATH:
+  {
+    const struct nk_vec2 p = nk_vec2(x, y);
+    float d = 1e30f;
+    int i, segments = s->closed ? s->count : s->count - 1;
+    for(i = 0; i < segments; ++i)
+      d = NK_MIN(d, nk_raster_segment_distance(p, s->points[i], s->points[(i + 1) % s->count],
+                                               s->butt, s->stroke));
+    return d;
+  }
+  }
+  return 1e30f;
+}
+
+NK_INTERN void nk_raster_coverage_pixel(nk_byte *dst, const struct nk_raster_shape *s,
+                                        const nk_byte *src, float xc, float yc, int aa)
+{
+  float d = nk_raster_shape_distance(s, xc, yc), coverage;
+  nk_byte px[4];
+  if(s->stroke >= 0.0f)
+    d = fabsf(d) - s->stroke;
+  if(aa)
+    coverage = NK_CLAMP(0.0f, 0.5f - d, 1.0f);
+  else
+    coverage = d <= 0.0f ? 1.0f : 0.0f;
+  if(coverage <= 0.0f)
+    return;
+  NK_MEMCPY(px, src, 4);
+  px[3] = nk_raster_mul8(src[3], (unsigned int)(coverage * 255.0f + 0.5f));
+  nk_raster_blend_pixel(dst, px);
+}
+
+NK_INTERN void nk_raster_shape(struct nk_raster_target *target, const int *clip,
+                               const struct nk_raster_shape *s, struct nk_color color, int aa)
+{
+  const int minx = NK_MAX(clip[0], (int)floorf(s->bounds[0]));
+  const int miny = NK_MAX(clip[1], (int)floorf(s->bounds[1]));
+  const int maxx = NK_MIN(clip[2], (int)ceilf(s->bounds[2]));
+  const int maxy = NK_MIN(clip[3], (int)ceilf(s->bounds[3]));
+  nk_byte src[4];
+  int x, y;
+
+  src[0] = color.r;
+  src[1] = color.g;
+  src[2] = color.b;
+  src[3] = color.a;
+  if(!src[3] || minx >= maxx)
+    return;
+
+  for(y = miny; y < maxy; ++y)
+  {
+    const float yc = (float)y + 0.5f;
+    nk_byte *row = target->pixels + (size_t)y * (size_t)target->pitch;
+    int ix0 = maxx, ix1 = maxx;
+    if(yc >= s->inner[1] && yc <= s->inner[3])
+    {
+      ix0 = NK_CLAMP(minx, (int)ceilf(s->inner[0] - 0.5f), maxx);
+      ix1 = NK_CLAMP(ix0, (int)floorf(s->inner[2] - 0.5f) + 1, maxx);
+    }
+    for(x = minx; x < ix0; ++x)
+      nk_raster_coverage_pixel(row + (size_t)x * 4, s, src, (float)x + 0.5f, yc, aa);
+    if(s->stroke < 0.0f)
+      nk_raster_fill_span(row + (size_t)ix0 * 4, ix1 - ix0, src);
+    for(x = ix1; x < maxx; ++x)
+      nk_raster_coverage_pixel(row + (size_t)x * 4, s, src, (float)x + 0.5f, yc, aa);
+  }
+}
+
+NK_INTERN void nk_raster_shape_init(struct nk_raster_shape *s, enum nk_raster_shape_type type,
+                                    float stroke)
+{
+  NK_MEMSET(s, 0, sizeof(*s));
+  s->type = type;
+  s->stroke = stroke;
+  s->inner[1] = 1.0f;
+  s->inner[3] = 0.0f;
+}
+
+/* Bounds of a point list grown by the stroke and the anti-aliasing fringe */
+NK_INTERN void nk_raster_shape_points(struct nk_raster_shape *s, const struct nk_vec2 *points,
+                                      int count)
+{
+  const float grow = NK_MAX(s->stroke, 0.0f) + 1.0f;
+  float area = 0.0f;
+  int i;
+  s->points = points;
+  s->count = count;
+  s->bounds[0] = s->bounds[2] = points[0].x;
+  s->bounds[1] = s->bounds[3] = points[0].y;
+  for(i = 0; i < count; ++i)
+  {
+    const struct nk_vec2 a = points[i], b = points[(i + 1) % count];
+    s->bounds[0] = NK_MIN(s->bounds[0], a.x);
+    s->bounds[1] = NK_MIN(s->bounds[1], a.y);
+    s->bounds[2] = NK_MAX(s->bounds[2], a.x);
+    s->bounds[3] = NK_MAX(s->bounds[3], a.y);
+    area += a.x * b.y - b.x * a.y;
+  }
+  s->bounds[0] -= grow;
+  s->bounds[1] -= grow;
+  s->bounds[2] += grow;
+  s->bounds[3] += grow;
+  s->winding = area < 0.0f ? -1.0f : 1.0f;
+}
+
+NK_INTERN void nk_raster_shape_rect(struct nk_raster_target *target, const int *clip,
+                                    struct nk_rect r, float rounding, float stroke,
+                                    struct nk_color color, int aa)
+{
+  struct nk_raster_shape s;
+  const float grow = NK_MAX(stroke, 0.0f) + 1.0f;
+  nk_raster_shape_init(&s, NK_RASTER_SHAPE_RECT, stroke);
+  s.half = nk_vec2(r.w * 0.5f, r.h * 0.5f);
+  s.center = nk_vec2(r.x + s.half.x, r.y + s.half.y);
+  s.radius = NK_MAX(0.0f, NK_MIN(rounding, NK_MIN(s.half.x, s.half.y)));
+  s.bounds[0] = r.x - grow;
+  s.bounds[1] = r.y - grow;
+  s.bounds[2] = r.x + r.w + grow;
+  s.bounds[3] = r.y + r.h + grow;
+  if(stroke >= 0.0f)
+  {
+    /* hole in the middle of the outline */
+    const float hole = stroke + 0.5f + s.radius;
+    s.inner[0] = r.x + hole;
+    s.inner[1] = r.y + hole;
+    s.inner[2] = r.x + r.w - hole;
+    s.inner[3] = r.y + r.h - hole;
+  }
+  else if(s.radius <= 0.5f)
+  {
+    s.inner[0] = r.x + 0.5f;
+    s.inner[1] = r.y + 0.5f;
+    s.inner[2] = r.x + r.w - 0.5f;
+    s.inner[3] = r.y + r.h - 0.5f;
+  }
+  else
+  {
+    /* full width rows between the rounded corners */
+    s.inner[0] = r.x + 0.5f;
+    s.inner[1] = r.y + s.radius;
+    s.inner[2] = r.x + r.w - 0.5f;
+    s.inner[3] = r.y + r.h - s.radius;
+  }
+  nk_raster_shape(target, clip, &s, color, aa);
+}
+
+NK_INTERN void nk_raster_shape_circle(struct nk_raster_target *target, const int *clip,
+                                      struct nk_vec2 center, float radius, float stroke,
+                                      struct nk_color color, int aa)
+{
+  struct nk_raster_shape s;
+  const float grow = radius + NK_MAX(stroke, 0.0f) + 1.0f;
+  float inner;
+  nk_raster_shape_init(&s, NK_RASTER_SHAPE_CIRCLE, stroke);
+  s.center = center;
+  s.radius = radius;
+  s.bounds[0] = center.x - grow;
+  s.bounds[1] = center.y - grow;
+  s.bounds[2] = center.x + grow;
+  s.bounds[3] = center.y + grow;
+  inner = (radius - NK_MAX(stroke, 0.0f) - 0.5f) * 0.70710678f;
+  if(inner > 0.0f)
+  {
+    s.inner[0] = center.x - inner;
+    s.inner[1] = center.y - inner;
+    s.inner[2] = center.x + inner;
+    s.inner[3] = center.y + inner;
+  }
+  nk_raster_shape(target, clip, &s, color, aa);
+}
+
+NK_INTERN void nk_raster_shape_pie(struct nk_raster_target *target, const int *clip,
+                                   struct nk_vec2 center, float radius, const float *angles,
+                                   float stroke, struct nk_color color, int aa)
+{
+  struct nk_raster_shape s;
+  const float grow = radius + NK_MAX(stroke, 0.0f) + 1.0f;
+  nk_raster_shape_init(&s, NK_RASTER_SHAPE_PIE, stroke);
+  s.center = center;
+  s.radius = radius;
+  s.dir[0] = nk_vec2(cosf(angles[0]), sinf(angles[0]));
+  s.dir[1] = nk_vec2(cosf(angles[1]), sinf(angles[1]));
+  s.span = angles[1] - angles[0];
+  s.bounds[0] = center.x - grow;
+  s.bounds[1] = center.y - grow;
+  s.bounds[2] = center.x + grow;
+  s.bounds[3] = center.y + grow;
+  if(s.span > 0.0f)
+    nk_raster_shape(target, clip, &s, color, aa);
+}
+
+NK_INTERN void nk_raster_shape_path(struct nk_raster_target *target, const int *clip,
+                                    enum nk_raster_shape_type type, const struct nk_vec2 *points,
+                                    int count, int closed, float stroke, struct nk_color color,
+                                    int aa)
+{
+  struct nk_raster_shape s;
+  if(count < 2 || (type == NK_RASTER_SHAPE_CONVEX && count < 3))
+    return;
+  nk_raster_shape_init(&s, type, stroke);
+  s.closed = closed;
+  /* a single line gets butt caps like nk_draw_list_stroke_line, joints of longer paths are round */
+  s.butt = count == 2 && !closed;
+  nk_raster_shape_points(&s, points, count);
+  nk_raster_shape(target, clip, &s, color, aa);
+}
+
+NK_INTERN void nk_raster_shape_points_cmd(struct nk_raster_target *target, const int *clip,
+                                          enum nk_raster_shape_type type,
+                                          const struct nk_vec2i *points, int count, int closed,
+                                          float stroke, struct nk_color color,
+                                          struct nk_vec2 scale, int aa)
+{
+  struct nk_vec2 local[64], *pts = local;
+  int i;
+  if(count > (int)NK_LEN(local))
+    pts = (struct nk_vec2 *)malloc((size_t)count * sizeof(struct nk_vec2));
+  for(i = 0; i < count; ++i)
+    pts[i] = nk_vec2((float)points[i].x * scale.x, (float)points[i].y * scale.y);
+  nk_raster_shape_path(target, clip, type, pts, count, closed, stroke, color, aa);
+  if(pts != local)
+    free(pts);
+}
+
+/* Quad split along the top-left to bottom-right diagonal and shaded like the two triangles
+ * nk_draw_list_fill_rect_multi_color emits. */
+NK_INTERN void nk_raster_multi_color(struct nk_raster_target *target, const int *clip,
+                                     struct nk_rect r, struct nk_color left, struct nk_color top,
+                                     struct nk_color right, struct nk_color bottom)
+{
+  const int minx = NK_MAX(clip[0], (int)ceilf(r.x - 0.5f));
+  const int miny = NK_MAX(clip[1], (int)ceilf(r.y - 0.5f));
+  const int maxx = NK_MIN(clip[2], (int)ceilf(r.x + r.w - 0.5f));
+  const int maxy = NK_MIN(clip[3], (int)ceilf(r.y + r.h - 0.5f));
+  const nk_byte *tl = &left.r, *tr = &top.r, *br = &right.r, *bl = &bottom.r;
+  int x, y, i;
+
+  if(r.w <= 0.0f || r.h <= 0.0f)
+    return;
+  for(y = miny; y < maxy; ++y)
+  {
+    const float v = ((float)y + 0.5f - r.y) / r.h;
+    nk_byte *dst = target->pixels + (size_t)y * (size_t)target->pitch + (size_t)minx * 4;
+    for(x = minx; x < maxx; ++x, dst += 4)
+    {
+      const float u = ((float)x + 0.5f - r.x) / r.w;
+      nk_byte src[4];
+      for(i = 0; i < 4; ++i)
+      {
+        float c = u >= v ? tl[i] * (1.0f - u) + tr[i] * (u - v) + br[i] * v
+                         : tl[i] * (1.0f - v) + bl[i] * (v - u) + br[i] * u;
+        c += 0.5f;
+        src[i] = (nk_byte)(c <= 0.0f ? 0 : (c >= 255.0f ? 255 : (int)c));
+      }
+      nk_raster_blend_pixel(dst, src);
+    }
+  }
+}
+
+/* Textured rect, pixel centers in [x0, x1) x [y0, y1) like the two triangles of a quad */
+NK_INTERN void nk_raster_blit(struct nk_raster_target *target, const int *clip,
+                              const struct nk_raster_texture *tex, struct nk_rect r,
+                              struct nk_vec2 uv0, struct nk_vec2 uv1, struct nk_color color)
+{
+  const int minx = NK_MAX(clip[0], (int)ceilf(r.x - 0.5f));
+  const int miny = NK_MAX(clip[1], (int)ceilf(r.y - 0.5f));
+  const int maxx = NK_MIN(clip[2], (int)ceilf(r.x + r.w - 0.5f));
+  const int maxy = NK_MIN(clip[3], (int)ceilf(r.y + r.h - 0.5f));
+  float du, dv;
+  int x, y;
+
+  if(!color.a || r.w <= 0.0f || r.h <= 0.0f)
+    return;
+  du = (uv1.x - uv0.x) / r.w;
+  dv = (uv1.y - uv0.y) / r.h;
+  for(y = miny; y < maxy; ++y)
+  {
+    const float v = uv0.y + ((float)y + 0.5f - r.y) * dv;
+    nk_byte *dst = target->pixels + (size_t)y * (size_t)target->pitch + (size_t)minx * 4;
+    for(x = minx; x < maxx; ++x, dst += 4)
+    {
+      nk_byte texel[4], src[4];
+      nk_raster_sample(tex, uv0.x + ((float)x + 0.5f - r.x) * du, v, texel);
+      if(!texel[3])
+        continue;
+      src[0] = nk_raster_mul8(color.r, texel[0]);
+      src[1] = nk_raster_mul8(color.g, texel[1]);
+      src[2] = nk_raster_mul8(color.b, texel[2]);
+      src[3] = nk_raster_mul8(color.a, texel[3]);
+      nk_raster_blend_pixel(dst, src);
+    }
+  }
+}
+
+NK_INTERN void nk_raster_text(struct nk_raster_target *target, const int *clip,
+                              const struct nk_command_text *t, struct nk_vec2 scale)
+{
+  const struct nk_user_font *font = t->font;
+  const struct nk_raster_texture *tex = (const struct nk_raster_texture *)font->texture.ptr;
+  float x = t->x;
+  int text_len = 0, glyph_len, next_glyph_len;
+  nk_rune unicode = 0, next = 0;
+
+  if(!t->length || !t->foreground.a || clip[0] >= clip[2] || clip[1] >= clip[3])
+    return;
+  /* glyphs stay within a line height of the text rect */
+  if((float)(t->y - t->height) * scale.y >= (float)clip[3] ||
+     (float)(t->y + t->h + t->height) * scale.y <= (float)clip[1])
+    return;
+
+  glyph_len = nk_utf_decode(t->string, &unicode, t->length);
+  while(text_len < t->length && glyph_len)
+  {
+    struct nk_user_font_glyph g;
+    if(unicode == NK_UTF_INVALID)
+      break;
+    next_glyph_len = nk_utf_decode(t->string + text_len + glyph_len, &next, t->length - text_len);
+    font->query(font->userdata, t->height, &g, unicode, (next == NK_UTF_INVALID) ? '\0' : next);
+    nk_raster_blit(target, clip, tex,
+                   nk_rect((x + g.offset.x) * scale.x, ((float)t->y + g.offset.y) * scale.y,
+                           g.width * scale.x, g.height * scale.y),
+                   g.uv[0], g.uv[1], t->foreground);
+    text_len += glyph_len;
+    x += g.xadvance;
+    glyph_len = next_glyph_len;
+    unicode = next;
+  }
+}
+
+/* Rasterizes every command into the part of the target inside region */
+NK_INTERN void nk_raster_command_stream(struct nk_raster_target *target, struct nk_context *ctx,
+                                        struct nk_vec2 scale, int aa, const int *region)
+{
+  const float s = (scale.x + scale.y) * 0.5f;
+  const struct nk_command *cmd;
+  int clip[4];
+
+  NK_MEMCPY(clip, region, sizeof(clip));
+  nk_foreach(cmd, ctx)
+  {
+    switch(cmd->type)
+    {
+    case NK_COMMAND_SCISSOR:
+    {
+      const struct nk_command_scissor *c = (const struct nk_command_scissor *)cmd;
+      nk_raster_clip(target, nk_rect(c->x, c->y, c->w, c->h), scale, clip);
+      clip[0] = NK_MAX(clip[0], region[0]);
+      clip[1] = NK_MAX(clip[1], region[1]);
+      clip[2] = NK_MIN(clip[2], region[2]);
+      clip[3] = NK_MIN(clip[3], region[3]);
+    }
+    break;
+    case NK_COMMAND_LINE:
+    {
+      const struct nk_command_line *c = (const struct nk_command_line *)cmd;
+      nk_raster_shape_points_cmd(target, clip, NK_RASTER_SHAPE_PATH, &c->begin, 2, nk_false,
+                                 c->line_thickness * s * 0.5f, c->color, scale, aa);
+    }
+    break;
+    case NK_COMMAND_CURVE:
+    {
+      const struct nk_command_curve *c = (const struct nk_command_curve *)cmd;
+      struct nk_vec2 p[23];
+      const int segments = (int)NK_LEN(p) - 1;
+      int i;
+      for(i = 0; i <= segments; ++i)
+      {
+        const float t = (float)i / (float)segments, u = 1.0f - t;
+        const float w1 = u * u * u, w2 = 3 * u * u * t, w3 = 3 * u * t * t, w4 = t * t * t;
+        p[i].x = (w1 * c->begin.x + w2 * c->ctrl[0].x + w3 * c->ctrl[1].x + w4 * c->end.x) * scale.x;
+        p[i].y = (w1 * c->begin.y + w2 * c->ctrl[0].y + w3 * c->ctrl[1].y + w4 * c->end.y) * scale.y;
+      }
+      nk_raster_shape_path(target, clip, NK_RASTER_SHAPE_PATH, p, segments + 1, nk_false,
+                           c->line_thickness * s * 0.5f, c->color, aa);
+    }
+    break;
+    case NK_COMMAND_RECT:
+    {
+      const struct nk_command_rect *c = (const struct nk_command_rect *)cmd;
+      nk_raster_shape_rect(target, clip,
+                           nk_rect(c->x * scale.x, c->y * scale.y, c->w * scale.x, c->h * scale.y),
+                           c->rounding * s, c->line_thickness * s * 0.5f, c->color, aa);
+    }
+    break;
+    case NK_COMMAND_RECT_FILLED:
+    {
+      const struct nk_command_rect_filled *c = (const struct nk_command_rect_filled *)cmd;
+      nk_raster_shape_rect(target, clip,
+                           nk_rect(c->x * scale.x, c->y * scale.y, c->w * scale.x, c->h * scale.y),
+                           c->rounding * s, -1.0f, c->color, aa);
+    }
+    break;
+    case NK_COMMAND_RECT_MULTI_COLOR:
+    {
+      const struct nk_command_rect_multi_color *c = (const struct nk_command_rect_multi_color *)cmd;
+      nk_raster_multi_color(target, clip,
+                            nk_rect(c->x * scale.x, c->y * scale.y, c->w * scale.x, c->h * scale.y),
+                            c->left, c->top, c->right, c->bottom);
+    }
+    break;
+    case NK_COMMAND_CIRCLE:
+    {
+      const struct nk_command_circle *c = (const struct nk_command_circle *)cmd;
+      nk_raster_shape_circle(target, clip,
+                             nk_vec2((c->x + c->w * 0.5f) * scale.x, (c->y + c->h * 0.5f) * scale.y),
+                             c->w * 0.5f * scale.x, c->line_thickness * s * 0.5f, c->color, aa);
+    }
+    break;
+    case NK_COMMAND_CIRCLE_FILLED:
+    {
+      const struct nk_command_circle_filled *c = (const struct nk_command_circle_filled *)cmd;
+      nk_raster_shape_circle(target, clip,
+                             nk_vec2((c->x + c->w * 0.5f) * scale.x, (c->y + c->h * 0.5f) * scale.y),
+                             c->w * 0.5f * scale.x, -1.0f, c->color, aa);
+    }
+    break;
+    case NK_COMMAND_ARC:
+    {
+      const struct nk_command_arc *c = (const struct nk_command_arc *)cmd;
+      nk_raster_shape_pie(target, clip, nk_vec2(c->cx * scale.x, c->cy * scale.y), c->r * scale.x,
+                          c->a, c->line_thickness * s * 0.5f, c->color, aa);
+    }
+    break;
+    case NK_COMMAND_ARC_FILLED:
+    {
+      const struct nk_command_arc_filled *c = (const struct nk_command_arc_filled *)cmd;
+      nk_raster_shape_pie(target, clip, nk_vec2(c->cx * scale.x, c->cy * scale.y), c->r * scale.x,
+                          c->a, -1.0f, c->color, aa);
+    }
+    break;
+    case NK_COMMAND_TRIANGLE:
+    {
+      const struct nk_command_triangle *c = (const struct nk_command_triangle *)cmd;
+      nk_raster_shape_points_cmd(target, clip, NK_RASTER_SHAPE_PATH, &c->a, 3, nk_true,
+                                 c->line_thickness * s * 0.5f, c->color, scale, aa);
+    }
+    break;
+    case NK_COMMAND_TRIANGLE_FILLED:
+    {
+      const struct nk_command_triangle_filled *c = (const struct nk_command_triangle_filled *)cmd;
+      nk_raster_shape_points_cmd(target, clip, NK_RASTER_SHAPE_CONVEX, &c->a, 3, nk_true, -1.0f,
+                                 c->color, scale, aa);
+    }
+    break;
+    case NK_COMMAND_POLYGON:
+    {
+      const struct nk_command_polygon *c = (const struct nk_command_polygon *)cmd;
+      nk_raster_shape_points_cmd(target, clip, NK_RASTER_SHAPE_PATH, c->points, c->point_count,
+                                 nk_true, c->line_thickness * s * 0.5f, c->color, scale, aa);
+    }
+    break;
+    case NK_COMMAND_POLYGON_FILLED:
+    {
+      const struct nk_command_polygon_filled *c = (const struct nk_command_polygon_filled *)cmd;
+      nk_raster_shape_points_cmd(target, clip, NK_RASTER_SHAPE_CONVEX, c->points, c->point_count,
+                                 nk_true, -1.0f, c->color, scale, aa);
+    }
+    break;
+    case NK_COMMAND_POLYLINE:
+    {
+      const struct nk_command_polyline *c = (const struct nk_command_polyline *)cmd;
+      nk_raster_shape_points_cmd(target, clip, NK_RASTER_SHAPE_PATH, c->points, c->point_count,
+                                 nk_false, c->line_thickness * s * 0.5f, c->color, scale, aa);
+    }
+    break;
+    case NK_COMMAND_TEXT:
+      nk_raster_text(target, clip, (const struct nk_command_text *)cmd, scale);
+      break;
+    case NK_COMMAND_IMAGE:
+    {
+      const struct nk_command_image *c = (const struct nk_command_image *)cmd;
+      struct nk_vec2 uv0 = nk_vec2(0.0f, 0.0f), uv1 = nk_vec2(1.0f, 1.0f);
+      if(nk_image_is_subimage(&c->img))
+      {
+        uv0 = nk_vec2((float)c->img.region[0] / (float)c->img.w,
+                      (float)c->img.region[1] / (float)c->img.h);
+        uv1 = nk_vec2((float)(c->img.region[0] + c->img.region[2]) / (float)c->img.w,
+                      (float)(c->img.region[1] + c->img.region[3]) / (float)c->img.h);
+      }
+      nk_raster_blit(target, clip, (const struct nk_raster_texture *)c->img.handle.ptr,
+                     nk_rect(c->x * scale.x, c->y * scale.y, c->w * scale.x, c->h * scale.y), uv0,
+                     uv1, c->col);
+    }
+    break;
+    default:
+      break;
+    }
+  }
+}
+
+NK_API void nk_raster_commands(struct nk_raster_target *target, struct nk_context *ctx,
+                               struct nk_vec2 scale, enum nk_anti_aliasing AA)
+{
+  int region[4];
+  region[0] = 0;
+  region[1] = 0;
+  region[2] = target->width;
+  region[3] = target->height;
+  nk_raster_command_stream(target, ctx, scale, AA == NK_ANTI_ALIASING_ON, region);
+}
+
+NK_INTERN void nk_raster_band_job(void *userdata, int band, int worker)
+{
+  struct nk_raster_tiler *tiler = (struct nk_raster_tiler *)userdata;
+  struct nk_raster_target *target = tiler->target;
+  struct nk_raster_target view;
+  int region[4];
+  (void)worker;
+
+  region[0] = 0;
+  region[1] = band * NK_RASTER_TILE_SIZE;
+  region[2] = target->width;
+  region[3] = NK_MIN(region[1] + NK_RASTER_TILE_SIZE, target->height);
+  if(!nk_raster_intersect(region, tiler->region))
+    return;
+
+  view.pixels = target->pixels + (size_t)region[1] * (size_t)target->pitch +
+                (size_t)region[0] * 4;
+  view.width = region[2] - region[0];
+  view.height = region[3] - region[1];
+  view.pitch = target->pitch;
+  nk_raster_clear(&view, tiler->clear);
+  nk_raster_command_stream(target, tiler->ctx, tiler->scale, tiler->AA == NK_ANTI_ALIASING_ON,
+                           region);
+}
+
+NK_API void nk_raster_commands_tiled(struct nk_raster_tiler *tiler, struct nk_raster_target *target,
+                                     struct nk_color clear, struct nk_context *ctx,
+                                     struct nk_vec2 scale, enum nk_anti_aliasing AA,
+                                     const struct nk_rect *region)
+{
+  tiler->target = target;
+  tiler->ctx = ctx;
+  tiler->scale = scale;
+  tiler->clear = clear;
+  tiler->AA = AA;
+  nk_raster_region(target, region, scale, tiler->region);
+  /* the first nk__begin sorts the windows into the command stream, do that before going wide */
+  nk__begin(ctx);
+  nk_job_pool_run(tiler->pool, (target->height + NK_RASTER_TILE_SIZE - 1) / NK_RASTER_TILE_SIZE,
+                  nk_raster_band_job, tiler);
+}
+
+#endif